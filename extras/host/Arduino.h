@@ -0,0 +1,151 @@
+/**
+ * @file Arduino.h
+ * @brief Minimal Arduino core emulation for building I2CMiniPrefs on a host
+ *
+ * Only the subset of the Arduino API used by the library and the host tools
+ * is provided. Time is simulated: delay() advances a virtual clock instead of
+ * sleeping, so millions of EEPROM write cycles replay in seconds.
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string>
+#include <type_traits>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+/// @name Simulated Time
+///@{
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+/**
+ * @brief Advance the virtual clock without blocking
+ * @param us Microseconds to add
+ */
+void hostAdvanceMicros(uint64_t us);
+
+/**
+ * @brief Current virtual time with 64-bit range
+ * @return Microseconds since program start
+ */
+uint64_t hostMicros64();
+///@}
+
+/// @name Digital Pins
+///@{
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+static const uint8_t SDA = 21; ///< Default I2C data pin (ESP32 DevKit)
+static const uint8_t SCL = 22; ///< Default I2C clock pin (ESP32 DevKit)
+
+/**
+ * @brief Configure a pin; open-drain lines read HIGH unless driven low
+ *
+ * Only the I2C lines are simulated: releasing SCL after driving it low
+ * clocks the simulated bus (see TwoWire::holdSda()).
+ */
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+///@}
+
+template<typename A, typename B>
+inline typename std::common_type<A, B>::type min(A a, B b) { return a < b ? a : b; }
+template<typename A, typename B>
+inline typename std::common_type<A, B>::type max(A a, B b) { return a > b ? a : b; }
+
+/**
+ * @class String
+ * @brief Subset of the Arduino String class backed by std::string
+ */
+class String {
+public:
+    String(const char* s = "") : _s(s ? s : "") {}
+    String(const std::string& s) : _s(s) {}
+    const char* c_str() const { return _s.c_str(); }
+    unsigned int length() const { return (unsigned int)_s.length(); }
+    bool operator==(const String& o) const { return _s == o._s; }
+    bool operator==(const char* o) const { return _s == (o ? o : ""); }
+    String& operator+=(const String& o) { _s += o._s; return *this; }
+    String& operator+=(const char* o) { _s += (o ? o : ""); return *this; }
+private:
+    std::string _s;
+};
+
+/**
+ * @class Print
+ * @brief Byte sink with Arduino-style print helpers
+ */
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t* buf, size_t len) {
+        size_t n = 0;
+        while (len--) n += write(*buf++);
+        return n;
+    }
+    size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t print(const String& s) { return print(s.c_str()); }
+    size_t print(long v) { char b[24]; snprintf(b, sizeof(b), "%ld", v); return print(b); }
+    size_t print(unsigned long v) { char b[24]; snprintf(b, sizeof(b), "%lu", v); return print(b); }
+    size_t print(int v) { return print((long)v); }
+    size_t print(unsigned int v) { return print((unsigned long)v); }
+    size_t print(double v, int digits = 2) { char b[40]; snprintf(b, sizeof(b), "%.*f", digits, v); return print(b); }
+    size_t println() { return print("\n"); }
+    template<typename T> size_t println(T v) { size_t n = print(v); return n + println(); }
+};
+
+/**
+ * @class Stream
+ * @brief Bidirectional byte stream as used by Serial and files
+ */
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    size_t readBytes(uint8_t* buf, size_t len) {
+        size_t n = 0;
+        while (n < len) {
+            int c = read();
+            if (c < 0) break;
+            buf[n++] = (uint8_t)c;
+        }
+        return n;
+    }
+    size_t readBytes(char* buf, size_t len) { return readBytes((uint8_t*)buf, len); }
+    void setTimeout(unsigned long) {}
+};
+
+/**
+ * @class HostSerial
+ * @brief Serial port replacement writing to stderr
+ */
+class HostSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    operator bool() const { return true; }
+    size_t write(uint8_t b) override { fputc(b, stderr); return 1; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+};
+extern HostSerial Serial;
@@ -0,0 +1,266 @@
+/**
+ * @file HostSim.cpp
+ * @brief Virtual clock, Serial, Wire and SimChip implementation for host builds
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#include "Arduino.h"
+#include "Wire.h"
+
+// Virtual Clock --------------------------------------------------------------
+
+static uint64_t g_hostMicros = 0;
+
+unsigned long millis() { return (unsigned long)(g_hostMicros / 1000); }
+unsigned long micros() { return (unsigned long)g_hostMicros; }
+void delay(unsigned long ms) { g_hostMicros += (uint64_t)ms * 1000; }
+void delayMicroseconds(unsigned int us) { g_hostMicros += us; }
+void hostAdvanceMicros(uint64_t us) { g_hostMicros += us; }
+uint64_t hostMicros64() { return g_hostMicros; }
+
+HostSerial Serial;
+
+// Digital Pins ---------------------------------------------------------------
+
+static uint8_t g_pinMode[256];
+static uint8_t g_pinLevel[256];
+
+/**
+ * @brief Whether the host actively drives a pin low
+ */
+static bool pinDrivenLow(uint8_t pin) {
+    return g_pinMode[pin] == OUTPUT && g_pinLevel[pin] == LOW;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    bool wasLow = pinDrivenLow(pin);
+    g_pinMode[pin] = mode;
+    if (wasLow && !pinDrivenLow(pin)) {
+        Wire.pinReleased(pin);
+        Wire1.pinReleased(pin);
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+    bool wasLow = pinDrivenLow(pin);
+    g_pinLevel[pin] = level;
+    if (wasLow && !pinDrivenLow(pin)) {
+        Wire.pinReleased(pin);
+        Wire1.pinReleased(pin);
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    return (pinDrivenLow(pin) || Wire.lineHeld(pin) || Wire1.lineHeld(pin)) ? LOW : HIGH;
+}
+
+// SimChip --------------------------------------------------------------------
+
+SimChip::SimChip(uint8_t address, uint32_t sizeBytes, bool isEeprom,
+                 uint16_t pageSize, uint32_t writeCycleUs)
+    : _address(address),
+      _isEeprom(isEeprom),
+      _pageSize(pageSize ? pageSize : 1),
+      _writeCycleUs(isEeprom ? writeCycleUs : 0),
+      _mem(sizeBytes, 0xFF),
+      _writes(sizeBytes, 0),
+      _totalWrites(0),
+      _pagePrograms(0),
+      _pointer(0),
+      _busyUntilUs(0),
+      _cutArmed(false),
+      _cutRemaining(0),
+      _powerLost(false)
+{
+}
+
+/**
+ * @brief Check whether the chip acknowledges its address
+ * @return false while an EEPROM write cycle runs or after a power cut
+ */
+bool SimChip::ready() const {
+    return !_powerLost && hostMicros64() >= _busyUntilUs;
+}
+
+/**
+ * @brief Program bytes at the current pointer
+ * @param data Bytes received after the two address bytes
+ * @param len Number of bytes
+ *
+ * EEPROMs wrap inside the addressed page, FRAMs increment linearly.
+ */
+void SimChip::program(const uint8_t* data, size_t len) {
+    uint32_t size = (uint32_t)_mem.size();
+    uint32_t pageStart = _pointer - (_pointer % _pageSize);
+    for (size_t i = 0; i < len; i++) {
+        if (_cutArmed) {
+            if (_cutRemaining == 0) {
+                _powerLost = true;
+                return;
+            }
+            _cutRemaining--;
+        }
+        uint32_t addr = _isEeprom ? pageStart + ((_pointer - pageStart + i) % _pageSize)
+                                  : (uint32_t)(_pointer + i);
+        addr %= size;
+        _mem[addr] = data[i];
+        _writes[addr]++;
+        _totalWrites++;
+    }
+    _pagePrograms++;
+    if (_isEeprom) _busyUntilUs = hostMicros64() + _writeCycleUs;
+    if (!_isEeprom) _pointer = (uint16_t)(_pointer + len);
+    if (_cutArmed && _cutRemaining == 0) _powerLost = true;
+}
+
+/**
+ * @brief Sequential read at the current pointer
+ * @return Byte read (pointer auto-increments)
+ */
+uint8_t SimChip::readNext() {
+    uint8_t value = _mem[_pointer % _mem.size()];
+    _pointer++;
+    return value;
+}
+
+void SimChip::fill(uint8_t value) {
+    for (size_t i = 0; i < _mem.size(); i++) _mem[i] = value;
+}
+
+uint32_t SimChip::maxByteWrites() const {
+    uint32_t m = 0;
+    for (size_t i = 0; i < _writes.size(); i++) if (_writes[i] > m) m = _writes[i];
+    return m;
+}
+
+void SimChip::resetWear() {
+    for (size_t i = 0; i < _writes.size(); i++) _writes[i] = 0;
+    _totalWrites = 0;
+    _pagePrograms = 0;
+}
+
+void SimChip::armPowerCut(uint64_t bytes) {
+    _cutArmed = bytes != 0;
+    _cutRemaining = bytes;
+}
+
+// TwoWire --------------------------------------------------------------------
+
+TwoWire Wire;
+TwoWire Wire1;
+
+TwoWire::TwoWire()
+    : _chipCount(0), _clockHz(100000), _txAddress(0), _txLen(0),
+      _rxLen(0), _rxPos(0), _transactions(0), _bytesOnBus(0),
+      _timeoutUs(50000), _sdaPin(SDA), _sclPin(SCL), _sdaHeldClocks(0)
+{
+}
+
+void TwoWire::begin() {
+    _sdaPin = SDA;
+    _sclPin = SCL;
+}
+
+void TwoWire::begin(int sdaPin, int sclPin) {
+    _sdaPin = (uint8_t)sdaPin;
+    _sclPin = (uint8_t)sclPin;
+}
+
+/**
+ * @brief Count an SCL pulse towards releasing a held SDA line
+ * @param pin Pin that went from driven-low to released
+ */
+void TwoWire::pinReleased(uint8_t pin) {
+    if (pin == _sclPin && _sdaHeldClocks > 0) _sdaHeldClocks--;
+}
+
+void TwoWire::attach(SimChip* chip) {
+    if (_chipCount < sizeof(_chips) / sizeof(_chips[0])) _chips[_chipCount++] = chip;
+}
+
+void TwoWire::detachAll() { _chipCount = 0; }
+
+SimChip* TwoWire::_chipAt(uint8_t address) {
+    for (uint8_t i = 0; i < _chipCount; i++) {
+        if (_chips[i]->address() == address) return _chips[i];
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Account bus time for a number of clocked bytes
+ * @param count Bytes including the address byte
+ *
+ * Each byte takes nine SCL periods (eight data bits plus ACK), plus one
+ * period for START/STOP per transaction.
+ */
+void TwoWire::_clockBytes(size_t count) {
+    _bytesOnBus += count;
+    hostAdvanceMicros(((uint64_t)count * 9 + 1) * 1000000ULL / _clockHz);
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    _txAddress = address;
+    _txLen = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (_txLen >= sizeof(_txBuf)) return 0;
+    _txBuf[_txLen++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t len) {
+    size_t n = 0;
+    while (n < len && write(data[n])) n++;
+    return n;
+}
+
+/**
+ * @brief Finish a write transaction
+ * @return 0 on success, 2 on address NACK, 5 on timeout (as Arduino Wire)
+ */
+uint8_t TwoWire::endTransmission(bool) {
+    _transactions++;
+    if (_sdaHeldClocks > 0) {
+        hostAdvanceMicros(_timeoutUs);
+        return 5;
+    }
+    SimChip* chip = _chipAt(_txAddress);
+    if (!chip || !chip->ready()) {
+        _clockBytes(1);
+        return 2;
+    }
+    _clockBytes(1 + _txLen);
+    if (_txLen >= 2) {
+        chip->setPointer((uint16_t)((_txBuf[0] << 8) | _txBuf[1]));
+        if (_txLen > 2) chip->program(_txBuf + 2, _txLen - 2);
+    }
+    return 0;
+}
+
+/**
+ * @brief Read bytes from the addressed chip
+ * @return Number of bytes received (0 on NACK)
+ */
+uint8_t TwoWire::requestFrom(uint8_t address, size_t quantity, bool) {
+    _transactions++;
+    _rxLen = 0;
+    _rxPos = 0;
+    if (_sdaHeldClocks > 0) {
+        hostAdvanceMicros(_timeoutUs);
+        return 0;
+    }
+    SimChip* chip = _chipAt(address);
+    if (!chip || !chip->ready()) {
+        _clockBytes(1);
+        return 0;
+    }
+    if (quantity > sizeof(_rxBuf)) quantity = sizeof(_rxBuf);
+    for (size_t i = 0; i < quantity; i++) _rxBuf[_rxLen++] = chip->readNext();
+    _clockBytes(1 + quantity);
+    return (uint8_t)_rxLen;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file PrefsColdStdio.h
+ * @brief Cold tier backend on a host file, for the simulation tools
+ *
+ * Host counterpart of PrefsColdFile: replacements are written to
+ * "<path>.tmp" and renamed over the image, which POSIX rename() does
+ * atomically.
+ * @code
+ * PrefsColdStdio coldBackend("cold.bin");
+ * PrefsColdTier cold(coldBackend);
+ * cold.begin();
+ * prefs.setColdTier(&cold, 4);
+ * @endcode
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#pragma once
+#include <stdio.h>
+#include <string>
+#include "I2CMiniPrefsCold.h"
+
+/**
+ * @class PrefsColdStdio
+ * @brief Cold image as a stdio file
+ */
+class PrefsColdStdio : public PrefsColdBackend {
+public:
+    /**
+     * @param path Image path, e.g. "cold.bin"
+     */
+    explicit PrefsColdStdio(const char* path)
+        : _path(path), _tmpPath(std::string(path) + ".tmp"), _in(nullptr), _out(nullptr) {}
+
+    ~PrefsColdStdio() {
+        abort();
+        if (_in) fclose(_in);
+    }
+
+    size_t size() override {
+        if (!_in) _in = fopen(_path.c_str(), "rb");
+        if (!_in || fseek(_in, 0, SEEK_END) != 0) return 0;
+        long len = ftell(_in);
+        return len > 0 ? (size_t)len : 0;
+    }
+
+    size_t read(uint32_t offset, byte* buf, size_t len) override {
+        if (!_in && size() == 0) return 0;
+        if (fseek(_in, offset, SEEK_SET) != 0) return 0;
+        return fread(buf, 1, len, _in);
+    }
+
+    bool beginWrite() override {
+        abort();
+        _out = fopen(_tmpPath.c_str(), "wb");
+        return _out != nullptr;
+    }
+
+    bool write(const byte* data, size_t len) override {
+        return _out && fwrite(data, 1, len, _out) == len;
+    }
+
+    bool commit() override {
+        if (!_out) return false;
+        bool ok = fclose(_out) == 0;
+        _out = nullptr;
+        if (_in) {
+            fclose(_in);
+            _in = nullptr;
+        }
+        return ok && rename(_tmpPath.c_str(), _path.c_str()) == 0;
+    }
+
+    void abort() override {
+        if (!_out) return;
+        fclose(_out);
+        _out = nullptr;
+        remove(_tmpPath.c_str());
+    }
+
+private:
+    std::string _path;           ///< Image path
+    std::string _tmpPath;        ///< Replacement path
+    FILE* _in;                   ///< Open image (kept between reads)
+    FILE* _out;                  ///< Open replacement
+};
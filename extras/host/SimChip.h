@@ -0,0 +1,89 @@
+/**
+ * @file SimChip.h
+ * @brief Simulated I2C FRAM/EEPROM chip with wear accounting
+ *
+ * Models the parts of a 24xx EEPROM / MB85RC FRAM that matter to the storage
+ * engine: two-byte addressing, page-wrapping writes, the EEPROM write cycle
+ * (device NACKs while programming) and per-byte program counters.
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/**
+ * @class SimChip
+ * @brief Byte-addressable memory behind a simulated I2C slave
+ */
+class SimChip {
+public:
+    /**
+     * @brief Construct a simulated chip
+     * @param address I2C slave address
+     * @param sizeBytes Memory size in bytes
+     * @param isEeprom true for EEPROM timing, false for FRAM
+     * @param pageSize Page size in bytes (write wrap boundary)
+     * @param writeCycleUs EEPROM internal write cycle time
+     */
+    SimChip(uint8_t address, uint32_t sizeBytes, bool isEeprom,
+            uint16_t pageSize = 64, uint32_t writeCycleUs = 5000);
+
+    uint8_t address() const { return _address; }
+    uint32_t size() const { return (uint32_t)_mem.size(); }
+    bool isEeprom() const { return _isEeprom; }
+    uint16_t pageSize() const { return _pageSize; }
+
+    /// @name Bus Interface (called by TwoWire)
+    ///@{
+    bool ready() const;
+    void setPointer(uint16_t address) { _pointer = address; }
+    void program(const uint8_t* data, size_t len);
+    uint8_t readNext();
+    ///@}
+
+    /// @name Image Access
+    ///@{
+    uint8_t* data() { return _mem.data(); }
+    void fill(uint8_t value);
+    ///@}
+
+    /// @name Wear Accounting
+    ///@{
+    const std::vector<uint32_t>& byteWrites() const { return _writes; }
+    uint64_t totalByteWrites() const { return _totalWrites; }
+    uint64_t pagePrograms() const { return _pagePrograms; }
+    uint32_t maxByteWrites() const;
+    void resetWear();
+    ///@}
+
+    /// @name Power-Cut Injection
+    ///@{
+    /**
+     * @brief Lose power after the given number of further programmed bytes
+     * @param bytes Bytes still committed before the cut (0 disarms)
+     */
+    void armPowerCut(uint64_t bytes);
+    bool powerLost() const { return _powerLost; }
+    void powerOn() { _powerLost = false; _cutArmed = false; _busyUntilUs = 0; }
+    ///@}
+
+private:
+    uint8_t _address;
+    bool _isEeprom;
+    uint16_t _pageSize;
+    uint32_t _writeCycleUs;
+    std::vector<uint8_t> _mem;
+    std::vector<uint32_t> _writes;
+    uint64_t _totalWrites;
+    uint64_t _pagePrograms;
+    uint16_t _pointer;
+    uint64_t _busyUntilUs;
+    bool _cutArmed;
+    uint64_t _cutRemaining;
+    bool _powerLost;
+};
@@ -0,0 +1,265 @@
+/**
+ * @file TraceReplay.h
+ * @brief Workload traces for the host tools (text traces and synthetic mixes)
+ *
+ * Text trace format, one operation per line ('#' starts a comment):
+ * @code
+ * put <key> <valueSize>
+ * get <key>
+ * remove <key>
+ * clear
+ * @endcode
+ *
+ * Binary dumps produced by I2CMiniPrefs::dumpTrace() are replayed directly;
+ * keys are named after their recorded hash ("h1a2b").
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "I2CMiniPrefs.h"
+
+/**
+ * @enum TraceOpKind
+ * @brief Operations that can be replayed
+ */
+enum TraceOpKind : uint8_t {
+    TRACE_OP_PUT,
+    TRACE_OP_GET,
+    TRACE_OP_REMOVE,
+    TRACE_OP_CLEAR
+};
+
+/**
+ * @struct TraceOp
+ * @brief One replayable operation
+ */
+struct TraceOp {
+    TraceOpKind kind;
+    std::string key;
+    uint16_t valueSize;
+};
+
+/**
+ * @class TraceSource
+ * @brief Produces operations one at a time
+ */
+class TraceSource {
+public:
+    virtual ~TraceSource() {}
+    virtual bool next(TraceOp& op) = 0;
+
+    /**
+     * @brief Operation rate observed while recording
+     * @return Operations per second, 0 if the source carries no timing
+     */
+    virtual double observedRate() const { return 0; }
+};
+
+/**
+ * @class TextTraceSource
+ * @brief Reads a text trace, optionally looping until an operation budget is met
+ */
+class TextTraceSource : public TraceSource {
+public:
+    TextTraceSource(FILE* file, uint64_t maxOps, bool loop)
+        : _file(file), _maxOps(maxOps), _loop(loop), _emitted(0) {}
+
+    bool next(TraceOp& op) override {
+        if (_maxOps && _emitted >= _maxOps) return false;
+        char line[256];
+        for (;;) {
+            if (!fgets(line, sizeof(line), _file)) {
+                if (!_loop || _emitted == 0) return false;
+                rewind(_file);
+                continue;
+            }
+            char verb[16], key[128] = "";
+            unsigned size = 0;
+            int n = sscanf(line, "%15s %127s %u", verb, key, &size);
+            if (n < 1 || verb[0] == '#') continue;
+            op.valueSize = 0;
+            if (strcmp(verb, "put") == 0 && n == 3) {
+                op.kind = TRACE_OP_PUT;
+                op.valueSize = (uint16_t)size;
+            } else if (strcmp(verb, "get") == 0 && n >= 2) {
+                op.kind = TRACE_OP_GET;
+            } else if (strcmp(verb, "remove") == 0 && n >= 2) {
+                op.kind = TRACE_OP_REMOVE;
+            } else if (strcmp(verb, "clear") == 0) {
+                op.kind = TRACE_OP_CLEAR;
+            } else {
+                continue;
+            }
+            op.key = key;
+            _emitted++;
+            return true;
+        }
+    }
+
+private:
+    FILE* _file;
+    uint64_t _maxOps;
+    bool _loop;
+    uint64_t _emitted;
+};
+
+/**
+ * @class BinaryTraceSource
+ * @brief Replays a dump written by I2CMiniPrefs::dumpTrace()
+ *
+ * Several dumps may be concatenated in one file (e.g. periodic dumps
+ * captured from Serial). GC records are skipped because the engine decides
+ * on its own when to collect.
+ */
+class BinaryTraceSource : public TraceSource {
+public:
+    BinaryTraceSource(FILE* file, uint64_t maxOps, bool loop)
+        : _file(file), _maxOps(maxOps), _loop(loop), _emitted(0),
+          _remaining(0), _recordSize(0), _firstUs(0), _lastUs(0), _timed(0),
+          _rewound(false) {}
+
+    /**
+     * @brief Check whether a file starts with a trace dump header
+     */
+    static bool probe(FILE* file) {
+        char magic[4];
+        bool match = fread(magic, 1, 4, file) == 4 && memcmp(magic, PREFS_TRACE_MAGIC, 4) == 0;
+        rewind(file);
+        return match;
+    }
+
+    bool next(TraceOp& op) override {
+        if (_maxOps && _emitted >= _maxOps) return false;
+        for (;;) {
+            if (_remaining == 0 && !_readHeader()) {
+                if (!_loop || _emitted == 0) return false;
+                rewind(_file);
+                _rewound = true;
+                continue;
+            }
+            uint8_t raw[64];
+            if (_recordSize > sizeof(raw) || fread(raw, 1, _recordSize, _file) != _recordSize) {
+                _remaining = 0;
+                continue;
+            }
+            _remaining--;
+            PrefsTraceRecord rec;
+            memcpy(&rec, raw, sizeof(rec));
+            if (!_rewound) {
+                if (_timed++ == 0) _firstUs = rec.timestampUs;
+                _lastUs = rec.timestampUs;
+            }
+
+            char key[8];
+            snprintf(key, sizeof(key), "h%04x", rec.keyHash);
+            op.key = key;
+            op.valueSize = rec.valueSize;
+            switch (rec.op) {
+                case PREFS_TRACE_PUT:    op.kind = TRACE_OP_PUT; break;
+                case PREFS_TRACE_GET:
+                case PREFS_TRACE_IS_KEY: op.kind = TRACE_OP_GET; break;
+                case PREFS_TRACE_REMOVE: op.kind = TRACE_OP_REMOVE; break;
+                case PREFS_TRACE_CLEAR:  op.kind = TRACE_OP_CLEAR; break;
+                default: continue;
+            }
+            _emitted++;
+            return true;
+        }
+    }
+
+    double observedRate() const override {
+        uint32_t span = _lastUs - _firstUs;
+        return (_timed > 1 && span) ? (_timed - 1) * 1e6 / span : 0;
+    }
+
+private:
+    bool _readHeader() {
+        uint8_t h[12];
+        if (fread(h, 1, sizeof(h), _file) != sizeof(h)) return false;
+        if (memcmp(h, PREFS_TRACE_MAGIC, 4) != 0 || h[4] != PREFS_TRACE_VERSION ||
+            h[5] < sizeof(PrefsTraceRecord)) return false;
+        _recordSize = h[5];
+        _remaining = (uint16_t)(h[6] | (h[7] << 8));
+        return true;
+    }
+
+    FILE* _file;
+    uint64_t _maxOps;
+    bool _loop;
+    uint64_t _emitted;
+    uint16_t _remaining;
+    uint8_t _recordSize;
+    uint32_t _firstUs;
+    uint32_t _lastUs;
+    uint64_t _timed;
+    bool _rewound;
+};
+
+/**
+ * @class SyntheticTraceSource
+ * @brief Random put/remove mix over a fixed key population
+ *
+ * hotPercent of the operations go to the first tenth of the keys, which
+ * models the counter-style workloads the library is used for.
+ */
+class SyntheticTraceSource : public TraceSource {
+public:
+    SyntheticTraceSource(uint64_t ops, uint32_t keys, uint16_t valueSize,
+                         uint8_t removePercent, uint8_t hotPercent, uint32_t seed)
+        : _ops(ops), _keys(keys ? keys : 1), _valueSize(valueSize),
+          _removePercent(removePercent), _hotPercent(hotPercent),
+          _state(seed ? seed : 1), _emitted(0) {}
+
+    bool next(TraceOp& op) override {
+        if (_emitted >= _ops) return false;
+        uint32_t hotKeys = _keys / 10 ? _keys / 10 : 1;
+        uint32_t k = (_rand() % 100 < _hotPercent) ? _rand() % hotKeys : _rand() % _keys;
+        char key[16];
+        snprintf(key, sizeof(key), "k%u", (unsigned)k);
+        op.key = key;
+        if (_rand() % 100 < _removePercent) {
+            op.kind = TRACE_OP_REMOVE;
+            op.valueSize = 0;
+        } else {
+            op.kind = TRACE_OP_PUT;
+            op.valueSize = _valueSize;
+        }
+        _emitted++;
+        return true;
+    }
+
+private:
+    uint32_t _rand() {
+        // xorshift32: deterministic across platforms for reproducible runs
+        _state ^= _state << 13;
+        _state ^= _state >> 17;
+        _state ^= _state << 5;
+        return _state;
+    }
+
+    uint64_t _ops;
+    uint32_t _keys;
+    uint16_t _valueSize;
+    uint8_t _removePercent;
+    uint8_t _hotPercent;
+    uint32_t _state;
+    uint64_t _emitted;
+};
+
+/**
+ * @brief Deterministic value payload for an operation
+ * @param seq Operation sequence number
+ * @param buf Output buffer
+ * @param len Payload length
+ */
+inline void traceFillValue(uint64_t seq, uint8_t* buf, size_t len) {
+    for (size_t i = 0; i < len; i++) buf[i] = (uint8_t)((seq * 131 + i * 7) & 0xFF);
+}
@@ -0,0 +1,100 @@
+/**
+ * @file Wire.h
+ * @brief Simulated I2C bus for building I2CMiniPrefs on a host
+ *
+ * TwoWire mirrors the Arduino Wire API and routes transactions to SimChip
+ * instances attached at their I2C addresses. Transfers advance the virtual
+ * clock according to the configured bus speed.
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#pragma once
+#include "Arduino.h"
+#include "SimChip.h"
+
+#define WIRE_HAS_TIMEOUT ///< setWireTimeout() as in the AVR core
+
+#ifndef I2C_BUFFER_LENGTH
+#define I2C_BUFFER_LENGTH 128 ///< Matches the ESP32 Arduino core default
+#endif
+
+/**
+ * @class TwoWire
+ * @brief Host replacement for the Arduino I2C master
+ */
+class TwoWire : public Stream {
+public:
+    TwoWire();
+
+    void begin();
+    void begin(int sdaPin, int sclPin);
+    void end() {}
+    void setClock(uint32_t hz) { _clockHz = hz; }
+    void setWireTimeout(uint32_t timeoutUs, bool) { _timeoutUs = timeoutUs; }
+
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* data, size_t len) override;
+    uint8_t endTransmission(bool sendStop = true);
+
+    uint8_t requestFrom(uint8_t address, size_t quantity, bool sendStop = true);
+    int available() override { return (int)(_rxLen - _rxPos); }
+    int read() override { return _rxPos < _rxLen ? _rxBuf[_rxPos++] : -1; }
+    int peek() override { return _rxPos < _rxLen ? _rxBuf[_rxPos] : -1; }
+
+    /// @name Simulation Control
+    ///@{
+    /**
+     * @brief Attach a simulated chip to the bus
+     * @param chip Chip answering at chip->address()
+     */
+    void attach(SimChip* chip);
+
+    /**
+     * @brief Detach all simulated chips
+     */
+    void detachAll();
+
+    uint64_t transactions() const { return _transactions; } ///< Started transactions
+    uint64_t bytesOnBus() const { return _bytesOnBus; }     ///< Bytes clocked incl. address bytes
+    void resetCounters() { _transactions = 0; _bytesOnBus = 0; }
+
+    /**
+     * @brief Let a slave hold SDA low as after a brownout mid-byte
+     * @param clocks SCL pulses it needs before it releases the line
+     *
+     * While SDA is held every transfer times out (result 5 after the
+     * configured timeout).
+     */
+    void holdSda(uint8_t clocks) { _sdaHeldClocks = clocks; }
+
+    bool lineHeld(uint8_t pin) const { return pin == _sdaPin && _sdaHeldClocks > 0; }
+    void pinReleased(uint8_t pin);  ///< Called by the pin shim on a rising edge
+    ///@}
+
+private:
+    SimChip* _chipAt(uint8_t address);
+    void _clockBytes(size_t count);
+
+    SimChip* _chips[8];
+    uint8_t _chipCount;
+    uint32_t _clockHz;
+    uint8_t _txAddress;
+    uint8_t _txBuf[I2C_BUFFER_LENGTH];
+    size_t _txLen;
+    uint8_t _rxBuf[I2C_BUFFER_LENGTH];
+    size_t _rxLen;
+    size_t _rxPos;
+    uint64_t _transactions;
+    uint64_t _bytesOnBus;
+    uint32_t _timeoutUs;
+    uint8_t _sdaPin;
+    uint8_t _sclPin;
+    uint8_t _sdaHeldClocks;
+};
+extern TwoWire Wire;
+extern TwoWire Wire1;  ///< Second controller as on ESP32
@@ -0,0 +1,312 @@
+/**
+ * @file powercut.cpp
+ * @brief Crash-consistency harness for the I2CMiniPrefs commit path
+ *
+ * Runs fuzzed put/remove workloads against the engine on a SimChip. Every
+ * operation is first executed normally to learn how many bytes it programs,
+ * then replayed from the same starting image with a simulated power cut
+ * after every Nth programmed byte. After each cut the chip is remounted with
+ * a fresh instance and compared against a std::map reference model:
+ *
+ * - keys not touched by the interrupted operation must be unchanged
+ * - the touched key must hold either its old or its new value
+ * - the remounted store must accept a further write, also to the touched key
+ *
+ * With --async-pct that share of the puts is queued with putAsync() and
+ * driven by poll(), so the cut points cover the asynchronous commit and
+ * garbage collection steps as well.
+ *
+ * @code
+ * powercut [--mem eeprom|fram] [--size-kbit 16] [--block 256] [--max-key 8]
+ *          [--max-value 24] [--ops 200] [--keys 6] [--remove-pct 15]
+ *          [--async-pct 0] [--every 1] [--seed 1] [--runs 1] [--keep-going]
+ * @endcode
+ *
+ * Each inconsistent operation is reported once with its first failing cut
+ * point. Without --keep-going the run stops at the first violation. Exit
+ * status is 0 when no violation was found.
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "I2CMiniPrefs.h"
+
+typedef std::map<std::string, std::vector<uint8_t> > Model;
+
+/**
+ * @struct CutOptions
+ * @brief Command line configuration
+ */
+struct CutOptions {
+    bool eeprom = false;
+    uint32_t sizeKbit = 16;
+    uint16_t blockSize = 256;
+    uint8_t maxKey = 8;
+    uint16_t maxValue = 24;
+    uint32_t ops = 200;
+    uint32_t keys = 6;
+    uint8_t removePct = 15;
+    uint8_t asyncPct = 0;
+    uint32_t every = 1;
+    uint32_t seed = 1;
+    uint32_t runs = 1;
+    bool keepGoing = false;
+};
+
+/**
+ * @struct FuzzOp
+ * @brief One generated operation
+ */
+struct FuzzOp {
+    bool remove;
+    bool async;
+    std::string key;
+    std::vector<uint8_t> value;
+};
+
+static uint32_t g_rng = 1;
+
+static uint32_t fuzzRand() {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static bool parseArgs(int argc, char** argv, CutOptions& o) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (strcmp(a, "--keep-going") == 0) { o.keepGoing = true; continue; }
+        if (i + 1 >= argc) return false;
+        const char* v = argv[++i];
+        if      (strcmp(a, "--mem") == 0)        o.eeprom = strcmp(v, "eeprom") == 0;
+        else if (strcmp(a, "--size-kbit") == 0)  o.sizeKbit = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--block") == 0)      o.blockSize = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--max-key") == 0)    o.maxKey = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--max-value") == 0)  o.maxValue = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--ops") == 0)        o.ops = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--keys") == 0)       o.keys = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--remove-pct") == 0) o.removePct = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--async-pct") == 0)  o.asyncPct = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--every") == 0)      o.every = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--seed") == 0)       o.seed = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--runs") == 0)       o.runs = strtoul(v, nullptr, 0);
+        else return false;
+    }
+    if (o.every == 0) o.every = 1;
+    if (o.keys == 0) o.keys = 1;
+    return true;
+}
+
+static FuzzOp makeOp(const CutOptions& o) {
+    FuzzOp op;
+    char key[16];
+    snprintf(key, sizeof(key), "k%u", (unsigned)(fuzzRand() % o.keys));
+    op.key = key;
+    op.remove = fuzzRand() % 100 < o.removePct;
+    // Drawn only when enabled, so the default workloads stay the same
+    op.async = !op.remove && o.asyncPct > 0 && fuzzRand() % 100 < o.asyncPct;
+    if (!op.remove) {
+        op.value.resize(1 + fuzzRand() % o.maxValue);
+        for (size_t i = 0; i < op.value.size(); i++) op.value[i] = (uint8_t)fuzzRand();
+    }
+    return op;
+}
+
+static I2CMiniPrefs* mount(const CutOptions& o) {
+    I2CMiniPrefs* p = new I2CMiniPrefs(o.eeprom ? MEM_TYPE_EEPROM : MEM_TYPE_FRAM, 0x50,
+                                       o.sizeKbit * 1024, o.blockSize, o.maxKey, o.maxValue);
+    if (!p->begin()) {
+        delete p;
+        return nullptr;
+    }
+    return p;
+}
+
+static bool apply(I2CMiniPrefs& p, const FuzzOp& op) {
+    if (op.remove) return p.remove(op.key.c_str()) || !p.isKey(op.key.c_str());
+    if (!op.async) return p.putBytes(op.key.c_str(), op.value.data(), op.value.size());
+
+    PrefsAsyncHandle handle = p.putAsync(op.key.c_str(), TYPE_BYTES, op.value.data(),
+                                         op.value.size());
+    while (p.poll()) delayMicroseconds(100);
+    return p.asyncStatus(handle) == PREFS_ASYNC_DONE;
+}
+
+/**
+ * @brief Read one key back from the store
+ * @return true if present; value holds its bytes
+ */
+static bool readKey(I2CMiniPrefs& p, const std::string& key, std::vector<uint8_t>& value) {
+    uint8_t buf[256];
+    if (!p.isKey(key.c_str())) return false;
+    size_t n = p.getBytes(key.c_str(), buf, sizeof(buf));
+    value.assign(buf, buf + n);
+    return true;
+}
+
+static std::string describe(bool present, const std::vector<uint8_t>& v) {
+    if (!present) return "<absent>";
+    char b[16];
+    snprintf(b, sizeof(b), "%zu bytes", v.size());
+    return b;
+}
+
+/**
+ * @brief Check a remounted store against the model
+ * @param before Model before the interrupted operation
+ * @param after Model had the operation completed
+ * @param touched Key of the interrupted operation
+ * @param why Description of the first violation
+ * @return true if consistent
+ */
+static bool verify(I2CMiniPrefs& p, const CutOptions& o, const Model& before,
+                   const Model& after, const std::string& touched, std::string& why) {
+    for (uint32_t k = 0; k < o.keys; k++) {
+        char key[16];
+        snprintf(key, sizeof(key), "k%u", (unsigned)k);
+        std::vector<uint8_t> got;
+        bool present = readKey(p, key, got);
+
+        Model::const_iterator b = before.find(key);
+        Model::const_iterator a = after.find(key);
+        bool okBefore = (b == before.end()) ? !present : (present && got == b->second);
+        bool okAfter = (a == after.end()) ? !present : (present && got == a->second);
+        if (okBefore || (key == touched && okAfter)) continue;
+
+        why = std::string(key) + ": found " + describe(present, got) + ", expected " +
+              describe(b != before.end(), b != before.end() ? b->second : got);
+        if (key == touched) {
+            why += " or " + describe(a != after.end(), a != after.end() ? a->second : got);
+        }
+        return false;
+    }
+    const uint8_t probe = 0x5A;
+    if (!p.putBytes("probe", &probe, 1) || !p.remove("probe")) {
+        why = "store not writable after remount";
+        return false;
+    }
+    // A left-over older copy of the touched key would hide this write
+    std::vector<uint8_t> got;
+    if (!p.putBytes(touched.c_str(), &probe, 1) || !readKey(p, touched, got) ||
+        got.size() != 1 || got[0] != probe) {
+        why = touched + ": rewrite after remount not read back";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Run one fuzzed workload with power cuts
+ * @return Number of violations found
+ */
+static uint32_t runWorkload(const CutOptions& o, SimChip& chip, uint64_t& cuts) {
+    chip.fill(0xFF);
+    chip.powerOn();
+    I2CMiniPrefs* ref = mount(o);
+    if (!ref) {
+        printf("seed %u: initial begin() failed\n", (unsigned)o.seed);
+        return 1;
+    }
+
+    Model model;
+    uint32_t violations = 0;
+    std::vector<uint8_t> pre(chip.size()), post(chip.size());
+
+    for (uint32_t i = 0; i < o.ops; i++) {
+        FuzzOp op = makeOp(o);
+        memcpy(pre.data(), chip.data(), chip.size());
+        uint64_t startBytes = chip.totalByteWrites();
+        bool ok = apply(*ref, op);
+        uint64_t opBytes = chip.totalByteWrites() - startBytes;
+        memcpy(post.data(), chip.data(), chip.size());
+
+        Model after = model;
+        if (ok) {
+            if (op.remove) after.erase(op.key);
+            else after[op.key] = op.value;
+        }
+
+        uint32_t opViolations = 0;
+        std::string firstWhy;
+        uint64_t firstCut = 0;
+        for (uint64_t cut = o.every; cut < opBytes; cut += o.every) {
+            memcpy(chip.data(), pre.data(), chip.size());
+            chip.powerOn();
+            I2CMiniPrefs* victim = mount(o);
+            if (!victim) continue;
+            chip.armPowerCut(cut);
+            apply(*victim, op);
+            delete victim;
+            chip.powerOn();
+            cuts++;
+
+            std::string why;
+            I2CMiniPrefs* remounted = mount(o);
+            bool consistent = remounted && verify(*remounted, o, model, after, op.key, why);
+            if (!remounted) why = "begin() failed after power cut";
+            delete remounted;
+            if (!consistent) {
+                if (opViolations++ == 0) {
+                    firstWhy = why;
+                    firstCut = cut;
+                }
+                if (!o.keepGoing) break;
+            }
+        }
+
+        if (opViolations) {
+            violations += opViolations;
+            printf("seed %u op %u (%s %s) cut after %llu/%llu bytes: %s",
+                   (unsigned)o.seed, (unsigned)i, op.remove ? "remove" : "put",
+                   op.key.c_str(), (unsigned long long)firstCut,
+                   (unsigned long long)opBytes, firstWhy.c_str());
+            if (opViolations > 1) printf(" (+%u more cut points)", (unsigned)(opViolations - 1));
+            printf("\n");
+            if (!o.keepGoing) {
+                delete ref;
+                return violations;
+            }
+        }
+
+        memcpy(chip.data(), post.data(), chip.size());
+        chip.powerOn();
+        if (ok) model = after;
+    }
+    delete ref;
+    return violations;
+}
+
+int main(int argc, char** argv) {
+    CutOptions o;
+    if (!parseArgs(argc, argv, o)) {
+        fprintf(stderr,
+            "usage: powercut [--mem eeprom|fram] [--size-kbit N] [--block N] [--max-key N]\n"
+            "                [--max-value N] [--ops N] [--keys N] [--remove-pct P]\n"
+            "                [--async-pct P] [--every N] [--seed N] [--runs N] [--keep-going]\n");
+        return 2;
+    }
+
+    SimChip chip(0x50, o.sizeKbit * 1024 / 8, o.eeprom);
+    Wire.attach(&chip);
+
+    uint32_t violations = 0;
+    uint64_t cuts = 0;
+    uint32_t firstSeed = o.seed;
+    for (uint32_t r = 0; r < o.runs; r++) {
+        o.seed = firstSeed + r;
+        g_rng = o.seed ? o.seed : 1;
+        violations += runWorkload(o, chip, cuts);
+        if (violations && !o.keepGoing) break;
+    }
+    printf("%llu power cuts checked, %u violation(s)\n", (unsigned long long)cuts, (unsigned)violations);
+    return violations ? 1 : 0;
+}
@@ -0,0 +1,578 @@
+/**
+ * @file prefs_image.cpp
+ * @brief Host image tool: mkfs, build from manifest, inspect and dump
+ *
+ * Images are produced by the real storage engine running on a SimChip, so
+ * they are bit-identical to what a device would write. A provisioning
+ * station then programs the image in one sequential page-burst pass
+ * instead of issuing one put*() per key on every board.
+ *
+ * @code
+ * prefs_image mkfs    -o image.bin [layout]
+ * prefs_image build   manifest.txt -o image.bin [layout] [--target esp32|avr]
+ *                     [--format bin|c] [--trim]
+ * prefs_image inspect image.bin [layout] [--target esp32|avr]
+ * prefs_image dump    image.bin [layout] [--target esp32|avr]
+ *
+ * layout: [--mem eeprom|fram] [--size-kbit 256] [--block 256]
+ *         [--max-key 16] [--max-value 240]
+ * @endcode
+ *
+ * Manifest lines are "<key> <type> <value>" where type is one of bool, char,
+ * uchar, short, ushort, int, uint, long, ulong, long64, ulong64, float,
+ * double, string (rest of line, optionally quoted) or bytes (hex digits).
+ * A later line for the same key replaces the earlier one.
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "I2CMiniPrefs.h"
+
+/**
+ * @struct TargetAbi
+ * @brief Sizes of the C types on the device the image is built for
+ */
+struct TargetAbi {
+    const char* name;
+    uint8_t shortSize;
+    uint8_t intSize;
+    uint8_t longSize;
+    uint8_t doubleSize;
+    uint8_t headerAlign;   ///< Alignment of the uint16_t header fields
+};
+
+static const TargetAbi kTargets[] = {
+    { "esp32", 2, 4, 4, 8, 2 },  // also ARM Cortex-M, RP2040
+    { "avr",   2, 2, 4, 4, 1 },
+};
+
+/**
+ * @struct ImageOptions
+ * @brief Command line configuration
+ */
+struct ImageOptions {
+    bool eeprom = true;
+    uint32_t sizeKbit = 256;
+    uint16_t blockSize = 256;
+    uint8_t maxKey = 16;
+    uint16_t maxValue = 240;
+    const TargetAbi* target = &kTargets[0];
+    const char* output = nullptr;
+    bool cFormat = false;
+    bool trim = false;
+    std::vector<const char*> positional;
+};
+
+/**
+ * @struct ManifestEntry
+ * @brief One parsed manifest line in target representation
+ */
+struct ManifestEntry {
+    std::string key;
+    PrefDataType type;
+    std::vector<uint8_t> value;
+};
+
+static const struct { const char* name; PrefDataType type; } kTypeNames[] = {
+    { "bool", TYPE_BOOL },     { "char", TYPE_CHAR },       { "uchar", TYPE_UCHAR },
+    { "short", TYPE_SHORT },   { "ushort", TYPE_USHORT },   { "int", TYPE_INT },
+    { "uint", TYPE_UINT },     { "long", TYPE_LONG },       { "ulong", TYPE_ULONG },
+    { "long64", TYPE_LONG64 }, { "ulong64", TYPE_ULONG64 }, { "float", TYPE_FLOAT },
+    { "double", TYPE_DOUBLE }, { "string", TYPE_STRING },   { "bytes", TYPE_BYTES },
+};
+
+static const char* typeName(uint8_t type) {
+    for (size_t i = 0; i < sizeof(kTypeNames) / sizeof(kTypeNames[0]); i++) {
+        if (kTypeNames[i].type == type) return kTypeNames[i].name;
+    }
+    return "?";
+}
+
+static uint8_t integerSize(PrefDataType type, const TargetAbi& t) {
+    switch (type) {
+        case TYPE_BOOL: case TYPE_CHAR: case TYPE_UCHAR: return 1;
+        case TYPE_SHORT: case TYPE_USHORT: return t.shortSize;
+        case TYPE_INT: case TYPE_UINT: return t.intSize;
+        case TYPE_LONG: case TYPE_ULONG: return t.longSize;
+        case TYPE_LONG64: case TYPE_ULONG64: return 8;
+        default: return 0;
+    }
+}
+
+static void putLittleEndian(std::vector<uint8_t>& out, uint64_t v, uint8_t size) {
+    for (uint8_t i = 0; i < size; i++) out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+static uint64_t getLittleEndian(const uint8_t* p, uint8_t size) {
+    uint64_t v = 0;
+    for (uint8_t i = 0; i < size; i++) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+// Header Layout --------------------------------------------------------------
+// The engine runs with the host's header structs, which match esp32. AVR
+// packs them: a 7-byte global and a 4-byte block header instead of 8 and
+// 6 bytes, which moves every block. Entry headers are 8 bytes with the
+// same field offsets on all targets.
+
+static uint8_t crc8(const uint8_t* data, size_t len) {
+    uint8_t crc = 0x00;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t j = 0; j < 8; j++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+    return crc;
+}
+
+static uint32_t roundUp(uint32_t n, uint8_t align) {
+    return (n + align - 1) / align * align;
+}
+
+/// Global header: magic, version, totalBlocks, activeBlockIndex, checksum
+static uint32_t globalHeaderSize(const TargetAbi& t) {
+    return roundUp(7, t.headerAlign);
+}
+
+/// Block header: status, currentOffset, checksum
+static uint32_t blockHeaderSize(const TargetAbi& t) {
+    return roundUp(t.headerAlign + 3, t.headerAlign);
+}
+
+static bool hostLayout(const TargetAbi& t) {
+    return globalHeaderSize(t) == GLOBAL_HEADER_SIZE && blockHeaderSize(t) == BLOCK_HEADER_SIZE;
+}
+
+/**
+ * @brief Decode a block header in target layout
+ * @return true if its checksum matches
+ */
+static bool readBlockHeader(const uint8_t* p, const TargetAbi& t, BlockHeader& h) {
+    h.status = p[0];
+    h.currentOffset = (uint16_t)getLittleEndian(p + t.headerAlign, 2);
+    h.checksum = p[t.headerAlign + 2];
+    uint8_t crcData[3] = { h.status, (uint8_t)(h.currentOffset & 0xFF), (uint8_t)(h.currentOffset >> 8) };
+    return crc8(crcData, 3) == h.checksum;
+}
+
+static void writeBlockHeader(uint8_t* p, const TargetAbi& t, uint8_t status, uint16_t currentOffset) {
+    uint8_t crcData[3] = { status, (uint8_t)(currentOffset & 0xFF), (uint8_t)(currentOffset >> 8) };
+    p[0] = status;
+    p[t.headerAlign] = crcData[1];
+    p[t.headerAlign + 1] = crcData[2];
+    p[t.headerAlign + 2] = crc8(crcData, 3);
+}
+
+/**
+ * @brief Move a host-built image to the target's header layout
+ * @param host Image as written by the engine on the host
+ * @param size Image size in bytes
+ *
+ * Block headers are rewritten in place of the old ones and the entries
+ * follow them unchanged; blocks without a valid header stay erased.
+ */
+static std::vector<uint8_t> relayout(const uint8_t* host, size_t size, const ImageOptions& o) {
+    const TargetAbi& t = *o.target;
+    std::vector<uint8_t> img(size, 0xFF);
+    uint16_t hostBlocks = (uint16_t)((size - GLOBAL_HEADER_SIZE) / o.blockSize);
+    uint16_t blocks = (uint16_t)((size - globalHeaderSize(t)) / o.blockSize);
+
+    // Same field offsets; only the trailing padding byte goes
+    memcpy(img.data(), host, offsetof(GlobalHeader, checksum));
+    img[offsetof(GlobalHeader, totalBlocks)] = (uint8_t)(blocks & 0xFF);
+    img[offsetof(GlobalHeader, totalBlocks) + 1] = (uint8_t)(blocks >> 8);
+    img[offsetof(GlobalHeader, checksum)] = crc8(img.data(), offsetof(GlobalHeader, checksum));
+
+    for (uint16_t b = 0; b < hostBlocks && b < blocks; b++) {
+        const uint8_t* src = host + GLOBAL_HEADER_SIZE + (uint32_t)b * o.blockSize;
+        uint8_t* dst = img.data() + globalHeaderSize(t) + (uint32_t)b * o.blockSize;
+        BlockHeader h;
+        if (!readBlockHeader(src, kTargets[0], h) || h.currentOffset < BLOCK_HEADER_SIZE ||
+            h.currentOffset > o.blockSize) continue;
+        uint16_t used = h.currentOffset - BLOCK_HEADER_SIZE;
+        writeBlockHeader(dst, t, h.status, (uint16_t)(blockHeaderSize(t) + used));
+        memcpy(dst + blockHeaderSize(t), src + BLOCK_HEADER_SIZE, used);
+    }
+    return img;
+}
+
+// Manifest -------------------------------------------------------------------
+
+/**
+ * @brief Encode a textual value for the target
+ * @return false on a malformed value
+ */
+static bool encodeValue(PrefDataType type, const char* text, const TargetAbi& t,
+                        std::vector<uint8_t>& out) {
+    char* end = nullptr;
+    switch (type) {
+        case TYPE_BOOL: {
+            bool v = strcmp(text, "true") == 0 || strcmp(text, "1") == 0;
+            if (!v && strcmp(text, "false") != 0 && strcmp(text, "0") != 0) return false;
+            out.push_back(v ? 1 : 0);
+            return true;
+        }
+        case TYPE_CHAR:
+            if (strlen(text) == 1) {
+                out.push_back((uint8_t)text[0]);
+                return true;
+            }
+            // Numeric char
+            [[fallthrough]];
+        case TYPE_SHORT: case TYPE_INT: case TYPE_LONG: case TYPE_LONG64: {
+            long long v = strtoll(text, &end, 0);
+            if (*end) return false;
+            putLittleEndian(out, (uint64_t)v, integerSize(type, t));
+            return true;
+        }
+        case TYPE_UCHAR: case TYPE_USHORT: case TYPE_UINT: case TYPE_ULONG: case TYPE_ULONG64: {
+            unsigned long long v = strtoull(text, &end, 0);
+            if (*end) return false;
+            putLittleEndian(out, v, integerSize(type, t));
+            return true;
+        }
+        case TYPE_FLOAT: {
+            float v = strtof(text, &end);
+            if (*end) return false;
+            const uint8_t* p = (const uint8_t*)&v;
+            out.insert(out.end(), p, p + sizeof(v));
+            return true;
+        }
+        case TYPE_DOUBLE: {
+            double v = strtod(text, &end);
+            if (*end) return false;
+            if (t.doubleSize == 4) {
+                float f = (float)v;
+                const uint8_t* p = (const uint8_t*)&f;
+                out.insert(out.end(), p, p + sizeof(f));
+            } else {
+                const uint8_t* p = (const uint8_t*)&v;
+                out.insert(out.end(), p, p + sizeof(v));
+            }
+            return true;
+        }
+        case TYPE_STRING: {
+            size_t len = strlen(text);
+            if (len >= 2 && text[0] == '"' && text[len - 1] == '"') {
+                text++;
+                len -= 2;
+            }
+            out.insert(out.end(), text, text + len);
+            out.push_back(0);
+            return true;
+        }
+        case TYPE_BYTES: {
+            size_t len = strlen(text);
+            if (len % 2) return false;
+            for (size_t i = 0; i < len; i += 2) {
+                char hex[3] = { text[i], text[i + 1], 0 };
+                out.push_back((uint8_t)strtoul(hex, &end, 16));
+                if (*end) return false;
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+static bool readManifest(const char* path, const ImageOptions& o,
+                         std::vector<ManifestEntry>& entries) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "prefs_image: cannot open %s\n", path);
+        return false;
+    }
+    std::map<std::string, size_t> index;
+    char line[1024];
+    unsigned lineNo = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        line[strcspn(line, "\r\n")] = 0;
+        char key[256], type[16];
+        int consumed = 0;
+        if (line[0] == '#' || sscanf(line, "%255s %15s %n", key, type, &consumed) < 2) continue;
+
+        ManifestEntry e;
+        e.key = key;
+        e.type = TYPE_NONE;
+        for (size_t i = 0; i < sizeof(kTypeNames) / sizeof(kTypeNames[0]); i++) {
+            if (strcmp(kTypeNames[i].name, type) == 0) e.type = kTypeNames[i].type;
+        }
+        if (e.type == TYPE_NONE || !encodeValue(e.type, line + consumed, *o.target, e.value)) {
+            fprintf(stderr, "%s:%u: invalid entry\n", path, lineNo);
+            ok = false;
+            continue;
+        }
+        if (e.key.size() > o.maxKey || e.value.size() > o.maxValue) {
+            fprintf(stderr, "%s:%u: key or value exceeds --max-key/--max-value\n", path, lineNo);
+            ok = false;
+            continue;
+        }
+        std::map<std::string, size_t>::iterator it = index.find(e.key);
+        if (it != index.end()) {
+            entries[it->second] = e;
+        } else {
+            index[e.key] = entries.size();
+            entries.push_back(e);
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+// Image Output ---------------------------------------------------------------
+
+/**
+ * @brief Length of the image prefix that differs from erased (0xFF) memory
+ */
+static size_t usedExtent(const uint8_t* data, size_t size) {
+    while (size > 0 && data[size - 1] == 0xFF) size--;
+    return size;
+}
+
+static bool writeImage(const ImageOptions& o, const uint8_t* data, size_t size) {
+    FILE* f = fopen(o.output, o.cFormat ? "w" : "wb");
+    if (!f) {
+        fprintf(stderr, "prefs_image: cannot create %s\n", o.output);
+        return false;
+    }
+    if (o.cFormat) {
+        fprintf(f, "// Generated by prefs_image: %s, %u Kbit, block %u\n",
+                o.eeprom ? "EEPROM" : "FRAM", (unsigned)o.sizeKbit, (unsigned)o.blockSize);
+        fprintf(f, "const uint16_t prefsImageSize = %zu;\n", size);
+        fprintf(f, "const uint8_t prefsImage[%zu] PROGMEM = {", size);
+        for (size_t i = 0; i < size; i++) {
+            fprintf(f, "%s0x%02x%s", (i % 16) ? "" : "\n    ", data[i], i + 1 < size ? "," : "");
+        }
+        fprintf(f, "\n};\n");
+    } else {
+        fwrite(data, 1, size, f);
+    }
+    fclose(f);
+    return true;
+}
+
+static I2CMiniPrefs* makeStore(const ImageOptions& o) {
+    return new I2CMiniPrefs(o.eeprom ? MEM_TYPE_EEPROM : MEM_TYPE_FRAM, 0x50,
+                            o.sizeKbit * 1024, o.blockSize, o.maxKey, o.maxValue);
+}
+
+static int cmdBuild(const ImageOptions& o, const char* manifest) {
+    std::vector<ManifestEntry> entries;
+    if (manifest && !readManifest(manifest, o, entries)) return 1;
+
+    SimChip chip(0x50, o.sizeKbit * 1024 / 8, o.eeprom);
+    Wire.attach(&chip);
+    I2CMiniPrefs* prefs = makeStore(o);
+    if (!prefs->begin()) {
+        fprintf(stderr, "prefs_image: cannot format image (check layout)\n");
+        return 1;
+    }
+    size_t payload = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        const ManifestEntry& e = entries[i];
+        if (!prefs->putTyped(e.key.c_str(), e.type, e.value.data(), e.value.size())) {
+            fprintf(stderr, "prefs_image: store full at key '%s' (increase --block)\n", e.key.c_str());
+            return 1;
+        }
+        payload += ENTRY_HEADER_SIZE + e.key.size() + e.value.size();
+    }
+    delete prefs;
+
+    std::vector<uint8_t> img(chip.data(), chip.data() + chip.size());
+    if (!hostLayout(*o.target)) img = relayout(chip.data(), chip.size(), o);
+    size_t size = o.trim ? usedExtent(img.data(), img.size()) : img.size();
+    if (!writeImage(o, img.data(), size)) return 1;
+    printf("%s: %zu entries, %zu bytes of entries, %zu of %u bytes to program\n",
+           o.output, entries.size(), payload, size, (unsigned)chip.size());
+    return 0;
+}
+
+// Inspection -----------------------------------------------------------------
+
+static const char* blockStatusName(uint8_t status) {
+    switch (status) {
+        case BLOCK_STATUS_EMPTY:   return "empty";
+        case BLOCK_STATUS_ACTIVE:  return "active";
+        case BLOCK_STATUS_VALID:   return "valid";
+        case BLOCK_STATUS_INVALID: return "invalid";
+        case BLOCK_STATUS_SNAPSHOT: return "snapshot";
+        case BLOCK_STATUS_STAGED:  return "staged";
+        case BLOCK_STATUS_UPGRADE: return "upgrade";
+        case BLOCK_STATUS_COMPACT: return "compact";
+        default:                   return "?";
+    }
+}
+
+static void printValue(const EntryHeader& h, const uint8_t* v, const TargetAbi& t) {
+    PrefDataType type = (PrefDataType)h.dataType;
+    uint8_t isize = integerSize(type, t);
+    if (type == TYPE_STRING) {
+        printf("\"%.*s\"", (int)strnlen((const char*)v, h.valueLength), (const char*)v);
+    } else if (type == TYPE_FLOAT && h.valueLength == 4) {
+        float f;
+        memcpy(&f, v, 4);
+        printf("%g", f);
+    } else if (type == TYPE_DOUBLE && h.valueLength == 8) {
+        double d;
+        memcpy(&d, v, 8);
+        printf("%g", d);
+    } else if (type == TYPE_DOUBLE && h.valueLength == 4) {
+        float f;
+        memcpy(&f, v, 4);
+        printf("%g", f);
+    } else if (isize && h.valueLength == isize) {
+        uint64_t u = getLittleEndian(v, isize);
+        bool isSigned = type == TYPE_CHAR || type == TYPE_SHORT || type == TYPE_INT ||
+                        type == TYPE_LONG || type == TYPE_LONG64;
+        if (type == TYPE_BOOL) printf("%s", u ? "true" : "false");
+        else if (isSigned) printf("%lld", (long long)(u << (64 - 8 * isize)) >> (64 - 8 * isize));
+        else printf("%llu", (unsigned long long)u);
+    } else {
+        for (uint16_t i = 0; i < h.valueLength; i++) printf("%02x", v[i]);
+    }
+}
+
+static void hexLine(const uint8_t* data, uint32_t addr, uint32_t len, const char* label) {
+    printf("%04x  ", addr);
+    for (uint32_t i = 0; i < 16; i++) {
+        if (i < len) printf("%02x ", data[addr + i]);
+        else printf("   ");
+    }
+    printf(" %s\n", label);
+}
+
+/**
+ * @brief Walk an image the way _findEntry does and print what is found
+ * @param hex Print raw bytes instead of decoded values
+ */
+static int cmdInspect(const ImageOptions& o, const char* path, bool hex) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "prefs_image: cannot open %s\n", path);
+        return 1;
+    }
+    std::vector<uint8_t> img(o.sizeKbit * 1024 / 8, 0xFF);
+    size_t n = fread(img.data(), 1, img.size(), f);
+    fclose(f);
+    printf("%s: %zu bytes read, layout %u bytes / block %u\n", path, n, (unsigned)img.size(), (unsigned)o.blockSize);
+
+    const TargetAbi& t = *o.target;
+    uint32_t globalSize = globalHeaderSize(t);
+    uint32_t blockSize = blockHeaderSize(t);
+
+    // The fields up to the checksum sit at the same offsets on all targets
+    GlobalHeader g;
+    memcpy(&g, img.data(), offsetof(GlobalHeader, checksum) + 1);
+    bool gOk = g.magic == PREFS_MAGIC && g.version == PREFS_VERSION &&
+               crc8((const uint8_t*)&g, offsetof(GlobalHeader, checksum)) == g.checksum;
+    uint16_t expectBlocks = (uint16_t)((img.size() - globalSize) / o.blockSize);
+    printf("global header: %s, version %u, %u blocks, active %u\n",
+           gOk ? "ok" : "INVALID", g.version, g.totalBlocks, g.activeBlockIndex);
+    if (gOk && g.totalBlocks != expectBlocks) {
+        printf("warning: header reports %u blocks, layout gives %u (wrong --block/--size-kbit?)\n",
+               g.totalBlocks, expectBlocks);
+    }
+    if (hex) hexLine(img.data(), 0, globalSize, "global header");
+
+    unsigned live = 0, dead = 0;
+    for (uint16_t b = 0; b < expectBlocks; b++) {
+        uint32_t base = globalSize + (uint32_t)b * o.blockSize;
+        BlockHeader bh;
+        bool bOk = readBlockHeader(img.data() + base, t, bh);
+        if (!bOk || (bh.status != BLOCK_STATUS_ACTIVE && bh.status != BLOCK_STATUS_VALID)) continue;
+
+        printf("block %u @0x%04x: %s, %u of %u bytes used\n", b, (unsigned)base,
+               blockStatusName(bh.status), bh.currentOffset, o.blockSize);
+        if (hex) hexLine(img.data(), base, blockSize, "block header");
+        uint32_t off = blockSize;
+        while (off < bh.currentOffset && off + ENTRY_HEADER_SIZE <= o.blockSize) {
+            EntryHeader eh;
+            memcpy(&eh, img.data() + base + off, sizeof(eh));
+            uint32_t total = ENTRY_HEADER_SIZE + eh.keyLength + eh.valueLength;
+            if (off + total > o.blockSize) {
+                printf("  @0x%04x: entry overruns block, stopping\n", (unsigned)(base + off));
+                break;
+            }
+            const uint8_t* key = img.data() + base + off + ENTRY_HEADER_SIZE;
+            const uint8_t* val = key + eh.keyLength;
+            bool alive = eh.status != 0x00;
+            alive ? live++ : dead++;
+            printf("  @0x%04x %-7s %-7s %-*.*s = ", (unsigned)(base + off), alive ? "live" : "deleted",
+                   typeName(eh.dataType & ~PREFS_TTL_FLAG), o.maxKey, (int)eh.keyLength, (const char*)key);
+            if (hex) {
+                for (uint16_t i = 0; i < eh.valueLength; i++) printf("%02x", val[i]);
+            } else if ((eh.dataType & PREFS_TTL_FLAG) && eh.valueLength >= PREFS_TTL_STAMP_SIZE) {
+                // Expiry stamp, then the value itself
+                EntryHeader value = eh;
+                value.dataType &= ~PREFS_TTL_FLAG;
+                value.valueLength -= PREFS_TTL_STAMP_SIZE;
+                printValue(value, val + PREFS_TTL_STAMP_SIZE, t);
+                printf(" (expires %u)", (unsigned)(val[0] | (val[1] << 8) | (val[2] << 16) |
+                                                   ((uint32_t)val[3] << 24)));
+            } else {
+                printValue(eh, val, t);
+            }
+            printf("\n");
+            off += total;
+        }
+    }
+    printf("%u live entries, %u deleted\n", live, dead);
+    return gOk ? 0 : 1;
+}
+
+// Command Line ---------------------------------------------------------------
+
+static bool parseArgs(int argc, char** argv, ImageOptions& o) {
+    for (int i = 2; i < argc; i++) {
+        const char* a = argv[i];
+        if (a[0] != '-') { o.positional.push_back(a); continue; }
+        if (strcmp(a, "--trim") == 0) { o.trim = true; continue; }
+        if (i + 1 >= argc) return false;
+        const char* v = argv[++i];
+        if      (strcmp(a, "-o") == 0)           o.output = v;
+        else if (strcmp(a, "--mem") == 0)        o.eeprom = strcmp(v, "fram") != 0;
+        else if (strcmp(a, "--size-kbit") == 0)  o.sizeKbit = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--block") == 0)      o.blockSize = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--max-key") == 0)    o.maxKey = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--max-value") == 0)  o.maxValue = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--format") == 0)     o.cFormat = strcmp(v, "c") == 0;
+        else if (strcmp(a, "--target") == 0) {
+            o.target = nullptr;
+            for (size_t t = 0; t < sizeof(kTargets) / sizeof(kTargets[0]); t++) {
+                if (strcmp(kTargets[t].name, v) == 0) o.target = &kTargets[t];
+            }
+            if (!o.target) return false;
+        }
+        else return false;
+    }
+    return o.blockSize > BLOCK_HEADER_SIZE;
+}
+
+int main(int argc, char** argv) {
+    ImageOptions o;
+    const char* cmd = argc > 1 ? argv[1] : "";
+    if (!parseArgs(argc, argv, o)) cmd = "";
+
+    if (strcmp(cmd, "mkfs") == 0 && o.output && o.positional.empty()) return cmdBuild(o, nullptr);
+    if (strcmp(cmd, "build") == 0 && o.output && o.positional.size() == 1) return cmdBuild(o, o.positional[0]);
+    if (strcmp(cmd, "inspect") == 0 && o.positional.size() == 1) return cmdInspect(o, o.positional[0], false);
+    if (strcmp(cmd, "dump") == 0 && o.positional.size() == 1) return cmdInspect(o, o.positional[0], true);
+
+    fprintf(stderr,
+        "usage: prefs_image mkfs -o IMAGE [layout]\n"
+        "       prefs_image build MANIFEST -o IMAGE [layout] [--target esp32|avr] [--format bin|c] [--trim]\n"
+        "       prefs_image inspect IMAGE [layout] [--target esp32|avr]\n"
+        "       prefs_image dump IMAGE [layout] [--target esp32|avr]\n"
+        "layout: [--mem eeprom|fram] [--size-kbit N] [--block N] [--max-key N] [--max-value N]\n");
+    return 2;
+}
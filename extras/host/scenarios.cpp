@@ -0,0 +1,345 @@
+/**
+ * @file scenarios.cpp
+ * @brief Host checks for the classes built on top of the storage engine
+ *
+ * Runs one scenario per add-on class against simulated chips and checks
+ * every value it stored against a reference model:
+ *
+ * - bus: three EEPROMs on one Wire, queued puts driven by I2CMiniPrefsBus
+ *   versus each store drained on its own (simulated bus time)
+ * - isr: PrefsIsrQueue overflow and per-key coalescing
+ * - await: coroutines on I2CMiniPrefsAwait.h (C++20 builds only)
+ * - tiered: I2CMiniPrefsTiered versus the EEPROM store alone (bytes
+ *   programmed on the EEPROM)
+ * - mirror: I2CMiniPrefsMirror CRC fallback, repair, a dead or missing
+ *   chip, resync
+ * - compat: I2CPreferences namespaces and read-only mode
+ *
+ * @code
+ * scenarios [bus|isr|await|tiered|mirror|compat ...]
+ * @endcode
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include "I2CMiniPrefsAwait.h"
+#include "I2CMiniPrefsBus.h"
+#include "I2CMiniPrefsCompat.h"
+#include "I2CMiniPrefsIsrQueue.h"
+#include "I2CMiniPrefsMirror.h"
+#include "I2CMiniPrefsTiered.h"
+
+static uint32_t g_rng = 1;
+
+static uint32_t scenarioRand() {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+/**
+ * @brief Start a scenario on empty buses and a fixed random sequence
+ */
+static void resetBuses() {
+    Wire.detachAll();
+    Wire1.detachAll();
+    g_rng = 1;
+}
+
+// Bus Scheduler --------------------------------------------------------------
+
+/**
+ * @brief Queue 150 puts on three EEPROMs and wait until all are stored
+ * @param useBus Drive the stores through I2CMiniPrefsBus; otherwise a
+ *        store is polled only while its own queue is full, then drained
+ * @param[out] elapsedMs Simulated time until the last put completed
+ * @return true if every store holds the last value of every key
+ */
+static bool runBusWorkload(bool useBus, uint32_t& elapsedMs) {
+    resetBuses();
+    SimChip chips[3] = {SimChip(0x50, 2048, true), SimChip(0x51, 2048, true),
+                        SimChip(0x52, 2048, true)};
+    I2CMiniPrefs pa(MEM_TYPE_EEPROM, 0x50, 2048 * 8, 256, 16, 64);
+    I2CMiniPrefs pb(MEM_TYPE_EEPROM, 0x51, 2048 * 8, 256, 16, 64);
+    I2CMiniPrefs pc(MEM_TYPE_EEPROM, 0x52, 2048 * 8, 256, 16, 64);
+    I2CMiniPrefs* stores[3] = {&pa, &pb, &pc};
+    I2CMiniPrefsBus bus;
+    for (uint8_t s = 0; s < 3; s++) {
+        Wire.attach(&chips[s]);
+        if (!stores[s]->begin()) return false;
+        if (useBus) bus.attach(*stores[s], s);
+    }
+
+    uint32_t startMs = millis();
+    for (int i = 0; i < 50; i++) {
+        char key[8];
+        snprintf(key, sizeof(key), "k%d", i % 5);
+        for (uint8_t s = 0; s < 3; s++) {
+            while (!stores[s]->putAsync(key, i)) {
+                if (useBus) bus.poll();
+                else stores[s]->poll();
+                delayMicroseconds(50);
+            }
+        }
+    }
+    if (useBus) {
+        while (bus.poll()) delayMicroseconds(50);
+    } else {
+        for (uint8_t s = 0; s < 3; s++) {
+            while (stores[s]->poll()) delayMicroseconds(50);
+        }
+    }
+    elapsedMs = millis() - startMs;
+
+    bool ok = true;
+    for (uint8_t s = 0; s < 3; s++) {
+        for (int k = 0; k < 5; k++) {
+            char key[8];
+            snprintf(key, sizeof(key), "k%d", k);
+            ok = ok && stores[s]->getInt(key, -1) == 45 + k;
+        }
+    }
+    return ok;
+}
+
+static bool scenarioBus() {
+    uint32_t busMs = 0, aloneMs = 0;
+    bool ok = runBusWorkload(true, busMs) && runBusWorkload(false, aloneMs);
+    printf("bus     %s  150 puts on three EEPROMs: %u ms with I2CMiniPrefsBus, %u ms per store\n",
+           ok ? "ok  " : "FAIL", (unsigned)busMs, (unsigned)aloneMs);
+    return ok;
+}
+
+// ISR Queue ------------------------------------------------------------------
+
+static bool scenarioIsr() {
+    resetBuses();
+    SimChip chip(0x50, 2048, false);
+    Wire.attach(&chip);
+    I2CMiniPrefs prefs(MEM_TYPE_FRAM, 0x50, 2048 * 8, 256, 16, 64);
+    if (!prefs.begin()) return false;
+
+    // Ten pushes into eight slots: two overflow, one write per key remains
+    PrefsIsrQueue<8> queue;
+    for (uint32_t i = 0; i < 9; i++) queue.push("count", i);
+    queue.push("fault", (uint16_t)0x42);
+    uint64_t writesBefore = chip.totalByteWrites();
+    uint8_t drained = queue.drainInto(prefs);
+    uint64_t programmed = chip.totalByteWrites() - writesBefore;
+
+    bool ok = drained == 8 && queue.overflows() == 2 && queue.size() == 0 &&
+              queue.writeErrors() == 0 && prefs.getUInt("count", 0) == 7 &&
+              !prefs.isKey("fault");
+    queue.push("fault", (uint16_t)0x42);
+    queue.drainInto(prefs);
+    ok = ok && prefs.getUShort("fault", 0) == 0x42;
+    printf("isr     %s  8 of 10 pushes queued, drained as 1 put (%llu bytes programmed)\n",
+           ok ? "ok  " : "FAIL", (unsigned long long)programmed);
+    return ok;
+}
+
+// Coroutines -----------------------------------------------------------------
+
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+static int g_workersDone;
+static int g_workerFailures;
+
+static PrefsTask counterWorker(I2CMiniPrefs& prefs, const char* key, int rounds) {
+    for (int i = 0; i < rounds; i++) {
+        int value = co_await prefs.getAsync<int>(key, 0);
+        if (!co_await prefs.putAsync(key, value + 1)) g_workerFailures++;
+    }
+    if (co_await prefs.removeAsync("missing")) g_workerFailures++;
+    g_workersDone++;
+}
+
+static bool scenarioAwait() {
+    resetBuses();
+    SimChip chip(0x50, 2048, true);
+    Wire.attach(&chip);
+    I2CMiniPrefs prefs(MEM_TYPE_EEPROM, 0x50, 2048 * 8, 256, 16, 64);
+    if (!prefs.begin()) return false;
+
+    g_workersDone = 0;
+    g_workerFailures = 0;
+    counterWorker(prefs, "w1", 20);
+    counterWorker(prefs, "w2", 20);
+    uint32_t polls = 0;
+    while (g_workersDone < 2 && polls < 1000000) {
+        prefs.poll();
+        polls++;
+        delayMicroseconds(100);
+    }
+    bool ok = g_workersDone == 2 && g_workerFailures == 0 &&
+              prefs.getInt("w1") == 20 && prefs.getInt("w2") == 20;
+    printf("await   %s  two coroutines, 20 increments each, %u polls\n",
+           ok ? "ok  " : "FAIL", (unsigned)polls);
+    return ok;
+}
+#else
+static bool scenarioAwait() {
+    printf("await   skip  needs a C++20 build (-std=gnu++20)\n");
+    return true;
+}
+#endif
+
+// Tiered Store ---------------------------------------------------------------
+
+/**
+ * @brief Random puts over a key set, checked against a model afterwards
+ * @return EEPROM bytes programmed, 0 if a value read back wrong
+ */
+template<typename Store>
+static uint64_t runTieredWorkload(Store& store, SimChip& eeprom) {
+    std::map<std::string, int> model;
+    uint64_t writesBefore = eeprom.totalByteWrites();
+    for (int i = 0; i < 5000; i++) {
+        char key[8];
+        snprintf(key, sizeof(key), "k%u", (unsigned)(scenarioRand() % 200));
+        if (!store.putInt(key, i)) return 0;
+        model[key] = i;
+    }
+    uint64_t programmed = eeprom.totalByteWrites() - writesBefore;
+    for (std::map<std::string, int>::iterator it = model.begin(); it != model.end(); ++it) {
+        if (store.getInt(it->first.c_str(), -1) != it->second) return 0;
+    }
+    return programmed;
+}
+
+static bool scenarioTiered() {
+    resetBuses();
+    SimChip framChip(0x50, 8192, false), eepromChip(0x51, 65536, true);
+    Wire.attach(&framChip);
+    Wire.attach(&eepromChip);
+    I2CMiniPrefs fram(MEM_TYPE_FRAM, 0x50, 64 * 1024, 2048, 16, 64);
+    I2CMiniPrefs eeprom(MEM_TYPE_EEPROM, 0x51, 512 * 1024, 8192, 16, 64);
+    I2CMiniPrefsTiered tiered(fram, eeprom);
+    if (!tiered.begin()) return false;
+    uint64_t tieredBytes = runTieredWorkload(tiered, eepromChip);
+    bool merged = tiered.merge();
+    uint32_t merges = tiered.merges();
+
+    resetBuses();
+    SimChip aloneChip(0x51, 65536, true);
+    Wire.attach(&aloneChip);
+    I2CMiniPrefs alone(MEM_TYPE_EEPROM, 0x51, 512 * 1024, 8192, 16, 64);
+    if (!alone.begin()) return false;
+    uint64_t aloneBytes = runTieredWorkload(alone, aloneChip);
+
+    bool ok = tieredBytes > 0 && aloneBytes > 0 && merged;
+    printf("tiered  %s  5000 puts over 200 keys: %llu EEPROM bytes programmed (%u merges), "
+           "%llu without the FRAM tier\n", ok ? "ok  " : "FAIL",
+           (unsigned long long)tieredBytes, (unsigned)merges, (unsigned long long)aloneBytes);
+    return ok;
+}
+
+// Mirrored Chips -------------------------------------------------------------
+
+static bool scenarioMirror() {
+    resetBuses();
+    SimChip chipA(0x50, 32768, true), chipB(0x50, 32768, true);
+    Wire.attach(&chipA);
+    Wire1.attach(&chipB);
+    I2CMiniPrefs a(MEM_TYPE_EEPROM, 0x50, 256 * 1024, 4096, 16, 64);
+    I2CMiniPrefs b(MEM_TYPE_EEPROM, 0x50, 256 * 1024, 4096, 16, 64, 25, 26);
+    b.setWire(Wire1);
+    bool ok;
+    {
+        I2CMiniPrefsMirror mirror(a, b);
+        ok = mirror.begin() && mirror.putString("name", "station seven");
+
+        // Damage chip A's copy: the read falls back, poll() repairs it
+        uint8_t* data = chipA.data();
+        for (uint32_t i = 0; i + 7 < chipA.size(); i++) {
+            if (memcmp(data + i, "station", 7) == 0) data[i] ^= 0x01;
+        }
+        for (int i = 0; i < 4; i++) ok = ok && mirror.getString("name") == "station seven";
+        while (mirror.poll()) delayMicroseconds(100);
+        PrefsMirrorStats stats;
+        mirror.getStats(stats);
+        ok = ok && stats.crcErrors > 0 && stats.fallbacks > 0 && stats.repairs == 1;
+
+        // Chip B disappears: the put still succeeds on chip A
+        Wire1.detachAll();
+        ok = ok && mirror.putInt("count", 7) && mirror.online(0) && !mirror.online(1);
+    }
+
+    // After a reboot chip B stays offline until resync() copies A over it
+    Wire1.attach(&chipB);
+    delay(10);
+    {
+        I2CMiniPrefsMirror mirror(a, b);
+        ok = ok && mirror.begin() && mirror.online(0) && !mirror.online(1);
+        ok = ok && mirror.resync() && mirror.online(1) && mirror.getInt("count", -1) == 7;
+    }
+
+    // Chip B missing at boot: it misses the next put and must stay out
+    Wire1.detachAll();
+    delay(10);
+    {
+        I2CMiniPrefsMirror mirror(a, b);
+        ok = ok && mirror.begin() && !mirror.online(1) && mirror.putInt("count", 8);
+    }
+    Wire1.attach(&chipB);
+    delay(10);
+    I2CMiniPrefsMirror mirror(a, b);
+    ok = ok && mirror.begin() && !mirror.online(1) && mirror.getInt("count", -1) == 8;
+    ok = ok && mirror.resync() && mirror.online(1) && b.isKey("count");
+    printf("mirror  %s  CRC fallback, repair, lost or missing chip offline until resync()\n",
+           ok ? "ok  " : "FAIL");
+    return ok;
+}
+
+// Preferences Facade ---------------------------------------------------------
+
+static bool scenarioCompat() {
+    resetBuses();
+    SimChip chip(0x50, 32768, false);
+    Wire.attach(&chip);
+    I2CMiniPrefs store(MEM_TYPE_FRAM, 0x50, 256 * 1024, 4096, 32, 64);
+    I2CPreferences wifi(store), counters(store), reader(store);
+
+    bool ok = wifi.begin("wifi") && counters.begin("counters") && reader.begin("wifi", true);
+    ok = ok && wifi.putString("ssid", "home") == 4 && wifi.putUInt("ch", 6) == 4 &&
+         counters.putUInt("ch", 99) == 4;
+    ok = ok && reader.putUInt("ch", 1) == 0 && reader.getUInt("ch") == 6 &&
+         reader.getString("ssid") == "home";
+    ok = ok && wifi.clear() && !wifi.isKey("ssid") && counters.getUInt("ch") == 99;
+    printf("compat  %s  two namespaces on one store, read-only instance, namespace clear\n",
+           ok ? "ok  " : "FAIL");
+    return ok;
+}
+
+// Command Line ---------------------------------------------------------------
+
+static const struct { const char* name; bool (*run)(); } kScenarios[] = {
+    { "bus", scenarioBus },       { "isr", scenarioIsr },       { "await", scenarioAwait },
+    { "tiered", scenarioTiered }, { "mirror", scenarioMirror }, { "compat", scenarioCompat },
+};
+
+int main(int argc, char** argv) {
+    const size_t count = sizeof(kScenarios) / sizeof(kScenarios[0]);
+    for (int i = 1; i < argc; i++) {
+        bool known = false;
+        for (size_t s = 0; s < count; s++) known = known || strcmp(argv[i], kScenarios[s].name) == 0;
+        if (!known) {
+            fprintf(stderr, "usage: scenarios [bus|isr|await|tiered|mirror|compat ...]\n");
+            return 2;
+        }
+    }
+
+    unsigned failed = 0;
+    for (size_t s = 0; s < count; s++) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; i++) selected = selected || strcmp(argv[i], kScenarios[s].name) == 0;
+        if (selected && !kScenarios[s].run()) failed++;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,287 @@
+/**
+ * @file wear_sim.cpp
+ * @brief Wear-distribution simulator for the I2CMiniPrefs storage engine
+ *
+ * Replays a recorded or synthetic put/remove workload against the real
+ * engine running on a SimChip and reports per-byte and per-block program
+ * counts as heatmap CSVs, plus a projection of the time to first cell
+ * failure for the given chip endurance. Traces may be text files or binary
+ * dumps from I2CMiniPrefs::dumpTrace().
+ *
+ * @code
+ * wear_sim [--mem eeprom|fram] [--size-kbit 256] [--block 256] [--page 64] [--verify]
+ *          [--max-key 16] [--max-value 64] [--endurance 1e6]
+ *          [--trace file.txt [--loop]] [--ops 100000] [--keys 8]
+ *          [--value-size 8] [--remove-pct 5] [--hot-pct 80] [--seed 1]
+ *          [--rate ops_per_second] [--out prefix] [--row 32]
+ *          [--cold image.bin [--cold-gen 4]]
+ * @endcode
+ *
+ * With --cold the engine runs with a cold tier in a host file. Every key
+ * is then checked against a reference model after the run.
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "I2CMiniPrefs.h"
+#include "PrefsColdStdio.h"
+#include "TraceReplay.h"
+
+/**
+ * @struct SimOptions
+ * @brief Command line configuration
+ */
+struct SimOptions {
+    bool eeprom = true;
+    uint32_t sizeKbit = 256;
+    uint16_t blockSize = 256;
+    uint16_t pageSize = 64;
+    bool verify = false;
+    uint8_t maxKey = 16;
+    uint16_t maxValue = 64;
+    double endurance = 0;
+    const char* trace = nullptr;
+    bool loop = false;
+    uint64_t ops = 100000;
+    uint32_t keys = 8;
+    uint16_t valueSize = 8;
+    uint8_t removePct = 5;
+    uint8_t hotPct = 80;
+    uint32_t seed = 1;
+    double rate = 0;
+    const char* out = "wear";
+    uint16_t row = 32;
+    const char* cold = nullptr;
+    uint8_t coldGen = PREFS_COLD_GENERATIONS;
+};
+
+static void usage() {
+    fprintf(stderr,
+        "usage: wear_sim [--mem eeprom|fram] [--size-kbit N] [--block N] [--page N] [--verify]\n"
+        "                [--max-key N] [--max-value N] [--endurance CYCLES]\n"
+        "                [--trace FILE [--loop]] [--ops N] [--keys N] [--value-size N]\n"
+        "                [--remove-pct P] [--hot-pct P] [--seed N] [--rate OPS_PER_S]\n"
+        "                [--out PREFIX] [--row N] [--cold FILE [--cold-gen N]]\n");
+}
+
+static bool parseArgs(int argc, char** argv, SimOptions& o) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (strcmp(a, "--loop") == 0) { o.loop = true; continue; }
+        if (strcmp(a, "--verify") == 0) { o.verify = true; continue; }
+        if (!v) return false;
+        i++;
+        if      (strcmp(a, "--mem") == 0)        o.eeprom = strcmp(v, "fram") != 0;
+        else if (strcmp(a, "--size-kbit") == 0)  o.sizeKbit = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--block") == 0)      o.blockSize = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--page") == 0)       o.pageSize = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--max-key") == 0)    o.maxKey = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--max-value") == 0)  o.maxValue = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--endurance") == 0)  o.endurance = strtod(v, nullptr);
+        else if (strcmp(a, "--trace") == 0)      o.trace = v;
+        else if (strcmp(a, "--ops") == 0)        o.ops = strtoull(v, nullptr, 0);
+        else if (strcmp(a, "--keys") == 0)       o.keys = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--value-size") == 0) o.valueSize = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--remove-pct") == 0) o.removePct = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--hot-pct") == 0)    o.hotPct = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--seed") == 0)       o.seed = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--rate") == 0)       o.rate = strtod(v, nullptr);
+        else if (strcmp(a, "--out") == 0)        o.out = v;
+        else if (strcmp(a, "--row") == 0)        o.row = strtoul(v, nullptr, 0);
+        else if (strcmp(a, "--cold") == 0)       o.cold = v;
+        else if (strcmp(a, "--cold-gen") == 0)   o.coldGen = strtoul(v, nullptr, 0);
+        else return false;
+    }
+    if (o.endurance <= 0) o.endurance = o.eeprom ? 1e6 : 1e14;
+    if (o.row == 0) o.row = 32;
+    return true;
+}
+
+/**
+ * @brief Write the per-byte heatmap, one CSV row per o.row bytes
+ */
+static bool writeByteHeatmap(const SimChip& chip, const SimOptions& o) {
+    std::string path = std::string(o.out) + "_bytes.csv";
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    fprintf(f, "address");
+    for (uint16_t c = 0; c < o.row; c++) fprintf(f, ",+%u", c);
+    fprintf(f, "\n");
+    const std::vector<uint32_t>& w = chip.byteWrites();
+    for (size_t base = 0; base < w.size(); base += o.row) {
+        fprintf(f, "0x%04zx", base);
+        for (size_t c = 0; c < o.row && base + c < w.size(); c++) fprintf(f, ",%u", w[base + c]);
+        fprintf(f, "\n");
+    }
+    fclose(f);
+    return true;
+}
+
+/**
+ * @brief Write per-block totals (the global header is reported as block -1)
+ */
+static bool writeBlockHeatmap(const SimChip& chip, const SimOptions& o) {
+    std::string path = std::string(o.out) + "_blocks.csv";
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    fprintf(f, "block,start,end,total_writes,max_byte_writes,header_writes\n");
+    const std::vector<uint32_t>& w = chip.byteWrites();
+    uint32_t totalBlocks = (chip.size() - GLOBAL_HEADER_SIZE) / o.blockSize;
+    for (int32_t b = -1; b < (int32_t)totalBlocks; b++) {
+        uint32_t start = b < 0 ? 0 : GLOBAL_HEADER_SIZE + b * o.blockSize;
+        uint32_t end = b < 0 ? GLOBAL_HEADER_SIZE : start + o.blockSize;
+        uint64_t total = 0;
+        uint32_t peak = 0, header = 0;
+        for (uint32_t a = start; a < end; a++) {
+            total += w[a];
+            if (w[a] > peak) peak = w[a];
+        }
+        if (b >= 0) header = w[start + offsetof(BlockHeader, currentOffset)];
+        fprintf(f, "%d,%u,%u,%llu,%u,%u\n", b, start, end - 1,
+                (unsigned long long)total, peak, header);
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    SimOptions o;
+    if (!parseArgs(argc, argv, o)) {
+        usage();
+        return 2;
+    }
+
+    uint32_t sizeBytes = o.sizeKbit * 1024 / 8;
+    SimChip chip(0x50, sizeBytes, o.eeprom, o.pageSize);
+    Wire.attach(&chip);
+    I2CMiniPrefs prefs(o.eeprom ? MEM_TYPE_EEPROM : MEM_TYPE_FRAM, 0x50,
+                       o.sizeKbit * 1024, o.blockSize, o.maxKey, o.maxValue);
+    prefs.setPageSize(o.pageSize);
+    prefs.setVerifyBeforeWrite(o.verify);
+
+    // The chip starts blank, so the cold image does as well
+    PrefsColdStdio coldBackend(o.cold ? o.cold : "");
+    PrefsColdTier cold(coldBackend);
+    if (o.cold) {
+        cold.begin();
+        if (!cold.clear()) {
+            fprintf(stderr, "wear_sim: cannot write %s\n", o.cold);
+            return 1;
+        }
+        prefs.setColdTier(&cold, o.coldGen);
+    }
+    if (!prefs.begin()) {
+        fprintf(stderr, "wear_sim: begin() failed\n");
+        return 1;
+    }
+    chip.resetWear();
+    uint64_t startUs = hostMicros64();
+
+    FILE* traceFile = nullptr;
+    TraceSource* source;
+    if (o.trace) {
+        traceFile = fopen(o.trace, "r");
+        if (!traceFile) {
+            fprintf(stderr, "wear_sim: cannot open %s\n", o.trace);
+            return 1;
+        }
+        if (BinaryTraceSource::probe(traceFile)) {
+            source = new BinaryTraceSource(traceFile, o.ops, o.loop);
+        } else {
+            source = new TextTraceSource(traceFile, o.ops, o.loop);
+        }
+    } else {
+        source = new SyntheticTraceSource(o.ops, o.keys, o.valueSize, o.removePct, o.hotPct, o.seed);
+    }
+
+    std::vector<uint8_t> value(o.maxValue);
+    std::map<std::string, std::vector<uint8_t> > model;
+    uint64_t ops = 0, failed = 0, payloadBytes = 0;
+    TraceOp op;
+    while (source->next(op)) {
+        bool ok;
+        if (op.kind == TRACE_OP_PUT) {
+            uint16_t len = op.valueSize > o.maxValue ? o.maxValue : op.valueSize;
+            traceFillValue(ops, value.data(), len);
+            ok = prefs.putBytes(op.key.c_str(), value.data(), len);
+            if (ok && o.cold) model[op.key].assign(value.begin(), value.begin() + len);
+            payloadBytes += len;
+        } else if (op.kind == TRACE_OP_GET) {
+            prefs.getBytes(op.key.c_str(), value.data(), value.size());
+            ok = true;
+        } else if (op.kind == TRACE_OP_REMOVE) {
+            ok = prefs.remove(op.key.c_str()) || !prefs.isKey(op.key.c_str());
+            if (ok) model.erase(op.key);
+        } else {
+            ok = prefs.clear();
+            if (ok) model.clear();
+        }
+        if (!ok) failed++;
+        ops++;
+        if ((ops & 0xFFFF) == 0) fprintf(stderr, "\r%llu ops", (unsigned long long)ops);
+    }
+    if (ops > 0xFFFF) fprintf(stderr, "\n");
+    double traceRate = source->observedRate();
+    delete source;
+    if (traceFile) fclose(traceFile);
+
+    // Every key must read back through the chip or the cold tier, also
+    // after the image has been reloaded and its CRC checked
+    uint32_t coldMismatches = 0;
+    if (o.cold) {
+        cold.begin();
+        for (std::map<std::string, std::vector<uint8_t> >::const_iterator it = model.begin();
+             it != model.end(); ++it) {
+            size_t len = prefs.getBytes(it->first.c_str(), value.data(), value.size());
+            if (len != it->second.size() || memcmp(value.data(), it->second.data(), len) != 0) {
+                coldMismatches++;
+            }
+        }
+    }
+
+    if (!writeByteHeatmap(chip, o) || !writeBlockHeatmap(chip, o)) {
+        fprintf(stderr, "wear_sim: cannot write CSV output\n");
+        return 1;
+    }
+
+    // Projection: the hottest cell fails first, all others scale with it
+    double simSeconds = (hostMicros64() - startUs) / 1e6;
+    uint32_t peak = chip.maxByteWrites();
+    size_t peakAddr = 0;
+    for (size_t a = 0; a < chip.byteWrites().size(); a++) {
+        if (chip.byteWrites()[a] == peak) { peakAddr = a; break; }
+    }
+    double rate = o.rate > 0 ? o.rate : traceRate;
+    if (rate <= 0 && simSeconds > 0) rate = ops / simSeconds;
+    double opsToFailure = peak ? o.endurance * (double)ops / peak : 0;
+
+    printf("operations          %llu (%llu failed)\n", (unsigned long long)ops, (unsigned long long)failed);
+    printf("simulated time      %.3f s (%.1f ops/s)\n", simSeconds, simSeconds > 0 ? ops / simSeconds : 0);
+    printf("bytes programmed    %llu in %llu write transactions\n",
+           (unsigned long long)chip.totalByteWrites(), (unsigned long long)chip.pagePrograms());
+    if (o.verify) printf("unchanged bursts    %lu skipped\n", (unsigned long)prefs.skippedWrites());
+    printf("write amplification %.2f (programmed / payload)\n",
+           payloadBytes ? (double)chip.totalByteWrites() / payloadBytes : 0);
+    printf("hottest byte        0x%04zx with %u writes\n", peakAddr, peak);
+    if (peak) {
+        printf("ops to first failure %.3g at %.3g cycles endurance\n", opsToFailure, o.endurance);
+        if (rate > 0) {
+            printf("time to first failure %.3g days at %.1f ops/s\n", opsToFailure / rate / 86400.0, rate);
+        }
+    }
+    if (o.cold) {
+        printf("cold tier           %u entries, %zu image bytes, %u of %zu keys mismatched\n",
+               cold.count(), coldBackend.size(), coldMismatches, model.size());
+    }
+    printf("heatmaps            %s_bytes.csv, %s_blocks.csv\n", o.out, o.out);
+    return coldMismatches ? 1 : 0;
+}
@@ -8,6 +8,7 @@
  */
 
 #include "I2CMiniPrefs.h"
+#include "I2CMiniPrefsCold.h"
 
 /**
  * @brief Construct a new I2CMiniPrefs object
@@ -33,13 +34,200 @@ I2CMiniPrefs::I2CMiniPrefs(MemoryType memType, uint8_t i2cAddr,
       _maxValueLength(maxValueLen),
       _sdaPin(sdaPin), 
       _sclPin(sclPin), 
+      _wire(&Wire),
       _totalBlocks(0),
-      _activeBlockIndex(0)
+      _activeBlockIndex(0),
+      _traceBuf(nullptr),
+      _traceCapacity(0),
+      _traceHead(0),
+      _traceCount(0),
+      _traceDropped(0),
+      _busBytes(0),
+      _busLockFn(nullptr),
+      _busUnlockFn(nullptr),
+      _busLockCtx(nullptr),
+      _gcRunning(false),
+      _readers(0),
+      _lockStats(),
+      _writeCyclePending(false),
+      _writeCycleStartUs(0),
+      _pageSize(PREFS_EEPROM_PAGE_SIZE),
+      _burstAddr(0),
+      _burstLen(0),
+      _verifyWrites(false),
+      _skippedWrites(0),
+      _verifyAfterWrite(false),
+      _errorStats(),
+      _lastError(PREFS_ERR_NONE),
+      _busTimeoutMs(PREFS_WIRE_TIMEOUT_MS),
+      _coldTier(nullptr),
+      _coldGenerations(PREFS_COLD_GENERATIONS),
+      _coldMoved(nullptr),
+      _coldMovedCount(0),
+      _liveBytes(0),
+      _deadBytes(0),
+      _liveEntries(0),
+      _compactEpoch(0),
+      _clock(nullptr),
+      _asyncQueue(),
+      _asyncHead(0),
+      _asyncCount(0),
+      _asyncNextHandle(0),
+      _asyncPhase(0),
+      _asyncAfterFlush(0),
+      _asyncGcDone(false),
+      _asyncGcActive(false),
+      _asyncGcCarry(false),
+      _asyncGcTarget(0xFFFF)
 {
     // Validate configuration constraints
     if ((ENTRY_HEADER_SIZE + _maxKeyLength + _maxValueLength) >= _blockSizeBytes) {
         Serial.println("I2CMiniPrefs: WARNING! Max key/value length too large for block size");
     }
+
+#if PREFS_THREAD_SAFE
+    // Binary semaphore: the last reader may release what the first reader took
+    _writeSem = xSemaphoreCreateBinary();
+    xSemaphoreGive(_writeSem);
+    _readerMutex = xSemaphoreCreateMutex();
+    _busMutex = xSemaphoreCreateMutex();
+    portMUX_INITIALIZE(&_traceMux);
+#endif
+}
+
+I2CMiniPrefs::~I2CMiniPrefs() {
+#if PREFS_THREAD_SAFE
+    vSemaphoreDelete(_busMutex);
+    vSemaphoreDelete(_readerMutex);
+    vSemaphoreDelete(_writeSem);
+#endif
+}
+
+// Locking --------------------------------------------------------------------
+
+/**
+ * @brief Enter the store as a reader
+ * @return micros() when the lock was acquired
+ *
+ * Readers share the store; the first reader blocks writers and the last
+ * one lets them in again. I2C transfers are still serialized by the bus
+ * lock, so readers only overlap between transfers.
+ */
+uint32_t I2CMiniPrefs::_lockRead() {
+    uint32_t waitStartUs = micros();
+#if PREFS_THREAD_SAFE
+    xSemaphoreTake(_readerMutex, portMAX_DELAY);
+    if (_readers++ == 0) xSemaphoreTake(_writeSem, portMAX_DELAY);
+#else
+    _readers++;
+#endif
+    uint32_t acquiredUs = micros();
+    if (acquiredUs - waitStartUs > _lockStats.read.maxWaitUs) {
+        _lockStats.read.maxWaitUs = acquiredUs - waitStartUs;
+    }
+#if PREFS_THREAD_SAFE
+    xSemaphoreGive(_readerMutex);
+#endif
+    return acquiredUs;
+}
+
+/**
+ * @brief Leave the store as a reader
+ * @param acquiredUs Value returned by _lockRead()
+ */
+void I2CMiniPrefs::_unlockRead(uint32_t acquiredUs) {
+#if PREFS_THREAD_SAFE
+    xSemaphoreTake(_readerMutex, portMAX_DELAY);
+#endif
+    _recordHold(_lockStats.read, acquiredUs);
+#if PREFS_THREAD_SAFE
+    if (--_readers == 0) xSemaphoreGive(_writeSem);
+    xSemaphoreGive(_readerMutex);
+#else
+    _readers--;
+#endif
+}
+
+/**
+ * @brief Enter the store as the only writer
+ * @return micros() when the lock was acquired
+ */
+uint32_t I2CMiniPrefs::_lockWrite() {
+    uint32_t waitStartUs = micros();
+#if PREFS_THREAD_SAFE
+    xSemaphoreTake(_writeSem, portMAX_DELAY);
+#endif
+    uint32_t acquiredUs = micros();
+    if (acquiredUs - waitStartUs > _lockStats.write.maxWaitUs) {
+        _lockStats.write.maxWaitUs = acquiredUs - waitStartUs;
+    }
+    return acquiredUs;
+}
+
+/**
+ * @brief Leave the store as writer
+ * @param acquiredUs Value returned by _lockWrite()
+ */
+void I2CMiniPrefs::_unlockWrite(uint32_t acquiredUs) {
+    _recordHold(_lockStats.write, acquiredUs);
+#if PREFS_THREAD_SAFE
+    xSemaphoreGive(_writeSem);
+#endif
+}
+
+/**
+ * @brief Take the bus for one I2C transfer
+ * @param access Transfer kind reported to the user bus lock
+ * @return micros() when the lock was acquired
+ */
+uint32_t I2CMiniPrefs::_lockBus(PrefsBusAccess access) {
+    uint32_t waitStartUs = micros();
+#if PREFS_THREAD_SAFE
+    xSemaphoreTake(_busMutex, portMAX_DELAY);
+#endif
+    if (_busLockFn) _busLockFn(_busLockCtx, _gcRunning ? PREFS_BUS_BACKGROUND : access);
+    uint32_t acquiredUs = micros();
+    if (acquiredUs - waitStartUs > _lockStats.bus.maxWaitUs) {
+        _lockStats.bus.maxWaitUs = acquiredUs - waitStartUs;
+    }
+    return acquiredUs;
+}
+
+/**
+ * @brief Release the bus after one I2C transfer
+ * @param acquiredUs Value returned by _lockBus()
+ */
+void I2CMiniPrefs::_unlockBus(uint32_t acquiredUs) {
+    _recordHold(_lockStats.bus, acquiredUs);
+    if (_busLockFn && _busUnlockFn) _busUnlockFn(_busLockCtx);
+#if PREFS_THREAD_SAFE
+    xSemaphoreGive(_busMutex);
+#endif
+}
+
+/**
+ * @brief Account one lock hold; caller must own the lock
+ * @param timing Counters to update
+ * @param acquiredUs micros() when the lock was acquired
+ */
+void I2CMiniPrefs::_recordHold(PrefsLockTiming& timing, uint32_t acquiredUs) {
+    uint32_t heldUs = micros() - acquiredUs;
+    timing.acquisitions++;
+    timing.totalHoldUs += heldUs;
+    if (heldUs > timing.maxHoldUs) timing.maxHoldUs = heldUs;
+}
+
+void I2CMiniPrefs::setBusLock(PrefsBusLockFn lockFn, PrefsBusUnlockFn unlockFn, void* ctx) {
+    LockGuard lock(*this, true);
+    _busLockFn = lockFn;
+    _busUnlockFn = unlockFn;
+    _busLockCtx = ctx;
+}
+
+void I2CMiniPrefs::resetLockStats() {
+    // Bus transfers only happen under the read or write lock
+    LockGuard lock(*this, true);
+    memset(&_lockStats, 0, sizeof(_lockStats));
 }
 
 // I2C Hardware Layer --------------------------------------------------------
@@ -48,16 +236,42 @@ I2CMiniPrefs::I2CMiniPrefs(MemoryType memType, uint8_t i2cAddr,
  * @brief Write single byte to I2C memory
  * @param address Memory address
  * @param data Byte to write
+ * @return true if the chip accepted the byte
+ */
+bool I2CMiniPrefs::_i2c_write_byte(uint16_t address, byte data) {
+    return _i2c_write_bytes(address, &data, 1);
+}
+
+/**
+ * @brief Check whether the EEPROM may still be in its internal write cycle
+ * @return true until the worst-case cycle time has passed
+ *
+ * Costs no bus traffic; used by poll() to decide whether to step.
  */
-void I2CMiniPrefs::_i2c_write_byte(uint16_t address, byte data) {
-    Wire.beginTransmission(_i2cAddress);
-    Wire.write((uint8_t)(address >> 8));
-    Wire.write((uint8_t)(address & 0xFF));
-    Wire.write(data);
-    Wire.endTransmission();
+bool I2CMiniPrefs::_writeCycleBusy() {
+    if (_writeCyclePending &&
+        (uint32_t)(micros() - _writeCycleStartUs) >= PREFS_EEPROM_WRITE_CYCLE_US) {
+        _writeCyclePending = false;
+    }
+    return _writeCyclePending;
+}
 
-    // EEPROM requires write cycle delay
-    if (_memoryType == MEM_TYPE_EEPROM) delay(5); 
+/**
+ * @brief Block until a pending EEPROM write cycle has finished
+ *
+ * Acknowledge polling: the chip NACKs its address while programming, so
+ * the wait ends as soon as it answers rather than after the worst case.
+ */
+void I2CMiniPrefs::_waitWriteCycle() {
+    while (_writeCycleBusy()) {
+        uint32_t busStartUs = _lockBus(PREFS_BUS_READ);
+        _wire->beginTransmission(_i2cAddress);
+        bool ack = _wire->endTransmission() == 0;
+        _busBytes += 1;
+        _unlockBus(busStartUs);
+        if (ack) break;
+    }
+    _writeCyclePending = false;
 }
 
 /**
@@ -66,12 +280,18 @@ void I2CMiniPrefs::_i2c_write_byte(uint16_t address, byte data) {
  * @return Read byte (0xFF on error)
  */
 byte I2CMiniPrefs::_i2c_read_byte(uint16_t address) {
-    Wire.beginTransmission(_i2cAddress);
-    Wire.write((uint8_t)(address >> 8));
-    Wire.write((uint8_t)(address & 0xFF));
-    Wire.endTransmission();
-    Wire.requestFrom(_i2cAddress, 1);
-    return Wire.available() ? Wire.read() : 0xFF;
+    _waitWriteCycle();
+    uint32_t busStartUs = _lockBus(PREFS_BUS_READ);
+    _wire->beginTransmission(_i2cAddress);
+    _wire->write((uint8_t)(address >> 8));
+    _wire->write((uint8_t)(address & 0xFF));
+    uint8_t result = _wire->endTransmission();
+    uint8_t received = result == 0 ? _wire->requestFrom(_i2cAddress, 1) : 0;
+    _busBytes += 5;
+    byte data = _wire->available() ? _wire->read() : 0xFF;
+    _unlockBus(busStartUs);
+    if (received != 1) _recordError(result ? _errorFromWire(result) : PREFS_ERR_READ);
+    return data;
 }
 
 /**
@@ -79,12 +299,136 @@ byte I2CMiniPrefs::_i2c_read_byte(uint16_t address) {
  * @param address Starting memory address
  * @param data Data buffer
  * @param len Data length
+ *
+ * Returns as soon as the last burst is on the bus. An EEPROM then
+ * programs it for up to PREFS_EEPROM_WRITE_CYCLE_US; the next access
+ * waits for that cycle, so CRC, header and GC work in between overlaps
+ * with it.
+ *
+ * @return true if every burst was accepted (see _i2c_flush())
  */
-void I2CMiniPrefs::_i2c_write_bytes(uint16_t address, const byte* data, size_t len) {
-    for (size_t i = 0; i < len; i++) {
-        _i2c_write_byte(address + i, data[i]);
+bool I2CMiniPrefs::_i2c_write_bytes(uint16_t address, const byte* data, size_t len) {
+    bool ok = _i2c_queue_bytes(address, data, len);
+    return _i2c_flush() && ok;
+}
+
+/**
+ * @brief Append bytes to the pending write burst
+ * @param address Starting memory address
+ * @param data Data buffer
+ * @param len Data length
+ *
+ * Contiguous calls are combined into one transfer per EEPROM page (or
+ * Wire buffer). A burst is sent when it reaches such a boundary, when
+ * the next address is not contiguous, or by _i2c_flush(), which must be
+ * called before the next read.
+ *
+ * @return false if a burst sent by this call failed
+ */
+bool I2CMiniPrefs::_i2c_queue_bytes(uint16_t address, const byte* data, size_t len) {
+    const uint8_t maxBurst = sizeof(_burstBuf);
+    bool ok = true;
+    if (_burstLen > 0 && address != (uint16_t)(_burstAddr + _burstLen)) ok = _i2c_flush();
+
+    while (len > 0) {
+        if (_burstLen == 0) _burstAddr = address;
+
+        size_t chunk = min(len, (size_t)(maxBurst - _burstLen));
+        if (_memoryType == MEM_TYPE_EEPROM) {
+            chunk = min(chunk, (size_t)(_pageSize - (address % _pageSize)));
+        }
+        memcpy(_burstBuf + _burstLen, data, chunk);
+        _burstLen += chunk;
+        address += chunk;
+        data += chunk;
+        len -= chunk;
+
+        if (_burstLen >= maxBurst ||
+            (_memoryType == MEM_TYPE_EEPROM && (address % _pageSize) == 0)) {
+            ok = _i2c_flush() && ok;
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief Send the pending write burst, if any
+ * @return true if the chip accepted (and, if enabled, verified) the burst
+ *
+ * With setVerifyBeforeWrite() an EEPROM burst is first compared with the
+ * chip contents and skipped if nothing would change. A NACKed burst is
+ * resent up to PREFS_WRITE_RETRIES times, each after a full write cycle;
+ * with setVerifyAfterWrite() a burst that reads back differently counts
+ * as failed as well.
+ */
+bool I2CMiniPrefs::_i2c_flush() {
+    if (_burstLen == 0) return true;
+    uint8_t len = _burstLen;
+    _burstLen = 0;
+
+    if (_i2c_unchanged(_burstAddr, _burstBuf, len)) {
+        _skippedWrites++;
+        return true;
+    }
+
+    for (uint8_t attempt = 0; attempt <= PREFS_WRITE_RETRIES; attempt++) {
+        if (attempt > 0) _errorStats.retries++;
+        _waitWriteCycle();
+        if (!_i2c_send_burst(_burstAddr, _burstBuf, len)) continue;
+        if (!_verifyAfterWrite || _i2c_verify_burst(_burstAddr, _burstBuf, len)) return true;
+    }
+    _errorStats.failedWrites++;
+    return false;
+}
+
+/**
+ * @brief Whether a burst would leave the chip contents unchanged
+ * @return true only with setVerifyBeforeWrite() on an EEPROM whose bytes
+ *         already match
+ */
+bool I2CMiniPrefs::_i2c_unchanged(uint16_t address, const byte* data, uint8_t len) {
+    if (!_verifyWrites || _memoryType != MEM_TYPE_EEPROM) return false;
+    byte current[sizeof(_burstBuf)];
+    return _i2c_read_bytes(address, current, len) && memcmp(current, data, len) == 0;
+}
+
+/**
+ * @brief Send one write burst without waiting for the chip
+ * @return true if the chip acknowledged every byte
+ *
+ * Starts the write cycle the next access waits for; a NACK starts one as
+ * well, since it usually means the chip is still busy (FRAM included).
+ */
+bool I2CMiniPrefs::_i2c_send_burst(uint16_t address, const byte* data, uint8_t len) {
+    uint32_t busStartUs = _lockBus(PREFS_BUS_WRITE);
+    _wire->beginTransmission(_i2cAddress);
+    _wire->write((uint8_t)(address >> 8));
+    _wire->write((uint8_t)(address & 0xFF));
+    _wire->write(data, len);
+    uint8_t result = _wire->endTransmission();
+    _busBytes += 3 + len;
+    _unlockBus(busStartUs);
+
+    _writeCyclePending = result != 0 || _memoryType == MEM_TYPE_EEPROM;
+    _writeCycleStartUs = micros();
+    if (result != 0) {
+        PrefsError error = _errorFromWire(result);
+        _recordError(error);
+        if (error == PREFS_ERR_BUS) _recoverBus();
+        return false;
     }
-    if (_memoryType == MEM_TYPE_EEPROM) delay(1);
+    return true;
+}
+
+/**
+ * @brief Read a sent burst back (setVerifyAfterWrite())
+ * @return true if the chip holds the burst; waits for its write cycle
+ */
+bool I2CMiniPrefs::_i2c_verify_burst(uint16_t address, const byte* data, uint8_t len) {
+    byte readBack[sizeof(_burstBuf)];
+    if (_i2c_read_bytes(address, readBack, len) && memcmp(readBack, data, len) == 0) return true;
+    _recordError(PREFS_ERR_VERIFY);
+    return false;
 }
 
 /**
@@ -92,16 +436,158 @@ void I2CMiniPrefs::_i2c_write_bytes(uint16_t address, const byte* data, size_t l
  * @param address Starting memory address
  * @param buffer Output buffer
  * @param len Bytes to read
+ * @return false if the chip did not deliver every byte (missing bytes
+ *         read as 0xFF)
  */
-void I2CMiniPrefs::_i2c_read_bytes(uint16_t address, byte* buffer, size_t len) {
-    Wire.beginTransmission(_i2cAddress);
-    Wire.write((uint8_t)(address >> 8));
-    Wire.write((uint8_t)(address & 0xFF));
-    Wire.endTransmission();
-    Wire.requestFrom(_i2cAddress, len);
-    for (size_t i = 0; i < len; i++) {
-        buffer[i] = Wire.available() ? Wire.read() : 0xFF;
+bool I2CMiniPrefs::_i2c_read_bytes(uint16_t address, byte* buffer, size_t len) {
+    bool ok = true;
+    _waitWriteCycle();
+    // Split into bursts the Wire receive buffer can hold
+    while (len > 0) {
+        size_t chunk = min(len, (size_t)PREFS_I2C_BUFFER_SIZE);
+        uint32_t busStartUs = _lockBus(PREFS_BUS_READ);
+        _wire->beginTransmission(_i2cAddress);
+        _wire->write((uint8_t)(address >> 8));
+        _wire->write((uint8_t)(address & 0xFF));
+        uint8_t result = _wire->endTransmission();
+        size_t received = result == 0 ? _wire->requestFrom(_i2cAddress, chunk) : 0;
+        _busBytes += 4 + chunk;
+        for (size_t i = 0; i < chunk; i++) {
+            buffer[i] = _wire->available() ? _wire->read() : 0xFF;
+        }
+        _unlockBus(busStartUs);
+        if (received != chunk) {
+            _recordError(result ? _errorFromWire(result) : PREFS_ERR_READ);
+            ok = false;
+        }
+        address += chunk;
+        buffer += chunk;
+        len -= chunk;
+    }
+    return ok;
+}
+
+/**
+ * @brief Map a Wire.endTransmission() result to an error kind
+ * @param result Non-zero result code
+ */
+PrefsError I2CMiniPrefs::_errorFromWire(uint8_t result) {
+    switch (result) {
+        case 2:  return PREFS_ERR_ADDRESS_NACK;
+        case 3:  return PREFS_ERR_DATA_NACK;
+        default: return PREFS_ERR_BUS;
+    }
+}
+
+/**
+ * @brief Remember and count an I2C failure
+ * @param error Failure kind
+ *
+ * Concurrent readers fail transfers too, so the update is serialized
+ * like the read statistics.
+ */
+void I2CMiniPrefs::_recordError(PrefsError error) {
+#if PREFS_THREAD_SAFE
+    xSemaphoreTake(_readerMutex, portMAX_DELAY);
+#endif
+    _lastError = error;
+    switch (error) {
+        case PREFS_ERR_ADDRESS_NACK: _errorStats.addressNacks++; break;
+        case PREFS_ERR_DATA_NACK:    _errorStats.dataNacks++; break;
+        case PREFS_ERR_BUS:          _errorStats.busErrors++; break;
+        case PREFS_ERR_VERIFY:       _errorStats.verifyErrors++; break;
+        case PREFS_ERR_READ:         _errorStats.readErrors++; break;
+        default: break;
+    }
+#if PREFS_THREAD_SAFE
+    xSemaphoreGive(_readerMutex);
+#endif
+}
+
+void I2CMiniPrefs::resetErrorStats() {
+    LockGuard lock(*this, true);
+    memset(&_errorStats, 0, sizeof(_errorStats));
+    _lastError = PREFS_ERR_NONE;
+}
+
+/**
+ * @brief Initialize Wire with the configured pins, clock and timeout
+ */
+void I2CMiniPrefs::_beginWire() {
+    // Initialize I2C with custom or default pins
+    if (_sdaPin != -1 && _sclPin != -1) {
+        _wire->begin(_sdaPin, _sclPin);
+    } else {
+        _wire->begin();
+    }
+
+    // Set high speed for FRAM, normal for EEPROM
+    _memoryType == MEM_TYPE_FRAM ? _wire->setClock(1000000) : _wire->setClock(100000);
+
+    // Bound every transfer so a stuck bus fails fast instead of hanging
+#if defined(WIRE_HAS_TIMEOUT)
+    _wire->setWireTimeout((uint32_t)_busTimeoutMs * 1000, true);
+#elif defined(ESP32)
+    _wire->setTimeOut(_busTimeoutMs);
+#endif
+}
+
+/**
+ * @brief Check whether the chip acknowledges its address
+ */
+bool I2CMiniPrefs::_devicePresent() {
+    uint32_t busStartUs = _lockBus(PREFS_BUS_READ);
+    _wire->beginTransmission(_i2cAddress);
+    uint8_t result = _wire->endTransmission();
+    _busBytes += 1;
+    _unlockBus(busStartUs);
+    if (result != 0) _recordError(_errorFromWire(result));
+    return result == 0;
+}
+
+/**
+ * @brief Free a bus whose SDA line is held low by a slave
+ * @return true if the chip answers afterwards
+ *
+ * A slave interrupted mid-byte (brownout, master reset) keeps driving SDA
+ * until it has clocked out its byte. Up to nine SCL pulses let it finish;
+ * a STOP condition then resets its state machine.
+ *
+ * The default SDA/SCL pins belong to Wire. Another controller is only
+ * recovered when its pins were passed to the constructor; clocking the
+ * default pins would disturb Wire's bus instead.
+ */
+bool I2CMiniPrefs::_recoverBus() {
+    bool customPins = _sdaPin >= 0 && _sclPin >= 0;
+    if (!customPins && _wire != &Wire) return false;
+    uint8_t sda = customPins ? _sdaPin : SDA;
+    uint8_t scl = customPins ? _sclPin : SCL;
+    _errorStats.busRecoveries++;
+
+    uint32_t busStartUs = _lockBus(PREFS_BUS_WRITE);
+    _wire->end();
+    pinMode(sda, INPUT_PULLUP);
+    pinMode(scl, INPUT_PULLUP);
+    delayMicroseconds(5);
+    for (uint8_t i = 0; i < 9 && digitalRead(sda) == LOW; i++) {
+        digitalWrite(scl, LOW);
+        pinMode(scl, OUTPUT);
+        delayMicroseconds(5);
+        pinMode(scl, INPUT_PULLUP);
+        delayMicroseconds(5);
     }
+
+    // STOP condition: SDA rises while SCL is high
+    digitalWrite(sda, LOW);
+    pinMode(sda, OUTPUT);
+    delayMicroseconds(5);
+    pinMode(sda, INPUT_PULLUP);
+    delayMicroseconds(5);
+    bool released = digitalRead(sda) == HIGH && digitalRead(scl) == HIGH;
+
+    _beginWire();
+    _unlockBus(busStartUs);
+    return released && _devicePresent();
 }
 
 // Core Algorithms ------------------------------------------------------------
@@ -110,10 +596,10 @@ void I2CMiniPrefs::_i2c_read_bytes(uint16_t address, byte* buffer, size_t len) {
  * @brief Calculate CRC8 checksum
  * @param data Input buffer
  * @param len Data length
+ * @param crc Initial value (previous result to continue a running CRC)
  * @return CRC8 checksum
  */
-uint8_t I2CMiniPrefs::_calculateCrc8(const byte* data, size_t len) {
-    uint8_t crc = 0x00;
+uint8_t I2CMiniPrefs::_calculateCrc8(const byte* data, size_t len, uint8_t crc) {
     for (size_t i = 0; i < len; i++) {
         crc ^= data[i];
         for (uint8_t j = 0; j < 8; j++) {
@@ -148,13 +634,13 @@ uint16_t I2CMiniPrefs::_getBlockAddress(uint16_t blockIndex) {
 /**
  * @brief Read global header from memory
  * @param[out] header Reference to header struct
- * @return true if header is valid, false otherwise
+ * @return true if header is valid, false otherwise (or on a bus failure)
  */
 bool I2CMiniPrefs::_readGlobalHeader(GlobalHeader& header) {
-    _i2c_read_bytes(0, (byte*)&header, sizeof(GlobalHeader));
+    if (!_i2c_read_bytes(0, (byte*)&header, sizeof(GlobalHeader))) return false;
     return (header.magic == PREFS_MAGIC &&
             header.version == PREFS_VERSION &&
-            _calculateCrc8((byte*)&header, sizeof(GlobalHeader) - 1) == header.checksum);
+            _calculateCrc8((byte*)&header, offsetof(GlobalHeader, checksum)) == header.checksum);
 }
 
 /**
@@ -164,9 +650,8 @@ bool I2CMiniPrefs::_readGlobalHeader(GlobalHeader& header) {
  */
 bool I2CMiniPrefs::_writeGlobalHeader(const GlobalHeader& header) {
     GlobalHeader tempHeader = header;
-    tempHeader.checksum = _calculateCrc8((byte*)&tempHeader, sizeof(GlobalHeader) - 1);
-    _i2c_write_bytes(0, (byte*)&tempHeader, sizeof(GlobalHeader));
-    return true;
+    tempHeader.checksum = _calculateCrc8((byte*)&tempHeader, offsetof(GlobalHeader, checksum));
+    return _i2c_write_bytes(0, (byte*)&tempHeader, sizeof(GlobalHeader));
 }
 
 /**
@@ -178,10 +663,7 @@ bool I2CMiniPrefs::_writeGlobalHeader(const GlobalHeader& header) {
 bool I2CMiniPrefs::_readBlockHeader(uint16_t blockIndex, BlockHeader& header) {
     uint16_t addr = _getBlockAddress(blockIndex);
     _i2c_read_bytes(addr, (byte*)&header, sizeof(BlockHeader));
-    byte crcData[3] = {header.status, 
-                      (byte)(header.currentOffset & 0xFF),
-                      (byte)((header.currentOffset >> 8) & 0xFF)};
-    return (_calculateCrc8(crcData, sizeof(crcData)) == header.checksum;
+    return _blockHeaderCrc(header) == header.checksum;
 }
 
 /**
@@ -193,12 +675,20 @@ bool I2CMiniPrefs::_readBlockHeader(uint16_t blockIndex, BlockHeader& header) {
 bool I2CMiniPrefs::_writeBlockHeader(uint16_t blockIndex, const BlockHeader& header) {
     uint16_t addr = _getBlockAddress(blockIndex);
     BlockHeader tempHeader = header;
+    tempHeader.checksum = _blockHeaderCrc(header);
+    return _i2c_write_bytes(addr, (byte*)&tempHeader, sizeof(BlockHeader));
+}
+
+/**
+ * @brief Calculate block header checksum
+ * @param header Block header (checksum field ignored)
+ * @return CRC8 over status and little-endian offset
+ */
+uint8_t I2CMiniPrefs::_blockHeaderCrc(const BlockHeader& header) {
     byte crcData[3] = {header.status,
                       (byte)(header.currentOffset & 0xFF),
                       (byte)((header.currentOffset >> 8) & 0xFF)};
-    tempHeader.checksum = _calculateCrc8(crcData, sizeof(crcData));
-    _i2c_write_bytes(addr, (byte*)&tempHeader, sizeof(BlockHeader));
-    return true;
+    return _calculateCrc8(crcData, sizeof(crcData));
 }
 
 /**
@@ -213,45 +703,91 @@ uint16_t I2CMiniPrefs::_findEntry(const char* key, uint16_t& entryValueAddress,
                                 uint16_t& entryValueLength, PrefDataType& entryDataType) {
     if (!_isInitialized) return 0;
 
-    uint16_t targetKeyHash = _hashKey(key);
-    uint8_t targetKeyLen = strlen(key);
-
     for (uint16_t blockIdx = 0; blockIdx < _totalBlocks; blockIdx++) {
         BlockHeader blockHeader;
         if (!_readBlockHeader(blockIdx, blockHeader)) continue;
         if (blockHeader.status != BLOCK_STATUS_ACTIVE && 
             blockHeader.status != BLOCK_STATUS_VALID) continue;
 
-        uint16_t currentEntryOffset = BLOCK_HEADER_SIZE;
-        uint16_t blockStartAddr = _getBlockAddress(blockIdx);
+        EntryHeader entryHeader;
+        uint16_t entryHeaderAddr = _findEntryInBlock(blockIdx, blockHeader.currentOffset,
+                                                     key, entryHeader);
+        if (entryHeaderAddr != 0) {
+            entryValueAddress = entryHeaderAddr + ENTRY_HEADER_SIZE + entryHeader.keyLength;
+            entryValueLength = entryHeader.valueLength;
+            entryDataType = (PrefDataType)entryHeader.dataType;
+            return entryHeaderAddr;
+        }
+    }
+    return 0;
+}
 
-        while (currentEntryOffset < blockHeader.currentOffset) {
-            EntryHeader entryHeader;
-            uint16_t entryHeaderAddr = blockStartAddr + currentEntryOffset;
-            _i2c_read_bytes(entryHeaderAddr, (byte*)&entryHeader, sizeof(EntryHeader));
+/**
+ * @brief Find the current value of key, hiding expired TTL entries
+ * @param key Null-terminated key string
+ * @param[out] entryValueAddress Address of the value (after a TTL stamp)
+ * @param[out] entryValueLength Length of the value (without a TTL stamp)
+ * @param[out] entryDataType Stored type without PREFS_TTL_FLAG
+ * @return Entry header address or 0 if missing or expired
+ */
+uint16_t I2CMiniPrefs::_findLiveEntry(const char* key, uint16_t& entryValueAddress, 
+                                      uint16_t& entryValueLength, PrefDataType& entryDataType) {
+    uint16_t entryAddr = _findEntry(key, entryValueAddress, entryValueLength, entryDataType);
+    if (entryAddr == 0 || !(entryDataType & PREFS_TTL_FLAG)) return entryAddr;
+    if (_expired(entryDataType, entryValueAddress, entryValueLength)) return 0;
+    entryDataType = (PrefDataType)(entryDataType & ~PREFS_TTL_FLAG);
+    entryValueAddress += PREFS_TTL_STAMP_SIZE;
+    entryValueLength -= PREFS_TTL_STAMP_SIZE;
+    return entryAddr;
+}
 
-            // Skip deleted entries
-            if (entryHeader.status == 0x00) {
-                currentEntryOffset += (ENTRY_HEADER_SIZE + entryHeader.keyLength + entryHeader.valueLength);
-                continue;
-            }
+/**
+ * @brief Whether a TTL entry has passed its expiry time
+ * @param dataType Stored type byte
+ * @param valueAddr Address of the stored value (the stamp comes first)
+ * @param valueLen Stored value length
+ * @return false for entries without PREFS_TTL_FLAG or without a clock
+ */
+bool I2CMiniPrefs::_expired(uint8_t dataType, uint16_t valueAddr, uint16_t valueLen) {
+    if (!(dataType & PREFS_TTL_FLAG)) return false;
+    if (valueLen < PREFS_TTL_STAMP_SIZE) return true;   // Truncated, unusable
+    if (!_clock) return false;
+    uint32_t expiry;
+    if (!_i2c_read_bytes(valueAddr, (byte*)&expiry, sizeof(expiry))) return false;
+    // Wrap-safe: expired once the clock has reached the stamp
+    return (int32_t)(_clock() - expiry) >= 0;
+}
 
-            // Hash and length match
-            if (entryHeader.keyHash == targetKeyHash && entryHeader.keyLength == targetKeyLen) {
-                char readKey[_maxKeyLength + 1];
-                _i2c_read_bytes(entryHeaderAddr + ENTRY_HEADER_SIZE, (byte*)readKey, targetKeyLen);
-                readKey[targetKeyLen] = '\0';
-                
-                // Full key match
-                if (strcmp(key, readKey) == 0) {
-                    entryValueAddress = entryHeaderAddr + ENTRY_HEADER_SIZE + entryHeader.keyLength;
-                    entryValueLength = entryHeader.valueLength;
-                    entryDataType = (PrefDataType)entryHeader.dataType;
-                    return entryHeaderAddr;
-                }
-            }
-            currentEntryOffset += (ENTRY_HEADER_SIZE + entryHeader.keyLength + entryHeader.valueLength);
+/**
+ * @brief Find live entry by key within one block
+ * @param blockIndex Block to scan
+ * @param endOffset Block write offset (end of entries)
+ * @param key Null-terminated key string
+ * @param[out] entryHeader Header of the matching entry
+ * @return Entry header address or 0 if not found
+ */
+uint16_t I2CMiniPrefs::_findEntryInBlock(uint16_t blockIndex, uint16_t endOffset,
+                                         const char* key, EntryHeader& entryHeader) {
+    uint16_t targetKeyHash = _hashKey(key);
+    uint8_t targetKeyLen = strlen(key);
+    uint16_t currentEntryOffset = BLOCK_HEADER_SIZE;
+    uint16_t blockStartAddr = _getBlockAddress(blockIndex);
+
+    while (currentEntryOffset < endOffset) {
+        uint16_t entryHeaderAddr = blockStartAddr + currentEntryOffset;
+        _i2c_read_bytes(entryHeaderAddr, (byte*)&entryHeader, sizeof(EntryHeader));
+
+        // Hash and length match on live entries
+        if (entryHeader.status != 0x00 &&
+            entryHeader.keyHash == targetKeyHash && entryHeader.keyLength == targetKeyLen) {
+            char readKey[_maxKeyLength + 1];
+            _i2c_read_bytes(entryHeaderAddr + ENTRY_HEADER_SIZE, (byte*)readKey, targetKeyLen);
+            readKey[targetKeyLen] = '\0';
+
+            // Full key match
+            if (strcmp(key, readKey) == 0) return entryHeaderAddr;
         }
+        currentEntryOffset += (ENTRY_HEADER_SIZE + entryHeader.keyLength + entryHeader.valueLength);
     }
     return 0;
 }
@@ -271,22 +807,56 @@ bool I2CMiniPrefs::_writeEntry(const char* key, PrefDataType type,
     uint8_t keyLen = strlen(key);
     if (keyLen > _maxKeyLength || valueLen > _maxValueLength) return false;
 
-    // Remove existing entry if present
     uint16_t oldValueAddr, oldValueLen;
     PrefDataType oldDataType;
     uint16_t oldEntryHeaderAddr = _findEntry(key, oldValueAddr, oldValueLen, oldDataType);
-    if (oldEntryHeaderAddr != 0) _markEntryAsDeleted(oldEntryHeaderAddr);
+    return _replaceEntry(key, type, valueBuf, valueLen, oldEntryHeaderAddr, oldValueLen);
+}
 
+/**
+ * @brief Append an entry that supersedes an already located one
+ * @param key Null-terminated key string (length checked by the caller)
+ * @param type Data type identifier
+ * @param valueBuf Pointer to value data
+ * @param valueLen Length of value data
+ * @param oldEntryHeaderAddr Current entry of key, 0 if none
+ * @param oldValueLen Value length of that entry
+ * @return true on success, false on error
+ */
+bool I2CMiniPrefs::_replaceEntry(const char* key, PrefDataType type, const void* valueBuf,
+                                 size_t valueLen, uint16_t oldEntryHeaderAddr, uint16_t oldValueLen) {
+    uint8_t keyLen = strlen(key);
     BlockHeader currentBlockHeader;
     if (!_readBlockHeader(_activeBlockIndex, currentBlockHeader) || 
         currentBlockHeader.status != BLOCK_STATUS_ACTIVE) {
         return false;
     }
 
-    // Check if block has space
+    // Check if block has space; a full store fails before the old value
+    // is touched
     uint16_t entryTotalSize = ENTRY_HEADER_SIZE + keyLen + valueLen;
-    if ((currentBlockHeader.currentOffset + entryTotalSize) > _blockSizeBytes) {
-        if (!_runGarbageCollection()) return false;
+    bool needGc = (currentBlockHeader.currentOffset + entryTotalSize) > _blockSizeBytes;
+    if (needGc) {
+        uint32_t oldEntrySize = oldEntryHeaderAddr ? ENTRY_HEADER_SIZE + keyLen + oldValueLen : 0;
+        uint32_t keptBytes = _coldTier ? _liveEntryBytes(_coldMoveLimit()) : _liveBytes;
+        // The counters include expired TTL entries, which GC drops
+        if (!_coldTier && BLOCK_HEADER_SIZE + keptBytes - oldEntrySize + entryTotalSize > _blockSizeBytes) {
+            keptBytes = _liveEntryBytes();
+        }
+        if (BLOCK_HEADER_SIZE + keptBytes - oldEntrySize + entryTotalSize > _blockSizeBytes) {
+            return false;
+        }
+    }
+
+    // Remove existing entry if present
+    if (oldEntryHeaderAddr != 0 && !_markEntryAsDeleted(oldEntryHeaderAddr)) return false;
+
+    if (needGc) {
+        uint32_t gcStartUs = _traceBuf ? micros() : 0;
+        uint32_t gcStartBus = _busBytes;
+        bool gcOk = _runGarbageCollection();
+        _traceRecord(PREFS_TRACE_GC, 0, 0, gcOk, gcStartUs, gcStartBus);
+        if (!gcOk) return false;
         if (!_readBlockHeader(_activeBlockIndex, currentBlockHeader) || 
             currentBlockHeader.status != BLOCK_STATUS_ACTIVE) {
             return false;
@@ -295,21 +865,42 @@ bool I2CMiniPrefs::_writeEntry(const char* key, PrefDataType type,
 
     // Write new entry
     uint16_t entryStartAddr = _getBlockAddress(_activeBlockIndex) + currentBlockHeader.currentOffset;
+    if (!_writeEntryData(entryStartAddr, key, keyLen, type, valueBuf, valueLen)) return false;
+
+    // Update block header
+    currentBlockHeader.currentOffset += entryTotalSize;
+    if (!_writeBlockHeader(_activeBlockIndex, currentBlockHeader)) return false;
+    _liveBytes += entryTotalSize;
+    _liveEntries++;
+    return true;
+}
+
+/**
+ * @brief Write entry header, key and value at a given address
+ * @param entryStartAddr Address of the entry header
+ * @param key Key characters (not null-terminated on storage)
+ * @param keyLen Key length
+ * @param type Data type identifier
+ * @param valueBuf Pointer to value data
+ * @param valueLen Length of value data
+ * @return true if all bytes were written
+ */
+bool I2CMiniPrefs::_writeEntryData(uint16_t entryStartAddr, const char* key, uint8_t keyLen,
+                                   PrefDataType type, const void* valueBuf, size_t valueLen) {
     EntryHeader newEntryHeader = {
         .status = 0x01,
         .dataType = static_cast<uint8_t>(type),
         .keyHash = _hashKey(key),
         .keyLength = keyLen,
+        .age = 0,
         .valueLength = static_cast<uint16_t>(valueLen)
     };
-    
-    _i2c_write_bytes(entryStartAddr, (byte*)&newEntryHeader, sizeof(EntryHeader));
-    _i2c_write_bytes(entryStartAddr + ENTRY_HEADER_SIZE, (const byte*)key, keyLen);
-    _i2c_write_bytes(entryStartAddr + ENTRY_HEADER_SIZE + keyLen, (const byte*)valueBuf, valueLen);
 
-    // Update block header
-    currentBlockHeader.currentOffset += entryTotalSize;
-    return _writeBlockHeader(_activeBlockIndex, currentBlockHeader);
+    // Header, key and value are contiguous: one burst per page
+    bool ok = _i2c_queue_bytes(entryStartAddr, (byte*)&newEntryHeader, sizeof(EntryHeader));
+    ok = _i2c_queue_bytes(entryStartAddr + ENTRY_HEADER_SIZE, (const byte*)key, keyLen) && ok;
+    ok = _i2c_queue_bytes(entryStartAddr + ENTRY_HEADER_SIZE + keyLen, (const byte*)valueBuf, valueLen) && ok;
+    return _i2c_flush() && ok;
 }
 
 /**
@@ -323,98 +914,370 @@ bool I2CMiniPrefs::_markEntryAsDeleted(uint16_t entryAddress) {
     _i2c_read_bytes(entryAddress, (byte*)&header, sizeof(EntryHeader));
     if (header.status != 0x01) return false;
     header.status = 0x00;
-    _i2c_write_byte(entryAddress, header.status);
+    if (!_i2c_write_byte(entryAddress, header.status)) return false;
+    uint16_t entryTotalSize = ENTRY_HEADER_SIZE + header.keyLength + header.valueLength;
+    _liveBytes -= min((uint32_t)entryTotalSize, _liveBytes);
+    _deadBytes += entryTotalSize;
+    if (_liveEntries > 0) _liveEntries--;
     return true;
 }
 
 /**
- * @brief Perform garbage collection and wear leveling
- * @return true on success, false on error
- * 
- * Steps:
- * 1. Find empty block for new active block
- * 2. Copy valid entries from all blocks
- * 3. Mark old blocks as empty
- * 4. Update global header
+ * @brief Recount the usage statistics from the entry headers
+ *
+ * Seeds the counters at begin() and resynchronizes them after an
+ * operation that failed halfway.
  */
-bool I2CMiniPrefs::_runGarbageCollection() {
-    uint16_t nextEmptyBlockIndex = 0xFFFF;
-    for (uint16_t i = 0; i < _totalBlocks; i++) {
-        BlockHeader header;
-        if (!_readBlockHeader(i, header) || header.status == BLOCK_STATUS_EMPTY) {
-            nextEmptyBlockIndex = i;
-            break;
-        }
-    }
-
-    if (nextEmptyBlockIndex == 0xFFFF) return false;
-
-    // Mark current active block as valid
-    if (_isInitialized) {
-        BlockHeader oldActiveBlockHeader;
-        if (_readBlockHeader(_activeBlockIndex, oldActiveBlockHeader)) {
-            oldActiveBlockHeader.status = BLOCK_STATUS_VALID;
-            _writeBlockHeader(_activeBlockIndex, oldActiveBlockHeader);
-        }
-    }
-
-    // Initialize new active block
-    BlockHeader newActiveBlockHeader = {
-        .status = BLOCK_STATUS_ACTIVE,
-        .currentOffset = BLOCK_HEADER_SIZE
-    };
-    _writeBlockHeader(nextEmptyBlockIndex, newActiveBlockHeader);
-    uint16_t currentWriteOffset = BLOCK_HEADER_SIZE;
-    uint16_t newBlockAddr = _getBlockAddress(nextEmptyBlockIndex);
-
-    // Copy valid entries
+void I2CMiniPrefs::_scanUsage() {
+    _liveBytes = 0;
+    _deadBytes = 0;
+    _liveEntries = 0;
     for (uint16_t blockIdx = 0; blockIdx < _totalBlocks; blockIdx++) {
-        if (blockIdx == nextEmptyBlockIndex) continue;
-
-        BlockHeader sourceBlockHeader;
-        if (!_readBlockHeader(blockIdx, sourceBlockHeader)) continue;
-        if (sourceBlockHeader.status != BLOCK_STATUS_ACTIVE && 
-            sourceBlockHeader.status != BLOCK_STATUS_VALID) continue;
-
-        uint16_t currentReadOffset = BLOCK_HEADER_SIZE;
-        uint16_t sourceBlockAddr = _getBlockAddress(blockIdx);
+        BlockHeader blockHeader;
+        if (!_readBlockHeader(blockIdx, blockHeader)) continue;
+        if (blockHeader.status != BLOCK_STATUS_ACTIVE && 
+            blockHeader.status != BLOCK_STATUS_VALID) continue;
 
-        while (currentReadOffset < sourceBlockHeader.currentOffset) {
+        uint16_t currentOffset = BLOCK_HEADER_SIZE;
+        uint16_t blockAddr = _getBlockAddress(blockIdx);
+        while (currentOffset < blockHeader.currentOffset) {
             EntryHeader entryHeader;
-            uint16_t entryHeaderAddr = sourceBlockAddr + currentReadOffset;
-            _i2c_read_bytes(entryHeaderAddr, (byte*)&entryHeader, sizeof(EntryHeader));
+            _i2c_read_bytes(blockAddr + currentOffset, (byte*)&entryHeader, sizeof(EntryHeader));
             uint16_t entryTotalSize = ENTRY_HEADER_SIZE + entryHeader.keyLength + entryHeader.valueLength;
-
-            // Only copy valid entries
             if (entryHeader.status == 0x01 && 
                 entryHeader.keyLength <= _maxKeyLength && 
                 entryHeader.valueLength <= _maxValueLength) {
-                
-                if ((currentWriteOffset + entryTotalSize) > _blockSizeBytes) return false;
-                
-                byte* entryData = new byte[entryTotalSize];
-                _i2c_read_bytes(entryHeaderAddr, entryData, entryTotalSize);
-                _i2c_write_bytes(newBlockAddr + currentWriteOffset, entryData, entryTotalSize);
-                delete[] entryData;
-                
-                currentWriteOffset += entryTotalSize;
+                _liveBytes += entryTotalSize;
+                _liveEntries++;
+            } else {
+                _deadBytes += entryTotalSize;
             }
-            currentReadOffset += entryTotalSize;
+            currentOffset += entryTotalSize;
         }
-
-        // Mark source block as empty
-        sourceBlockHeader.status = BLOCK_STATUS_EMPTY;
-        sourceBlockHeader.currentOffset = BLOCK_HEADER_SIZE;
-        _writeBlockHeader(blockIdx, sourceBlockHeader);
     }
+}
 
-    // Finalize new block
-    newActiveBlockHeader.currentOffset = currentWriteOffset;
-    _writeBlockHeader(nextEmptyBlockIndex, newActiveBlockHeader);
-    _activeBlockIndex = nextEmptyBlockIndex;
+/**
+ * @brief Delete the entry an interrupted asynchronous put left live
+ * @return false if deleting it failed
+ *
+ * putAsync() commits the new entry before it marks the replaced one as
+ * deleted, so a cut in between leaves two live entries for the key.
+ * Only the last entry of the active block can be that newer copy; any
+ * older entry of its key is the superseded one.
+ */
+bool I2CMiniPrefs::_dropSuperseded() {
+    BlockHeader activeHeader;
+    if (!_readBlockHeader(_activeBlockIndex, activeHeader)) return true;
+    uint16_t blockAddr = _getBlockAddress(_activeBlockIndex);
+    uint16_t currentOffset = BLOCK_HEADER_SIZE;
+    uint16_t lastOffset = 0;
+    EntryHeader entryHeader;
+    while (currentOffset < activeHeader.currentOffset) {
+        _i2c_read_bytes(blockAddr + currentOffset, (byte*)&entryHeader, sizeof(EntryHeader));
+        lastOffset = currentOffset;
+        currentOffset += ENTRY_HEADER_SIZE + entryHeader.keyLength + entryHeader.valueLength;
+    }
+    if (lastOffset == 0) return true;
+    _i2c_read_bytes(blockAddr + lastOffset, (byte*)&entryHeader, sizeof(EntryHeader));
+    if (entryHeader.status != 0x01 || entryHeader.keyLength > _maxKeyLength) return true;
+    char key[_maxKeyLength + 1];
+    _i2c_read_bytes(blockAddr + lastOffset + ENTRY_HEADER_SIZE, (byte*)key, entryHeader.keyLength);
+    key[entryHeader.keyLength] = '\0';
 
-    // Update global header
-    GlobalHeader globalHeader = {
+    for (uint16_t blockIdx = 0; blockIdx < _totalBlocks; blockIdx++) {
+        BlockHeader blockHeader;
+        if (!_readBlockHeader(blockIdx, blockHeader)) continue;
+        if (blockHeader.status != BLOCK_STATUS_ACTIVE && 
+            blockHeader.status != BLOCK_STATUS_VALID) continue;
+        uint16_t endOffset = blockIdx == _activeBlockIndex ? lastOffset : blockHeader.currentOffset;
+        EntryHeader olderHeader;
+        uint16_t olderAddr = _findEntryInBlock(blockIdx, endOffset, key, olderHeader);
+        if (olderAddr != 0 && !_markEntryAsDeleted(olderAddr)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Find the first block that holds no data
+ * @return Block index or 0xFFFF if all blocks are in use
+ * @note A STAGED, UPGRADE or COMPACT block the global header does not
+ *       point at is an import, migration or asynchronous GC cut short
+ *       before its commit and counts as empty
+ */
+uint16_t I2CMiniPrefs::_findEmptyBlock() {
+    for (uint16_t i = 0; i < _totalBlocks; i++) {
+        BlockHeader header;
+        if (!_readBlockHeader(i, header) || header.status == BLOCK_STATUS_EMPTY ||
+            header.status == BLOCK_STATUS_STAGED || header.status == BLOCK_STATUS_UPGRADE ||
+            header.status == BLOCK_STATUS_COMPACT) return i;
+    }
+    return 0xFFFF;
+}
+
+/**
+ * @brief Find the first block with a given status
+ * @param status BLOCK_STATUS_* value
+ * @return Block index or 0xFFFF if there is none
+ */
+uint16_t I2CMiniPrefs::_findBlock(uint8_t status) {
+    for (uint16_t i = 0; i < _totalBlocks; i++) {
+        BlockHeader header;
+        if (_readBlockHeader(i, header) && header.status == status) return i;
+    }
+    return 0xFFFF;
+}
+
+/**
+ * @brief Mark every ACTIVE/VALID block but one as empty
+ * @param keepBlockIndex Block that now holds the store contents
+ * @return true if all releases were written
+ */
+bool I2CMiniPrefs::_releaseBlocksExcept(uint16_t keepBlockIndex) {
+    bool ok = true;
+    for (uint16_t blockIdx = 0; blockIdx < _totalBlocks; blockIdx++) {
+        if (blockIdx == keepBlockIndex) continue;
+        BlockHeader blockHeader;
+        if (!_readBlockHeader(blockIdx, blockHeader)) continue;
+        if (blockHeader.status != BLOCK_STATUS_ACTIVE && 
+            blockHeader.status != BLOCK_STATUS_VALID) continue;
+        blockHeader.status = BLOCK_STATUS_EMPTY;
+        blockHeader.currentOffset = BLOCK_HEADER_SIZE;
+        ok = _writeBlockHeader(blockIdx, blockHeader) && ok;
+    }
+    return ok;
+}
+
+/**
+ * @brief Total size of the live entries garbage collection would keep
+ * @param maxMoved Entries that may move to the cold tier instead (0 = none)
+ * @param moved Receives the header addresses of those entries (optional)
+ * @param movedCount Receives their number (optional)
+ * @return Bytes incl. headers
+ *
+ * Garbage collection copies exactly these bytes into one block and
+ * releases the source blocks as it goes, so _writeEntry() checks that
+ * they fit before starting it.
+ */
+uint32_t I2CMiniPrefs::_liveEntryBytes(uint16_t maxMoved, uint16_t* moved, uint16_t* movedCount) {
+    uint32_t total = 0;
+    uint16_t count = 0;
+    for (uint16_t blockIdx = 0; blockIdx < _totalBlocks; blockIdx++) {
+        BlockHeader blockHeader;
+        if (!_readBlockHeader(blockIdx, blockHeader)) continue;
+        if (blockHeader.status != BLOCK_STATUS_ACTIVE && 
+            blockHeader.status != BLOCK_STATUS_VALID) continue;
+
+        uint16_t currentOffset = BLOCK_HEADER_SIZE;
+        uint16_t blockAddr = _getBlockAddress(blockIdx);
+        while (currentOffset < blockHeader.currentOffset) {
+            EntryHeader entryHeader;
+            _i2c_read_bytes(blockAddr + currentOffset, (byte*)&entryHeader, sizeof(EntryHeader));
+            uint16_t entryTotalSize = ENTRY_HEADER_SIZE + entryHeader.keyLength + entryHeader.valueLength;
+            if (entryHeader.status == 0x01 && 
+                entryHeader.keyLength <= _maxKeyLength && 
+                entryHeader.valueLength <= _maxValueLength &&
+                !_expired(entryHeader.dataType, blockAddr + currentOffset + ENTRY_HEADER_SIZE + entryHeader.keyLength,
+                          entryHeader.valueLength)) {
+                // TTL entries expire on the chip instead
+                if (count < maxMoved && entryHeader.age >= _coldGenerations &&
+                    !(entryHeader.dataType & PREFS_TTL_FLAG)) {
+                    if (moved) moved[count] = blockAddr + currentOffset;
+                    count++;
+                } else {
+                    total += entryTotalSize;
+                }
+            }
+            currentOffset += entryTotalSize;
+        }
+    }
+    if (movedCount) *movedCount = count;
+    return total;
+}
+
+/**
+ * @brief Number of entries the cold tier can take in
+ */
+uint16_t I2CMiniPrefs::_coldMoveLimit() {
+    return _coldTier ? _coldTier->freeSlots() : 0;
+}
+
+/**
+ * @brief Copy entries into the cold tier image
+ * @param moved Header addresses of the entries
+ * @param count Number of entries
+ * @return true once the new image is committed; the entries may then be
+ *         dropped from the chip
+ *
+ * Older cold copies of the same keys are left out of the new image.
+ */
+bool I2CMiniPrefs::_moveToColdTier(const uint16_t* moved, uint16_t count) {
+    _coldMoved = moved;
+    _coldMovedCount = count;
+    bool ok = _coldTier->beginRewrite(_coldKeep, this);
+    byte* entry = new byte[_maxKeyLength + _maxValueLength];
+    for (uint16_t i = 0; ok && i < count; i++) {
+        EntryHeader header;
+        ok = _i2c_read_bytes(moved[i], (byte*)&header, sizeof(EntryHeader)) &&
+             _i2c_read_bytes(moved[i] + ENTRY_HEADER_SIZE, entry, header.keyLength + header.valueLength) &&
+             _coldTier->append((PrefDataType)header.dataType, (const char*)entry, header.keyLength,
+                               entry + header.keyLength, header.valueLength);
+    }
+    delete[] entry;
+    if (ok) ok = _coldTier->commitRewrite();
+    else _coldTier->abortRewrite();
+    _coldMovedCount = ok ? count : 0;
+    return ok;
+}
+
+/**
+ * @brief Rewrite filter: drop old cold copies of keys being moved in
+ */
+bool I2CMiniPrefs::_coldKeep(const char* key, void* ctx) {
+    I2CMiniPrefs* self = static_cast<I2CMiniPrefs*>(ctx);
+    return !self->_isColdMoved(0, key);
+}
+
+/**
+ * @brief Whether an entry is being moved to the cold tier
+ * @param entryAddr Header address (0 to match by key only)
+ * @param key Key to match when entryAddr is 0
+ */
+bool I2CMiniPrefs::_isColdMoved(uint16_t entryAddr, const char* key) {
+    for (uint16_t i = 0; i < _coldMovedCount; i++) {
+        if (entryAddr) {
+            if (_coldMoved[i] == entryAddr) return true;
+            continue;
+        }
+        EntryHeader header;
+        char movedKey[256];   // keyLength is a uint8_t
+        _i2c_read_bytes(_coldMoved[i], (byte*)&header, sizeof(EntryHeader));
+        if (header.keyHash != _hashKey(key) || header.keyLength != strlen(key)) continue;
+        _i2c_read_bytes(_coldMoved[i] + ENTRY_HEADER_SIZE, (byte*)movedKey, header.keyLength);
+        if (memcmp(movedKey, key, header.keyLength) == 0) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Perform garbage collection and wear leveling
+ * @return true on success, false on error
+ * 
+ * Steps:
+ * 1. Find empty block for new active block
+ * 2. Copy valid entries from all blocks
+ * 3. Mark old blocks as empty
+ * 4. Update global header
+ */
+bool I2CMiniPrefs::_runGarbageCollection() {
+    _gcRunning = true;
+    bool ok = true;
+    uint16_t moved[PREFS_COLD_MAX_ENTRIES];
+    if (_coldTier) {
+        // Entries due for the cold tier are committed there before the
+        // chip releases them; what stays must fit the new block
+        uint16_t movedCount = 0;
+        uint32_t keptBytes = _liveEntryBytes(_coldMoveLimit(), moved, &movedCount);
+        if (movedCount > 0 && !_moveToColdTier(moved, movedCount)) {
+            keptBytes = _liveEntryBytes(0);
+        }
+        ok = BLOCK_HEADER_SIZE + keptBytes <= _blockSizeBytes;
+    }
+    ok = ok && _compactInto(_findEmptyBlock());
+    if (!ok) _scanUsage();
+    _coldMoved = nullptr;
+    _coldMovedCount = 0;
+    _gcRunning = false;
+    return ok;
+}
+
+/**
+ * @brief Garbage collection body, see _runGarbageCollection()
+ * @param nextEmptyBlockIndex Target block (0xFFFF if none is free)
+ * @param keepEntries false drops all entries (clear())
+ * @return true on success, false on error
+ */
+bool I2CMiniPrefs::_compactInto(uint16_t nextEmptyBlockIndex, bool keepEntries) {
+    if (nextEmptyBlockIndex == 0xFFFF) return false;
+
+    // Mark current active block as valid
+    if (_isInitialized) {
+        BlockHeader oldActiveBlockHeader;
+        if (_readBlockHeader(_activeBlockIndex, oldActiveBlockHeader)) {
+            oldActiveBlockHeader.status = BLOCK_STATUS_VALID;
+            if (!_writeBlockHeader(_activeBlockIndex, oldActiveBlockHeader)) return false;
+        }
+    }
+
+    // Initialize new active block
+    BlockHeader newActiveBlockHeader = {
+        .status = BLOCK_STATUS_ACTIVE,
+        .currentOffset = BLOCK_HEADER_SIZE
+    };
+    if (!_writeBlockHeader(nextEmptyBlockIndex, newActiveBlockHeader)) return false;
+    uint16_t currentWriteOffset = BLOCK_HEADER_SIZE;
+    uint16_t newBlockAddr = _getBlockAddress(nextEmptyBlockIndex);
+    uint16_t copiedEntries = 0;
+
+    // Copy valid entries
+    for (uint16_t blockIdx = 0; blockIdx < _totalBlocks; blockIdx++) {
+        if (blockIdx == nextEmptyBlockIndex) continue;
+
+        BlockHeader sourceBlockHeader;
+        if (!_readBlockHeader(blockIdx, sourceBlockHeader)) continue;
+        if (sourceBlockHeader.status != BLOCK_STATUS_ACTIVE && 
+            sourceBlockHeader.status != BLOCK_STATUS_VALID) continue;
+
+        uint16_t currentReadOffset = BLOCK_HEADER_SIZE;
+        uint16_t sourceBlockAddr = _getBlockAddress(blockIdx);
+
+        while (keepEntries && currentReadOffset < sourceBlockHeader.currentOffset) {
+            EntryHeader entryHeader;
+            uint16_t entryHeaderAddr = sourceBlockAddr + currentReadOffset;
+            _i2c_read_bytes(entryHeaderAddr, (byte*)&entryHeader, sizeof(EntryHeader));
+            uint16_t entryTotalSize = ENTRY_HEADER_SIZE + entryHeader.keyLength + entryHeader.valueLength;
+
+            // Only copy valid entries that stay on the chip
+            if (entryHeader.status == 0x01 && 
+                entryHeader.keyLength <= _maxKeyLength && 
+                entryHeader.valueLength <= _maxValueLength &&
+                !_isColdMoved(entryHeaderAddr, nullptr) &&
+                !_expired(entryHeader.dataType, entryHeaderAddr + ENTRY_HEADER_SIZE + entryHeader.keyLength,
+                          entryHeader.valueLength)) {
+                
+                if ((currentWriteOffset + entryTotalSize) > _blockSizeBytes) return false;
+                
+                byte* entryData = new byte[entryTotalSize];
+                bool copied = _i2c_read_bytes(entryHeaderAddr, entryData, entryTotalSize);
+                byte& age = entryData[offsetof(EntryHeader, age)];
+                if (age < 0xFF) age++;
+                copied = copied && _i2c_write_bytes(newBlockAddr + currentWriteOffset, entryData, entryTotalSize);
+                delete[] entryData;
+                if (!copied) return false;
+                
+                currentWriteOffset += entryTotalSize;
+                copiedEntries++;
+            }
+            currentReadOffset += entryTotalSize;
+        }
+
+        // Mark source block as empty
+        sourceBlockHeader.status = BLOCK_STATUS_EMPTY;
+        sourceBlockHeader.currentOffset = BLOCK_HEADER_SIZE;
+        if (!_writeBlockHeader(blockIdx, sourceBlockHeader)) return false;
+    }
+
+    // Finalize new block
+    newActiveBlockHeader.currentOffset = currentWriteOffset;
+    if (!_writeBlockHeader(nextEmptyBlockIndex, newActiveBlockHeader)) return false;
+    _activeBlockIndex = nextEmptyBlockIndex;
+    _liveBytes = currentWriteOffset - BLOCK_HEADER_SIZE;
+    _deadBytes = 0;
+    _liveEntries = copiedEntries;
+    _compactEpoch++;
+
+    // Update global header
+    GlobalHeader globalHeader = {
         .magic = PREFS_MAGIC,
         .version = PREFS_VERSION,
         .totalBlocks = _totalBlocks,
@@ -423,6 +1286,95 @@ bool I2CMiniPrefs::_runGarbageCollection() {
     return _writeGlobalHeader(globalHeader);
 }
 
+/**
+ * @brief Re-encode a version 1 store, whose entry headers had no age byte
+ * @return true if the store is in the current format now
+ *
+ * Version 1 entry headers are 7 bytes on AVR and 8 on 32-bit targets,
+ * where the byte now holding the age was uninitialized padding. The live
+ * entries are rewritten with fresh headers into an UPGRADE block, which
+ * the version 2 global header then commits like an import. A cut before
+ * that repeats the migration; one after it is finished by begin().
+ * The UPGRADE header is written last, so such a block is complete and
+ * a repeated migration commits it directly.
+ */
+bool I2CMiniPrefs::_migrateV1() {
+    struct EntryHeaderV1 {
+        uint8_t  status;
+        uint8_t  dataType;
+        uint16_t keyHash;
+        uint8_t  keyLength;
+        uint16_t valueLength;
+    };
+
+    BlockHeader targetHeader;
+    uint16_t targetBlockIndex = _findBlock(BLOCK_STATUS_UPGRADE);
+    if (targetBlockIndex != 0xFFFF && _readBlockHeader(targetBlockIndex, targetHeader)) {
+        return _commitUpgrade(targetBlockIndex, targetHeader);
+    }
+    targetBlockIndex = _findEmptyBlock();
+    if (targetBlockIndex == 0xFFFF) return false;
+    uint16_t targetAddr = _getBlockAddress(targetBlockIndex);
+    uint16_t writeOffset = BLOCK_HEADER_SIZE;
+    char key[_maxKeyLength + 1];
+    byte value[_maxValueLength];
+
+    for (uint16_t blockIdx = 0; blockIdx < _totalBlocks; blockIdx++) {
+        BlockHeader blockHeader;
+        if (!_readBlockHeader(blockIdx, blockHeader)) continue;
+        if (blockHeader.status != BLOCK_STATUS_ACTIVE && 
+            blockHeader.status != BLOCK_STATUS_VALID) continue;
+
+        uint16_t blockAddr = _getBlockAddress(blockIdx);
+        uint16_t readOffset = BLOCK_HEADER_SIZE;
+        while (readOffset < blockHeader.currentOffset) {
+            EntryHeaderV1 entryHeader;
+            uint16_t entryAddr = blockAddr + readOffset;
+            if (!_i2c_read_bytes(entryAddr, (byte*)&entryHeader, sizeof(entryHeader))) return false;
+            readOffset += sizeof(entryHeader) + entryHeader.keyLength + entryHeader.valueLength;
+            if (entryHeader.status != 0x01 || entryHeader.keyLength > _maxKeyLength ||
+                entryHeader.valueLength > _maxValueLength) continue;
+
+            // A store that no longer fits is left alone rather than cut down
+            uint16_t entryTotalSize = ENTRY_HEADER_SIZE + entryHeader.keyLength + entryHeader.valueLength;
+            if ((writeOffset + entryTotalSize) > _blockSizeBytes) return false;
+            uint16_t keyAddr = entryAddr + sizeof(entryHeader);
+            if (!_i2c_read_bytes(keyAddr, (byte*)key, entryHeader.keyLength) ||
+                !_i2c_read_bytes(keyAddr + entryHeader.keyLength, value, entryHeader.valueLength)) {
+                return false;
+            }
+            key[entryHeader.keyLength] = '\0';
+            if (!_writeEntryData(targetAddr + writeOffset, key, entryHeader.keyLength,
+                                 (PrefDataType)entryHeader.dataType, value,
+                                 entryHeader.valueLength)) return false;
+            writeOffset += entryTotalSize;
+        }
+    }
+
+    targetHeader.status = BLOCK_STATUS_UPGRADE;
+    targetHeader.currentOffset = writeOffset;
+    if (!_writeBlockHeader(targetBlockIndex, targetHeader)) return false;
+    return _commitUpgrade(targetBlockIndex, targetHeader);
+}
+
+/**
+ * @brief Commit a complete UPGRADE block with a version 2 global header
+ * @param targetBlockIndex The UPGRADE block
+ * @param targetHeader Its header
+ * @return true if the store is in the current format now
+ */
+bool I2CMiniPrefs::_commitUpgrade(uint16_t targetBlockIndex, BlockHeader& targetHeader) {
+    GlobalHeader globalHeader = {
+        .magic = PREFS_MAGIC,
+        .version = PREFS_VERSION,
+        .totalBlocks = _totalBlocks,
+        .activeBlockIndex = targetBlockIndex
+    };
+    if (!_writeGlobalHeader(globalHeader)) return false;
+    _activeBlockIndex = targetBlockIndex;
+    return _finishSwitch(targetBlockIndex, targetHeader);
+}
+
 // Public API Implementation -------------------------------------------------
 
 /**
@@ -436,139 +1388,1659 @@ bool I2CMiniPrefs::_runGarbageCollection() {
  * - Garbage collection if needed
  */
 bool I2CMiniPrefs::begin() {
-    // Initialize I2C with custom or default pins
-    if (_sdaPin != -1 && _sclPin != -1) {
-        Wire.begin(_sdaPin, _sclPin);
-    } else {
-        Wire.begin();
-    }
-    
-    // Set high speed for FRAM, normal for EEPROM
-    _memoryType == MEM_TYPE_FRAM ? Wire.setClock(1000000) : Wire.setClock(100000);
+    _beginWire();
 
-    // Verify device presence
-    Wire.beginTransmission(_i2cAddress);
-    if (Wire.endTransmission() != 0) return false;
+    LockGuard lock(*this, true);
+    _asyncDrain();
+
+    // Verify device presence; a slave left mid-byte by a brownout can hold
+    // SDA low, which the recovery clocks free
+    if (!_devicePresent() && !_recoverBus()) return false;
 
     // Calculate memory layout
     _totalBlocks = (_totalMemoryBytes - GLOBAL_HEADER_SIZE) / _blockSizeBytes;
     if (_totalBlocks == 0) return false;
 
-    // Initialize or recover storage
+    // Initialize or recover storage. A header that cannot be read is a bus
+    // failure, not an unformatted chip: never format or repair on it.
     GlobalHeader globalHeader;
     if (!_readGlobalHeader(globalHeader)) {
-        // First-time initialization
-        if (!_runGarbageCollection()) return false;
+        if (!_devicePresent()) return false;
+        // Version 1 computed the checksum over sizeof(GlobalHeader) - 1
+        // bytes, which on 32-bit targets includes the checksum byte and its
+        // caller-set value; the layout has to vouch for it instead
+        bool isV1 = globalHeader.magic == PREFS_MAGIC && globalHeader.version == 0x01 &&
+                    globalHeader.totalBlocks == _totalBlocks &&
+                    globalHeader.activeBlockIndex < _totalBlocks;
+        if (isV1 || _findBlock(BLOCK_STATUS_UPGRADE) != 0xFFFF) {
+            // Store written before the entry age existed, or one whose
+            // migration was cut while writing the new global header
+            if (!_migrateV1()) return false;
+        } else {
+            // First-time initialization
+            if (!_runGarbageCollection()) return false;
+        }
     } else {
         // Existing storage found
         _activeBlockIndex = globalHeader.activeBlockIndex;
         BlockHeader activeBlockHeader;
-        if (!_readBlockHeader(_activeBlockIndex, activeBlockHeader) || 
-            activeBlockHeader.status != BLOCK_STATUS_ACTIVE) {
+        bool readable = _readBlockHeader(_activeBlockIndex, activeBlockHeader);
+        // A rollback(), importFrom(), migration or asynchronous GC cut
+        // short after its commit point. Cut while the status byte was
+        // rewritten, the checksum still is the pinned block's.
+        static const uint8_t pinnedStatus[] = {BLOCK_STATUS_SNAPSHOT, BLOCK_STATUS_STAGED,
+                                               BLOCK_STATUS_UPGRADE, BLOCK_STATUS_COMPACT};
+        for (uint8_t i = 0; !readable && i < sizeof(pinnedStatus); i++) {
+            BlockHeader pinnedHeader = activeBlockHeader;
+            pinnedHeader.status = pinnedStatus[i];
+            if (_blockHeaderCrc(pinnedHeader) == pinnedHeader.checksum) {
+                activeBlockHeader = pinnedHeader;
+                readable = true;
+            }
+        }
+        if (readable && (activeBlockHeader.status == BLOCK_STATUS_SNAPSHOT ||
+                         activeBlockHeader.status == BLOCK_STATUS_STAGED ||
+                         activeBlockHeader.status == BLOCK_STATUS_UPGRADE ||
+                         activeBlockHeader.status == BLOCK_STATUS_COMPACT) &&
+            !_finishSwitch(_activeBlockIndex, activeBlockHeader)) return false;
+        if (!readable || activeBlockHeader.status != BLOCK_STATUS_ACTIVE) {
+            if (!_devicePresent()) return false;
             // Repair corrupted storage
             if (!_runGarbageCollection()) return false;
+        } else if (!_releaseBlocksExcept(_activeBlockIndex)) {
+            // Sources an asynchronous GC activated its target before
+            // releasing; they only hold copies
+            return false;
         }
     }
+    if (!_dropSuperseded()) return false;
+    _scanUsage();
     _isInitialized = true;
     return true;
 }
 
 void I2CMiniPrefs::end() {
-    // Optional I2C resource release
+    // Let the last write cycle finish before the caller powers down
+    LockGuard lock(*this, true);
+    _waitWriteCycle();
 }
 
 // Put Methods Implementation (template-based) --------------------------------
 
 template<typename T>
 bool I2CMiniPrefs::_putValue(const char* key, PrefDataType type, T value) {
-    return _writeEntry(key, type, &value, sizeof(T));
+    return _putComplexValue(key, type, &value, sizeof(T));
 }
 
 bool I2CMiniPrefs::putBool(const char* key, bool value) { 
     return _putValue(key, TYPE_BOOL, value); 
 }
-// ... (all other put methods follow same pattern)
+
+bool I2CMiniPrefs::putChar(const char* key, char value) {
+    return _putValue(key, TYPE_CHAR, value);
+}
+
+bool I2CMiniPrefs::putUChar(const char* key, unsigned char value) {
+    return _putValue(key, TYPE_UCHAR, value);
+}
+
+bool I2CMiniPrefs::putShort(const char* key, short value) {
+    return _putValue(key, TYPE_SHORT, value);
+}
+
+bool I2CMiniPrefs::putUShort(const char* key, unsigned short value) {
+    return _putValue(key, TYPE_USHORT, value);
+}
+
+bool I2CMiniPrefs::putInt(const char* key, int value) {
+    return _putValue(key, TYPE_INT, value);
+}
+
+bool I2CMiniPrefs::putUInt(const char* key, unsigned int value) {
+    return _putValue(key, TYPE_UINT, value);
+}
+
+bool I2CMiniPrefs::putLong(const char* key, long value) {
+    return _putValue(key, TYPE_LONG, value);
+}
+
+bool I2CMiniPrefs::putULong(const char* key, unsigned long value) {
+    return _putValue(key, TYPE_ULONG, value);
+}
+
+bool I2CMiniPrefs::putLong64(const char* key, long long value) {
+    return _putValue(key, TYPE_LONG64, value);
+}
+
+bool I2CMiniPrefs::putULong64(const char* key, unsigned long long value) {
+    return _putValue(key, TYPE_ULONG64, value);
+}
+
+bool I2CMiniPrefs::putFloat(const char* key, float value) {
+    return _putValue(key, TYPE_FLOAT, value);
+}
+
+bool I2CMiniPrefs::putDouble(const char* key, double value) {
+    return _putValue(key, TYPE_DOUBLE, value);
+}
 
 // Get Methods Implementation (template-based) --------------------------------
 
 template<typename T>
 T I2CMiniPrefs::_getValue(const char* key, T defaultValue, PrefDataType expectedType) {
+    LockGuard lock(*this, false);
     uint16_t valueAddr;
     uint16_t valueLen;
     PrefDataType storedType;
-    if (_findEntry(key, valueAddr, valueLen, storedType) != 0 && 
-        storedType == expectedType && valueLen == sizeof(T)) {
-        T value;
+    uint32_t startUs = _traceBuf ? micros() : 0;
+    uint32_t startBus = _busBytes;
+    T value = defaultValue;
+    uint16_t entryAddr = _findLiveEntry(key, valueAddr, valueLen, storedType);
+    bool found = entryAddr != 0 && storedType == expectedType && valueLen == sizeof(T);
+    if (found) {
         _i2c_read_bytes(valueAddr, (byte*)&value, sizeof(T));
-        return value;
+    } else if (entryAddr == 0 && _coldTier) {
+        T coldValue;
+        found = _coldTier->get(key, expectedType, &coldValue, sizeof(T)) == sizeof(T);
+        if (found) value = coldValue;
     }
-    return defaultValue;
+    _traceRecord(PREFS_TRACE_GET, _hashKey(key), found ? sizeof(T) : 0, found, startUs, startBus);
+    return value;
 }
 
 bool I2CMiniPrefs::getBool(const char* key, bool defaultValue) { 
     return _getValue(key, defaultValue, TYPE_BOOL); 
 }
-// ... (all other get methods follow same pattern)
+
+char I2CMiniPrefs::getChar(const char* key, char defaultValue) {
+    return _getValue(key, defaultValue, TYPE_CHAR);
+}
+
+unsigned char I2CMiniPrefs::getUChar(const char* key, unsigned char defaultValue) {
+    return _getValue(key, defaultValue, TYPE_UCHAR);
+}
+
+short I2CMiniPrefs::getShort(const char* key, short defaultValue) {
+    return _getValue(key, defaultValue, TYPE_SHORT);
+}
+
+unsigned short I2CMiniPrefs::getUShort(const char* key, unsigned short defaultValue) {
+    return _getValue(key, defaultValue, TYPE_USHORT);
+}
+
+int I2CMiniPrefs::getInt(const char* key, int defaultValue) {
+    return _getValue(key, defaultValue, TYPE_INT);
+}
+
+unsigned int I2CMiniPrefs::getUInt(const char* key, unsigned int defaultValue) {
+    return _getValue(key, defaultValue, TYPE_UINT);
+}
+
+long I2CMiniPrefs::getLong(const char* key, long defaultValue) {
+    return _getValue(key, defaultValue, TYPE_LONG);
+}
+
+unsigned long I2CMiniPrefs::getULong(const char* key, unsigned long defaultValue) {
+    return _getValue(key, defaultValue, TYPE_ULONG);
+}
+
+long long I2CMiniPrefs::getLong64(const char* key, long long defaultValue) {
+    return _getValue(key, defaultValue, TYPE_LONG64);
+}
+
+unsigned long long I2CMiniPrefs::getULong64(const char* key, unsigned long long defaultValue) {
+    return _getValue(key, defaultValue, TYPE_ULONG64);
+}
+
+float I2CMiniPrefs::getFloat(const char* key, float defaultValue) {
+    return _getValue(key, defaultValue, TYPE_FLOAT);
+}
+
+double I2CMiniPrefs::getDouble(const char* key, double defaultValue) {
+    return _getValue(key, defaultValue, TYPE_DOUBLE);
+}
 
 // Complex Type Handlers ------------------------------------------------------
 
 bool I2CMiniPrefs::_putComplexValue(const char* key, PrefDataType type, 
                                   const void* valueBuf, size_t len) {
-    return _writeEntry(key, type, valueBuf, len);
+    LockGuard lock(*this, true);
+    _asyncDrain();
+    uint32_t startUs = _traceBuf ? micros() : 0;
+    uint32_t startBus = _busBytes;
+    bool ok = _writeEntry(key, type, valueBuf, len);
+    _traceRecord(PREFS_TRACE_PUT, _hashKey(key), len, ok, startUs, startBus);
+    return ok;
 }
 
 size_t I2CMiniPrefs::_getComplexValue(const char* key, void* buf, size_t maxLen, 
-                                    PrefDataType expectedType) {
+                                    PrefDataType expectedType, PrefsVersion* version) {
+    LockGuard lock(*this, false);
     uint16_t valueAddr;
     uint16_t valueLen;
     PrefDataType type;
-    if (_findEntry(key, valueAddr, valueLen, type) != 0 && type == expectedType) {
-        size_t bytesToRead = min(valueLen, maxLen);
+    uint32_t startUs = _traceBuf ? micros() : 0;
+    uint32_t startBus = _busBytes;
+    size_t bytesToRead = 0;
+    uint16_t entryAddr = _findLiveEntry(key, valueAddr, valueLen, type);
+    bool found = entryAddr != 0 && type == expectedType;
+    if (found) {
+        bytesToRead = min((size_t)valueLen, maxLen);
         _i2c_read_bytes(valueAddr, (byte*)buf, bytesToRead);
-        return bytesToRead;
+    } else if (entryAddr == 0 && _coldTier) {
+        size_t coldLen = _coldTier->get(key, expectedType, buf, maxLen);
+        found = coldLen > 0;
+        bytesToRead = min(coldLen, maxLen);
     }
-    return 0;
+    if (version) *version = _entryVersion(key, entryAddr);
+    _traceRecord(PREFS_TRACE_GET, _hashKey(key), bytesToRead, found, startUs, startBus);
+    return bytesToRead;
 }
 
-// String Specializations -----------------------------------------------------
+bool I2CMiniPrefs::putBytes(const char* key, const void* buf, size_t len) {
+    if (!buf && len > 0) return false;
+    return _putComplexValue(key, TYPE_BYTES, buf, len);
+}
 
-bool I2CMiniPrefs::putString(const char* key, const char* value) {
-    if (!value) return false;
-    return _putComplexValue(key, TYPE_STRING, value, strlen(value) + 1);
+bool I2CMiniPrefs::putTyped(const char* key, PrefDataType type, const void* buf, size_t len) {
+    if (type == TYPE_NONE || (!buf && len > 0)) return false;
+    return _putComplexValue(key, type, buf, len);
 }
 
-bool I2CMiniPrefs::putString(const char* key, const String& value) {
-    return putString(key, value.c_str());
+// TTL Entries ----------------------------------------------------------------
+
+bool I2CMiniPrefs::putWithTTL(const char* key, PrefDataType type, const void* buf, size_t len,
+                              uint32_t seconds) {
+    if (!_clock || type == TYPE_NONE || (type & PREFS_TTL_FLAG) || (!buf && len > 0) ||
+        len + PREFS_TTL_STAMP_SIZE > _maxValueLength) return false;
+    byte stamped[PREFS_TTL_STAMP_SIZE + len];
+    uint32_t expiry = _clock() + seconds;
+    memcpy(stamped, &expiry, PREFS_TTL_STAMP_SIZE);
+    memcpy(stamped + PREFS_TTL_STAMP_SIZE, buf, len);
+
+    LockGuard lock(*this, true);
+    _asyncDrain();
+    uint32_t startUs = _traceBuf ? micros() : 0;
+    uint32_t startBus = _busBytes;
+    bool ok = _writeEntry(key, (PrefDataType)(type | PREFS_TTL_FLAG), stamped, sizeof(stamped));
+    // A cold copy would reappear once the entry expires
+    if (ok && _coldTier && _coldTier->contains(key)) ok = _coldTier->remove(key);
+    _traceRecord(PREFS_TRACE_PUT, _hashKey(key), len, ok, startUs, startBus);
+    return ok;
 }
 
-String I2CMiniPrefs::getString(const char* key, const char* defaultValue) {
-    char buffer[_maxValueLength + 1] = {0};
-    size_t len = _getComplexValue(key, buffer, _maxValueLength, TYPE_STRING);
-    return len > 0 ? String(buffer) : String(defaultValue);
+bool I2CMiniPrefs::putWithTTL(const char* key, const char* value, uint32_t seconds) {
+    if (!value) return false;
+    return putWithTTL(key, TYPE_STRING, value, strlen(value) + 1, seconds);
 }
 
-// Utility Methods ------------------------------------------------------------
+size_t I2CMiniPrefs::getBytes(const char* key, void* buf, size_t maxLen) {
+    if (!buf) return 0;
+    return _getComplexValue(key, buf, maxLen, TYPE_BYTES);
+}
 
-bool I2CMiniPrefs::isKey(const char* key) {
-    uint16_t valueAddr, valueLen;
-    PrefDataType type;
-    return _findEntry(key, valueAddr, valueLen, type) != 0;
+size_t I2CMiniPrefs::getTyped(const char* key, PrefDataType type, void* buf, size_t maxLen) {
+    if (!buf || type == TYPE_NONE) return 0;
+    return _getComplexValue(key, buf, maxLen, type);
 }
 
-bool I2CMiniPrefs::remove(const char* key) {
+size_t I2CMiniPrefs::getTyped(const char* key, PrefDataType type, void* buf, size_t maxLen,
+                              PrefsVersion& version) {
+    version = 0;
+    if (!buf || type == TYPE_NONE) return 0;
+    return _getComplexValue(key, buf, maxLen, type, &version);
+}
+
+// Versioned Writes -----------------------------------------------------------
+
+PrefsVersion I2CMiniPrefs::getVersion(const char* key) {
+    LockGuard lock(*this, false);
     uint16_t valueAddr, valueLen;
     PrefDataType type;
-    uint16_t entryAddr = _findEntry(key, valueAddr, valueLen, type);
-    return entryAddr ? _markEntryAsDeleted(entryAddr) : false;
+    return _entryVersion(key, _findLiveEntry(key, valueAddr, valueLen, type));
+}
+
+bool I2CMiniPrefs::compareAndPut(const char* key, PrefsVersion expectedVersion, PrefDataType type,
+                                 const void* buf, size_t len) {
+    if (type == TYPE_NONE || (!buf && len > 0)) return false;
+    LockGuard lock(*this, true);
+    _asyncDrain();
+    uint32_t startUs = _traceBuf ? micros() : 0;
+    uint32_t startBus = _busBytes;
+    bool ok = false;
+    if (_isInitialized && strlen(key) <= _maxKeyLength && len <= _maxValueLength) {
+        // One lookup serves the version check and the replacement
+        uint16_t valueAddr, valueLen;
+        PrefDataType storedType;
+        uint16_t entryAddr = _findEntry(key, valueAddr, valueLen, storedType);
+        bool live = entryAddr != 0 && !_expired(storedType, valueAddr, valueLen);
+        if (_entryVersion(key, live ? entryAddr : 0) == expectedVersion) {
+            ok = _replaceEntry(key, type, buf, len, entryAddr, valueLen);
+        }
+    }
+    _traceRecord(PREFS_TRACE_PUT, _hashKey(key), len, ok, startUs, startBus);
+    return ok;
+}
+
+bool I2CMiniPrefs::compareAndPut(const char* key, PrefsVersion expectedVersion, const char* value) {
+    if (!value) return false;
+    return compareAndPut(key, expectedVersion, TYPE_STRING, value, strlen(value) + 1);
+}
+
+/**
+ * @brief Version token of the current value of key
+ * @param key Null-terminated key string
+ * @param entryAddr Entry header address found by _findEntry(), 0 if none
+ * @return Compaction epoch and entry address; 0 if key does not exist
+ *
+ * Entries are only ever appended between two compactions, so every put
+ * moves the key to a new address, and every compaction starts a new
+ * epoch. Cold entries have no address and use 1.
+ */
+PrefsVersion I2CMiniPrefs::_entryVersion(const char* key, uint16_t entryAddr) {
+    if (entryAddr == 0 && !(_coldTier && _coldTier->contains(key))) return 0;
+    return ((PrefsVersion)_compactEpoch << 16) | (entryAddr ? entryAddr : 1);
+}
+
+// String Specializations -----------------------------------------------------
+
+bool I2CMiniPrefs::putString(const char* key, const char* value) {
+    if (!value) return false;
+    return _putComplexValue(key, TYPE_STRING, value, strlen(value) + 1);
+}
+
+bool I2CMiniPrefs::putString(const char* key, const String& value) {
+    return putString(key, value.c_str());
+}
+
+String I2CMiniPrefs::getString(const char* key, const char* defaultValue) {
+    char buffer[_maxValueLength + 1] = {0};
+    size_t len = _getComplexValue(key, buffer, _maxValueLength, TYPE_STRING);
+    return len > 0 ? String(buffer) : String(defaultValue);
+}
+
+// Utility Methods ------------------------------------------------------------
+
+bool I2CMiniPrefs::isKey(const char* key) {
+    LockGuard lock(*this, false);
+    uint16_t valueAddr, valueLen = 0;
+    PrefDataType type;
+    uint32_t startUs = _traceBuf ? micros() : 0;
+    uint32_t startBus = _busBytes;
+    bool found = _findLiveEntry(key, valueAddr, valueLen, type) != 0 ||
+                 (_coldTier && _coldTier->contains(key));
+    _traceRecord(PREFS_TRACE_IS_KEY, _hashKey(key), found ? valueLen : 0, found, startUs, startBus);
+    return found;
+}
+
+size_t I2CMiniPrefs::getValueLength(const char* key) {
+    PrefDataType type;
+    uint16_t valueLen;
+    return _statEntry(key, type, valueLen) ? valueLen : 0;
+}
+
+PrefDataType I2CMiniPrefs::getType(const char* key) {
+    PrefDataType type;
+    uint16_t valueLen;
+    return _statEntry(key, type, valueLen) ? type : TYPE_NONE;
+}
+
+/**
+ * @brief Look up type and length of a value without reading it
+ * @return true if the key exists on the chip or in the cold tier
+ */
+bool I2CMiniPrefs::_statEntry(const char* key, PrefDataType& type, uint16_t& valueLen) {
+    LockGuard lock(*this, false);
+    uint16_t valueAddr;
+    valueLen = 0;
+    uint32_t startUs = _traceBuf ? micros() : 0;
+    uint32_t startBus = _busBytes;
+    bool found = _findLiveEntry(key, valueAddr, valueLen, type) != 0 ||
+                 (_coldTier && _coldTier->stat(key, type, valueLen));
+    _traceRecord(PREFS_TRACE_IS_KEY, _hashKey(key), found ? valueLen : 0, found, startUs, startBus);
+    return found;
+}
+
+bool I2CMiniPrefs::remove(const char* key) {
+    LockGuard lock(*this, true);
+    _asyncDrain();
+    uint16_t valueAddr, valueLen;
+    PrefDataType type;
+    uint32_t startUs = _traceBuf ? micros() : 0;
+    uint32_t startBus = _busBytes;
+    // An expired entry is not found; garbage collection drops it anyway
+    uint16_t entryAddr = _findLiveEntry(key, valueAddr, valueLen, type);
+    bool ok = entryAddr ? _markEntryAsDeleted(entryAddr) : false;
+    // An older cold copy would reappear otherwise
+    if (_coldTier && _coldTier->contains(key)) {
+        ok = _coldTier->remove(key) && (entryAddr == 0 || ok);
+    }
+    _traceRecord(PREFS_TRACE_REMOVE, _hashKey(key), 0, ok, startUs, startBus);
+    return ok;
 }
 
 bool I2CMiniPrefs::clear() {
-    _isInitialized = false;
-    _activeBlockIndex = 0;
-    return _runGarbageCollection();
+    LockGuard lock(*this, true);
+    _asyncDrain();
+    uint32_t startUs = _traceBuf ? micros() : 0;
+    uint32_t startBus = _busBytes;
+    if (_totalBlocks == 0) return false;
+
+    // Format a fresh active block without copying; when every block is in
+    // use (a full store), take the next one that holds no snapshot
+    uint16_t target = _findEmptyBlock();
+    for (uint16_t i = 1; target == 0xFFFF && i <= _totalBlocks; i++) {
+        uint16_t candidate = (_activeBlockIndex + i) % _totalBlocks;
+        BlockHeader header;
+        if (!_readBlockHeader(candidate, header) || header.status != BLOCK_STATUS_SNAPSHOT) {
+            target = candidate;
+        }
+    }
+    _gcRunning = true;
+    bool ok = _compactInto(target, false);
+    if (!ok) _scanUsage();
+    _gcRunning = false;
+    _isInitialized = ok;
+    if (ok && _coldTier) ok = _coldTier->clear();
+    _traceRecord(PREFS_TRACE_CLEAR, 0, 0, ok, startUs, startBus);
+    return ok;
+}
+
+bool I2CMiniPrefs::removePrefix(const char* prefix) {
+    LockGuard lock(*this, true);
+    _asyncDrain();
+    if (!_isInitialized || !prefix) return false;
+    size_t prefixLen = strlen(prefix);
+    bool ok = true;
+    char key[256];   // keyLength is a uint8_t
+    for (uint16_t blockIdx = 0; blockIdx < _totalBlocks; blockIdx++) {
+        BlockHeader blockHeader;
+        if (!_readBlockHeader(blockIdx, blockHeader)) continue;
+        if (blockHeader.status != BLOCK_STATUS_ACTIVE && 
+            blockHeader.status != BLOCK_STATUS_VALID) continue;
+
+        uint16_t currentOffset = BLOCK_HEADER_SIZE;
+        uint16_t blockAddr = _getBlockAddress(blockIdx);
+        while (currentOffset < blockHeader.currentOffset) {
+            EntryHeader entryHeader;
+            uint16_t entryAddr = blockAddr + currentOffset;
+            _i2c_read_bytes(entryAddr, (byte*)&entryHeader, sizeof(EntryHeader));
+            if (entryHeader.status == 0x01 && entryHeader.keyLength >= prefixLen) {
+                _i2c_read_bytes(entryAddr + ENTRY_HEADER_SIZE, (byte*)key, prefixLen);
+                if (memcmp(key, prefix, prefixLen) == 0) ok = _markEntryAsDeleted(entryAddr) && ok;
+            }
+            currentOffset += ENTRY_HEADER_SIZE + entryHeader.keyLength + entryHeader.valueLength;
+        }
+    }
+    if (_coldTier && _coldTier->count() > 0) {
+        ok = _coldTier->beginRewrite(_keepUnprefixed, (void*)prefix) && _coldTier->commitRewrite() && ok;
+    }
+    return ok;
+}
+
+/**
+ * @brief Rewrite filter of removePrefix(): keep cold keys outside prefix
+ */
+bool I2CMiniPrefs::_keepUnprefixed(const char* key, void* ctx) {
+    const char* prefix = static_cast<const char*>(ctx);
+    return strncmp(key, prefix, strlen(prefix)) != 0;
+}
+
+// Operation Tracing ----------------------------------------------------------
+
+void I2CMiniPrefs::enableTrace(PrefsTraceRecord* buffer, uint16_t capacity) {
+    _traceBuf = nullptr;
+    _traceCapacity = capacity;
+    _traceHead = 0;
+    _traceCount = 0;
+    _traceDropped = 0;
+    if (buffer && capacity) _traceBuf = buffer;
+}
+
+void I2CMiniPrefs::disableTrace() {
+    _traceBuf = nullptr;
+    _traceCapacity = 0;
+    _traceCount = 0;
+}
+
+/**
+ * @brief Append one record to the trace ring
+ * @param op Operation code
+ * @param keyHash Key hash (0 if not key-specific)
+ * @param valueSize Value bytes written or read
+ * @param result Operation outcome
+ * @param startUs micros() sampled at operation start
+ * @param startBusBytes _busBytes sampled at operation start
+ *
+ * Costs one micros() call and a 16-byte store; returns immediately
+ * when tracing is disabled.
+ */
+void I2CMiniPrefs::_traceRecord(PrefsTraceOp op, uint16_t keyHash, size_t valueSize,
+                                bool result, uint32_t startUs, uint32_t startBusBytes) {
+    if (!_traceBuf) return;
+    uint32_t busBytes = _busBytes - startBusBytes;
+#if PREFS_THREAD_SAFE
+    portENTER_CRITICAL(&_traceMux);
+#endif
+    PrefsTraceRecord& rec = _traceBuf[_traceHead];
+    rec.timestampUs = startUs;
+    rec.latencyUs = micros() - startUs;
+    rec.keyHash = keyHash;
+    rec.valueSize = (uint16_t)valueSize;
+    rec.busBytes = busBytes > 0xFFFF ? 0xFFFF : (uint16_t)busBytes;
+    rec.op = op;
+    rec.result = result ? 1 : 0;
+    _traceHead = (_traceHead + 1) % _traceCapacity;
+    if (_traceCount < _traceCapacity) _traceCount++;
+    else _traceDropped++;
+#if PREFS_THREAD_SAFE
+    portEXIT_CRITICAL(&_traceMux);
+#endif
+}
+
+size_t I2CMiniPrefs::dumpTrace(Stream& out, bool clear) {
+    // Take the ring state and reset it in one go, then stream without
+    // holding the mux; _traceRecord() may run from another task meanwhile
+#if PREFS_THREAD_SAFE
+    portENTER_CRITICAL(&_traceMux);
+#endif
+    PrefsTraceRecord* buf = _traceBuf;
+    uint16_t capacity = _traceCapacity;
+    uint16_t head = _traceHead;
+    uint16_t count = _traceCount;
+    uint32_t dropped = _traceDropped;
+    if (clear) {
+        _traceCount = 0;
+        _traceDropped = 0;
+    }
+#if PREFS_THREAD_SAFE
+    portEXIT_CRITICAL(&_traceMux);
+#endif
+
+    byte header[12];
+    memcpy(header, PREFS_TRACE_MAGIC, 4);
+    header[4] = PREFS_TRACE_VERSION;
+    header[5] = sizeof(PrefsTraceRecord);
+    header[6] = (byte)(count & 0xFF);
+    header[7] = (byte)(count >> 8);
+    for (uint8_t i = 0; i < 4; i++) header[8 + i] = (byte)(dropped >> (8 * i));
+    size_t written = out.write(header, sizeof(header));
+
+    if (buf) {
+        uint16_t first = (head + capacity - count) % capacity;
+        for (uint16_t i = 0; i < count; i++) {
+            // Copied under the mux so a concurrent append cannot tear it
+#if PREFS_THREAD_SAFE
+            portENTER_CRITICAL(&_traceMux);
+#endif
+            PrefsTraceRecord rec = buf[(first + i) % capacity];
+#if PREFS_THREAD_SAFE
+            portEXIT_CRITICAL(&_traceMux);
+#endif
+            written += out.write((const byte*)&rec, sizeof(rec));
+        }
+    }
+    return written;
+}
+
+// Backup and Restore ---------------------------------------------------------
+
+/**
+ * @brief Write all live entries as a binary snapshot
+ * @param out Destination stream
+ * @return Number of bytes written, 0 on error
+ *
+ * Walks every ACTIVE/VALID block once; each live entry costs one header
+ * read and one burst read of key and value.
+ */
+size_t I2CMiniPrefs::exportTo(Stream& out) {
+    LockGuard lock(*this, false);
+    if (!_isInitialized) return 0;
+
+    byte header[5];
+    memcpy(header, PREFS_EXPORT_MAGIC, 4);
+    header[4] = PREFS_EXPORT_VERSION;
+    size_t written = out.write(header, sizeof(header));
+
+    byte record[4 + _maxKeyLength + _maxValueLength];
+    uint16_t count = 0;
+    uint8_t crc = 0x00;
+
+    for (uint16_t blockIdx = 0; blockIdx < _totalBlocks; blockIdx++) {
+        BlockHeader blockHeader;
+        if (!_readBlockHeader(blockIdx, blockHeader)) continue;
+        if (blockHeader.status != BLOCK_STATUS_ACTIVE && 
+            blockHeader.status != BLOCK_STATUS_VALID) continue;
+
+        uint16_t currentEntryOffset = BLOCK_HEADER_SIZE;
+        uint16_t blockStartAddr = _getBlockAddress(blockIdx);
+
+        while (currentEntryOffset < blockHeader.currentOffset) {
+            EntryHeader entryHeader;
+            uint16_t entryHeaderAddr = blockStartAddr + currentEntryOffset;
+            _i2c_read_bytes(entryHeaderAddr, (byte*)&entryHeader, sizeof(EntryHeader));
+            currentEntryOffset += ENTRY_HEADER_SIZE + entryHeader.keyLength + entryHeader.valueLength;
+
+            if (entryHeader.status != 0x01 || entryHeader.dataType == TYPE_NONE ||
+                entryHeader.keyLength == 0 || entryHeader.keyLength > _maxKeyLength || 
+                entryHeader.valueLength > _maxValueLength) continue;
+            if (_expired(entryHeader.dataType, entryHeaderAddr + ENTRY_HEADER_SIZE + entryHeader.keyLength,
+                         entryHeader.valueLength)) continue;
+
+            size_t recordLen = 4 + entryHeader.keyLength + entryHeader.valueLength;
+            record[0] = entryHeader.dataType;
+            record[1] = entryHeader.keyLength;
+            record[2] = (byte)(entryHeader.valueLength & 0xFF);
+            record[3] = (byte)(entryHeader.valueLength >> 8);
+            _i2c_read_bytes(entryHeaderAddr + ENTRY_HEADER_SIZE, record + 4, recordLen - 4);
+
+            crc = _calculateCrc8(record, recordLen, crc);
+            if (out.write(record, recordLen) != recordLen) return 0;
+            written += recordLen;
+            count++;
+        }
+    }
+
+    // Cold entries not shadowed by a newer value on the chip
+    for (uint16_t i = 0; _coldTier && i < _coldTier->count(); i++) {
+        size_t recordLen = _coldTier->recordAt(i, record, sizeof(record));
+        if (recordLen == 0) continue;
+        char key[256];   // keyLength is a uint8_t
+        memcpy(key, record + 4, record[1]);
+        key[record[1]] = '\0';
+        uint16_t valueAddr, valueLen;
+        PrefDataType type;
+        if (_findEntry(key, valueAddr, valueLen, type) != 0) continue;
+
+        crc = _calculateCrc8(record, recordLen, crc);
+        if (out.write(record, recordLen) != recordLen) return 0;
+        written += recordLen;
+        count++;
+    }
+
+    // Terminator: end marker, entry count, CRC over records and count
+    byte trailer[4] = {0x00, (byte)(count & 0xFF), (byte)(count >> 8), 0};
+    trailer[3] = _calculateCrc8(trailer + 1, 2, crc);
+    if (out.write(trailer, sizeof(trailer)) != sizeof(trailer)) return 0;
+    return written + sizeof(trailer);
+}
+
+/**
+ * @brief Replace the store contents with a snapshot
+ * @param in Source stream
+ * @return true if the snapshot was valid and committed
+ *
+ * Steps:
+ * 1. Stream entries into an empty staging block (later duplicates win)
+ * 2. Verify entry count and CRC
+ * 3. Activate the staging block and update the global header
+ * 4. Mark the old blocks as empty
+ */
+bool I2CMiniPrefs::importFrom(Stream& in) {
+    LockGuard lock(*this, true);
+    _asyncDrain();
+    if (!_isInitialized) return false;
+
+    byte header[5];
+    if (in.readBytes(header, sizeof(header)) != sizeof(header) ||
+        memcmp(header, PREFS_EXPORT_MAGIC, 4) != 0 ||
+        header[4] != PREFS_EXPORT_VERSION) return false;
+
+    uint16_t stagingBlockIndex = _findEmptyBlock();
+    if (stagingBlockIndex == 0xFFFF) return false;
+    uint16_t stagingAddr = _getBlockAddress(stagingBlockIndex);
+    uint16_t writeOffset = BLOCK_HEADER_SIZE;
+
+    char key[_maxKeyLength + 1];
+    byte value[_maxValueLength];
+    uint16_t count = 0;
+    uint32_t stagedLive = 0, stagedDead = 0;
+    uint16_t stagedEntries = 0;
+    uint8_t crc = 0x00;
+
+    for (;;) {
+        byte type;
+        if (in.readBytes(&type, 1) != 1) return false;
+        if (type == 0x00) break;
+
+        byte lengths[3];
+        if (in.readBytes(lengths, sizeof(lengths)) != sizeof(lengths)) return false;
+        uint8_t keyLen = lengths[0];
+        uint16_t valueLen = lengths[1] | (lengths[2] << 8);
+        uint8_t baseType = type & ~PREFS_TTL_FLAG;
+        if (baseType == TYPE_NONE || baseType > TYPE_BYTES || keyLen == 0 ||
+            keyLen > _maxKeyLength || valueLen > _maxValueLength) return false;
+
+        if (in.readBytes((byte*)key, keyLen) != keyLen ||
+            in.readBytes(value, valueLen) != valueLen) return false;
+        key[keyLen] = '\0';
+        if (strlen(key) != keyLen) return false;
+
+        crc = _calculateCrc8(&type, 1, crc);
+        crc = _calculateCrc8(lengths, sizeof(lengths), crc);
+        crc = _calculateCrc8((const byte*)key, keyLen, crc);
+        crc = _calculateCrc8(value, valueLen, crc);
+
+        // Last occurrence of a key wins
+        EntryHeader oldEntryHeader;
+        uint16_t oldEntryAddr = _findEntryInBlock(stagingBlockIndex, writeOffset, key, oldEntryHeader);
+        // (staged entries are not counted in the usage statistics yet)
+        if (oldEntryAddr != 0) {
+            if (!_i2c_write_byte(oldEntryAddr, 0x00)) return false;
+            uint16_t oldEntrySize = ENTRY_HEADER_SIZE + oldEntryHeader.keyLength + oldEntryHeader.valueLength;
+            stagedLive -= oldEntrySize;
+            stagedDead += oldEntrySize;
+            stagedEntries--;
+        }
+
+        uint16_t entryTotalSize = ENTRY_HEADER_SIZE + keyLen + valueLen;
+        if ((writeOffset + entryTotalSize) > _blockSizeBytes) return false;
+        if (!_writeEntryData(stagingAddr + writeOffset, key, keyLen, (PrefDataType)type,
+                             value, valueLen)) return false;
+        writeOffset += entryTotalSize;
+        stagedLive += entryTotalSize;
+        stagedEntries++;
+        count++;
+    }
+
+    byte trailer[3];
+    if (in.readBytes(trailer, sizeof(trailer)) != sizeof(trailer)) return false;
+    if ((uint16_t)(trailer[0] | (trailer[1] << 8)) != count ||
+        _calculateCrc8(trailer, 2, crc) != trailer[2]) return false;
+
+    // Mark the staging block, which lookups keep ignoring, then point the
+    // global header at it. That write commits the import; the rest is
+    // what rollback() does and begin() repeats after a power cut.
+    BlockHeader stagingHeader = {
+        .status = BLOCK_STATUS_STAGED,
+        .currentOffset = writeOffset
+    };
+    if (!_writeBlockHeader(stagingBlockIndex, stagingHeader)) return false;
+
+    GlobalHeader globalHeader = {
+        .magic = PREFS_MAGIC,
+        .version = PREFS_VERSION,
+        .totalBlocks = _totalBlocks,
+        .activeBlockIndex = stagingBlockIndex
+    };
+    if (!_writeGlobalHeader(globalHeader)) return false;
+    _activeBlockIndex = stagingBlockIndex;
+    _compactEpoch++;
+
+    // Until the staging block is active, begin() has to finish the job
+    _isInitialized = _finishSwitch(stagingBlockIndex, stagingHeader);
+    if (_isInitialized) {
+        _liveBytes = stagedLive;
+        _deadBytes = stagedDead;
+        _liveEntries = stagedEntries;
+    } else {
+        _scanUsage();
+    }
+    return _isInitialized;
+}
+
+// Snapshots ------------------------------------------------------------------
+
+/**
+ * @brief Copy the live entries into an empty block and pin it
+ * @return Snapshot handle (block index + 1), 0 on error
+ *
+ * Entries are written before the header, so a block cut short while
+ * copying still reads as empty. In-place deletes keep the pinned copy
+ * untouched, since lookups never reach a SNAPSHOT block.
+ */
+PrefsSnapshot I2CMiniPrefs::snapshot() {
+    LockGuard lock(*this, true);
+    _asyncDrain();
+    // Cold entries live outside the chip and would not roll back
+    if (!_isInitialized || _coldTier) return 0;
+
+    uint16_t snapBlockIndex = _findEmptyBlock();
+    if (snapBlockIndex == 0xFFFF) return 0;
+    uint16_t snapBlockAddr = _getBlockAddress(snapBlockIndex);
+    uint16_t writeOffset = BLOCK_HEADER_SIZE;
+
+    for (uint16_t blockIdx = 0; blockIdx < _totalBlocks; blockIdx++) {
+        BlockHeader blockHeader;
+        if (!_readBlockHeader(blockIdx, blockHeader)) continue;
+        if (blockHeader.status != BLOCK_STATUS_ACTIVE && 
+            blockHeader.status != BLOCK_STATUS_VALID) continue;
+
+        uint16_t blockAddr = _getBlockAddress(blockIdx);
+        uint16_t readOffset = BLOCK_HEADER_SIZE;
+        while (readOffset < blockHeader.currentOffset) {
+            EntryHeader entryHeader;
+            uint16_t entryHeaderAddr = blockAddr + readOffset;
+            _i2c_read_bytes(entryHeaderAddr, (byte*)&entryHeader, sizeof(EntryHeader));
+            uint16_t entryTotalSize = ENTRY_HEADER_SIZE + entryHeader.keyLength + entryHeader.valueLength;
+
+            if (entryHeader.status == 0x01 && 
+                entryHeader.keyLength <= _maxKeyLength && 
+                entryHeader.valueLength <= _maxValueLength &&
+                !_expired(entryHeader.dataType, entryHeaderAddr + ENTRY_HEADER_SIZE + entryHeader.keyLength,
+                          entryHeader.valueLength)) {
+                if ((writeOffset + entryTotalSize) > _blockSizeBytes) return 0;
+
+                byte* entryData = new byte[entryTotalSize];
+                bool copied = _i2c_read_bytes(entryHeaderAddr, entryData, entryTotalSize) &&
+                              _i2c_write_bytes(snapBlockAddr + writeOffset, entryData, entryTotalSize);
+                delete[] entryData;
+                if (!copied) return 0;
+                writeOffset += entryTotalSize;
+            }
+            readOffset += entryTotalSize;
+        }
+    }
+
+    BlockHeader snapHeader = {
+        .status = BLOCK_STATUS_SNAPSHOT,
+        .currentOffset = writeOffset
+    };
+    if (!_writeBlockHeader(snapBlockIndex, snapHeader)) return 0;
+    return snapBlockIndex + 1;
+}
+
+/**
+ * @brief Make a snapshot block the active block
+ * @param snap Snapshot handle
+ * @return true if the store now holds the snapshot contents
+ *
+ * Pointing the global header at the snapshot block commits the rollback;
+ * the remaining header writes are repeated by begin() after a power cut.
+ */
+bool I2CMiniPrefs::rollback(PrefsSnapshot snap) {
+    LockGuard lock(*this, true);
+    _asyncDrain();
+    BlockHeader snapHeader;
+    if (!_isInitialized || _coldTier || !_readSnapshotHeader(snap, snapHeader)) return false;
+
+    GlobalHeader globalHeader = {
+        .magic = PREFS_MAGIC,
+        .version = PREFS_VERSION,
+        .totalBlocks = _totalBlocks,
+        .activeBlockIndex = (uint16_t)(snap - 1)
+    };
+    if (!_writeGlobalHeader(globalHeader)) return false;
+    _activeBlockIndex = snap - 1;
+
+    // Until the snapshot block is active, begin() has to finish the job
+    _isInitialized = _finishSwitch(_activeBlockIndex, snapHeader);
+    _scanUsage();
+    _compactEpoch++;
+    return _isInitialized;
+}
+
+bool I2CMiniPrefs::release(PrefsSnapshot snap) {
+    LockGuard lock(*this, true);
+    _asyncDrain();
+    BlockHeader snapHeader;
+    if (!_readSnapshotHeader(snap, snapHeader)) return false;
+    snapHeader.status = BLOCK_STATUS_EMPTY;
+    snapHeader.currentOffset = BLOCK_HEADER_SIZE;
+    return _writeBlockHeader(snap - 1, snapHeader);
+}
+
+uint16_t I2CMiniPrefs::snapshots(PrefsSnapshot* out, uint16_t max) {
+    LockGuard lock(*this, false);
+    uint16_t count = 0;
+    for (uint16_t blockIdx = 0; blockIdx < _totalBlocks; blockIdx++) {
+        BlockHeader blockHeader;
+        if (!_readBlockHeader(blockIdx, blockHeader) ||
+            blockHeader.status != BLOCK_STATUS_SNAPSHOT) continue;
+        if (out && count < max) out[count] = blockIdx + 1;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Read the header of a snapshot block
+ * @param snap Snapshot handle
+ * @param header Receives the block header
+ * @return false if snap does not name a snapshot
+ */
+bool I2CMiniPrefs::_readSnapshotHeader(PrefsSnapshot snap, BlockHeader& header) {
+    return snap != 0 && snap <= _totalBlocks &&
+           _readBlockHeader(snap - 1, header) && header.status == BLOCK_STATUS_SNAPSHOT;
+}
+
+/**
+ * @brief Make a pinned block the only live block, after the global header points at it
+ * @param blockIndex Snapshot block of rollback(), staging block of importFrom(),
+ *        target block of _migrateV1() or of an asynchronous GC
+ * @param header Its header; status is set to ACTIVE
+ * @return true if the pinned block is the only live block now
+ *
+ * The replaced contents are dropped first, so a cut never leaves stale
+ * entries visible next to the activated block. An import replaces the
+ * cold entries as well.
+ */
+bool I2CMiniPrefs::_finishSwitch(uint16_t blockIndex, BlockHeader& header) {
+    if (header.status == BLOCK_STATUS_STAGED && _coldTier && !_coldTier->clear()) return false;
+    if (!_releaseBlocksExcept(blockIndex)) return false;
+    header.status = BLOCK_STATUS_ACTIVE;
+    return _writeBlockHeader(blockIndex, header);
+}
+
+// Asynchronous Operations ----------------------------------------------------
+
+/// Steps of the asynchronous state machine
+enum : uint8_t {
+    ASYNC_START,             ///< Pick up the request at the queue head
+    ASYNC_FIND_BLOCK,        ///< Read next block header while looking for the key
+    ASYNC_FIND_ENTRY,        ///< Read next entry header
+    ASYNC_FIND_KEY,          ///< Compare key of a hash match
+    ASYNC_GET_VALUE,         ///< Read next slice of the found value
+    ASYNC_SPACE,             ///< Check room in the active block
+    ASYNC_ENTRY,             ///< Stage next slice of the new entry
+    ASYNC_COMMIT,            ///< Stage the updated active block header
+    ASYNC_SUPERSEDE,         ///< Mark the replaced entry as deleted
+    ASYNC_FLUSH,             ///< Send one burst of the staged bytes
+    ASYNC_VERIFY,            ///< Read that burst back (setVerifyAfterWrite())
+    ASYNC_GC_PLAN,           ///< Check the fit, move entries to the cold tier
+    ASYNC_GC_FIND,           ///< Look for an empty target block
+    ASYNC_GC_OPEN,           ///< Start copying into the target block
+    ASYNC_GC_SRC_BLOCK,      ///< Read next source block header
+    ASYNC_GC_SRC_ENTRY,      ///< Read next source entry header
+    ASYNC_GC_COPY,           ///< Read next slice of a live entry
+    ASYNC_GC_COPIED,         ///< Advance after a copied slice
+    ASYNC_GC_FINISH,         ///< Stage the complete target block header
+    ASYNC_GC_GLOBAL,         ///< Stage the global header (commit point)
+    ASYNC_GC_ACTIVATE,       ///< Make the target the active block
+    ASYNC_GC_RELEASE,        ///< Mark next source block as empty
+    ASYNC_GC_DONE,           ///< Return to the interrupted put
+    ASYNC_DONE               ///< Request completed successfully
+};
+
+PrefsAsyncHandle I2CMiniPrefs::putAsync(const char* key, PrefDataType type, const void* buf,
+                                        size_t len, PrefsAsyncCallback callback, void* ctx) {
+    if (type == TYPE_NONE || (!buf && len > 0) || len > _maxValueLength) return 0;
+    return _asyncEnqueue(key, PREFS_ASYNC_PUT, type, buf, nullptr, len, callback, ctx);
+}
+
+PrefsAsyncRef I2CMiniPrefs::removeAsync(const char* key, PrefsAsyncCallback callback,
+                                        void* ctx) {
+    PrefsAsyncRef ref = {this, _asyncEnqueue(key, PREFS_ASYNC_REMOVE, TYPE_NONE, nullptr,
+                                             nullptr, 0, callback, ctx)};
+    return ref;
+}
+
+PrefsAsyncHandle I2CMiniPrefs::getAsync(const char* key, PrefDataType type, void* buf,
+                                        size_t len, PrefsAsyncCallback callback, void* ctx) {
+    if (type == TYPE_NONE || (!buf && len > 0) || len > _maxValueLength) return 0;
+    return _asyncEnqueue(key, PREFS_ASYNC_GET, type, nullptr, buf, len, callback, ctx);
+}
+
+PrefsAsyncStatus I2CMiniPrefs::setAsyncCallback(PrefsAsyncHandle handle,
+                                                PrefsAsyncCallback callback, void* ctx) {
+    if (handle == 0) return PREFS_ASYNC_UNKNOWN;
+    LockGuard lock(*this, true);
+    for (uint8_t i = 0; i < PREFS_ASYNC_QUEUE_SIZE; i++) {
+        PrefsAsyncRequest& req = _asyncQueue[i];
+        if (req.handle != handle) continue;
+        if (req.status == PREFS_ASYNC_PENDING) {
+            req.callback = callback;
+            req.ctx = ctx;
+        }
+        return (PrefsAsyncStatus)req.status;
+    }
+    return PREFS_ASYNC_UNKNOWN;
+}
+
+bool I2CMiniPrefs::poll() {
+    struct {
+        PrefsAsyncCallback callback;
+        PrefsAsyncHandle handle;
+        bool success;
+        void* ctx;
+    } finished[PREFS_ASYNC_QUEUE_SIZE];
+    uint8_t finishedCount = 0;
+    bool pending;
+
+    {
+        LockGuard lock(*this, true);
+        if (_asyncCount > 0 && !_writeCycleBusy()) _asyncStep();
+        pending = _asyncCount > 0;
+
+        // Collect callbacks, also those of requests drained by sync calls
+        for (uint8_t i = 0; i < PREFS_ASYNC_QUEUE_SIZE; i++) {
+            PrefsAsyncRequest& req = _asyncQueue[i];
+            if (!req.notify) continue;
+            req.notify = false;
+            finished[finishedCount].callback = req.callback;
+            finished[finishedCount].handle = req.handle;
+            finished[finishedCount].success = req.status == PREFS_ASYNC_DONE;
+            finished[finishedCount].ctx = req.ctx;
+            finishedCount++;
+        }
+    }
+
+    // Callbacks may call back into the store
+    for (uint8_t i = 0; i < finishedCount; i++) {
+        finished[i].callback(finished[i].handle, finished[i].success, finished[i].ctx);
+    }
+    return pending;
+}
+
+PrefsAsyncStatus I2CMiniPrefs::asyncStatus(PrefsAsyncHandle handle) const {
+    if (handle == 0) return PREFS_ASYNC_UNKNOWN;
+    for (uint8_t i = 0; i < PREFS_ASYNC_QUEUE_SIZE; i++) {
+        if (_asyncQueue[i].handle == handle) return (PrefsAsyncStatus)_asyncQueue[i].status;
+    }
+    return PREFS_ASYNC_UNKNOWN;
+}
+
+/**
+ * @brief Validate and queue a request
+ * @return Request handle, 0 if rejected
+ */
+PrefsAsyncHandle I2CMiniPrefs::_asyncEnqueue(const char* key, PrefsAsyncKind kind,
+                                             PrefDataType type, const void* buf, void* dest, size_t len,
+                                             PrefsAsyncCallback callback, void* ctx) {
+    if (!key) return 0;
+    size_t keyLen = strlen(key);
+    if (keyLen == 0 || keyLen > PREFS_ASYNC_KEY_SIZE || keyLen > _maxKeyLength) return 0;
+
+    LockGuard lock(*this, true);
+    if (!_isInitialized || _asyncCount >= PREFS_ASYNC_QUEUE_SIZE) return 0;
+
+    // Slot is free once its callback has been delivered
+    PrefsAsyncRequest& req = _asyncQueue[(_asyncHead + _asyncCount) % PREFS_ASYNC_QUEUE_SIZE];
+    if (req.notify) return 0;
+
+    if (++_asyncNextHandle == 0) _asyncNextHandle = 1;
+    req.handle = _asyncNextHandle;
+    req.status = PREFS_ASYNC_PENDING;
+    req.kind = kind;
+    req.notify = false;
+    req.dataType = type;
+    memcpy(req.key, key, keyLen + 1);
+    req.valueLength = len;
+    req.dest = dest;
+    if (kind == PREFS_ASYNC_PUT && len <= PREFS_ASYNC_INLINE_SIZE) {
+        if (len > 0) memcpy(req.inlineValue, buf, len);
+        req.value = req.inlineValue;
+    } else {
+        req.value = buf;
+    }
+    req.callback = callback;
+    req.ctx = ctx;
+    req.startUs = micros();
+    _asyncCount++;
+    return req.handle;
+}
+
+/**
+ * @brief Finish all queued requests synchronously
+ *
+ * Called by the blocking API before it touches the store, so a request
+ * is never interleaved with a synchronous operation. Callbacks are
+ * delivered by the next poll().
+ */
+void I2CMiniPrefs::_asyncDrain() {
+    while (_asyncCount > 0) {
+        _waitWriteCycle();
+        _asyncStep();
+    }
+}
+
+/**
+ * @brief Finish the request at the queue head
+ * @param success Result reported to the caller
+ */
+void I2CMiniPrefs::_asyncComplete(bool success) {
+    PrefsAsyncRequest& req = _asyncQueue[_asyncHead];
+    req.status = success ? PREFS_ASYNC_DONE : PREFS_ASYNC_FAILED;
+    req.notify = req.callback != nullptr;
+    static const PrefsTraceOp traceOps[] = {PREFS_TRACE_PUT, PREFS_TRACE_REMOVE, PREFS_TRACE_GET};
+    _traceRecord(traceOps[req.kind], _hashKey(req.key),
+                 req.kind == PREFS_ASYNC_REMOVE ? 0 : req.valueLength, success,
+                 req.startUs, _asyncStartBus);
+    _asyncHead = (_asyncHead + 1) % PREFS_ASYNC_QUEUE_SIZE;
+    _asyncCount--;
+    _asyncPhase = ASYNC_START;
+    // A garbage collection that failed before its commit left the sources
+    // untouched. One past it is finished here or, if that fails as well,
+    // by begin().
+    if (!success && _asyncGcActive) {
+        if (_activeBlockIndex == _asyncGcTarget) {
+            BlockHeader header = {
+                .status = BLOCK_STATUS_COMPACT,
+                .currentOffset = _asyncGcOffset
+            };
+            _isInitialized = _finishSwitch(_asyncGcTarget, header);
+        }
+        delete[] _coldMoved;
+        _coldMoved = nullptr;
+        _coldMovedCount = 0;
+        _scanUsage();
+    }
+    _asyncGcActive = false;
+}
+
+/**
+ * @brief Stage bytes to be programmed, one page burst per step
+ * @param address Target address
+ * @param data Bytes to program (copied, at most PREFS_ASYNC_SLICE)
+ * @param len Number of bytes
+ * @param nextPhase Step to continue with once all bytes are programmed
+ */
+void I2CMiniPrefs::_asyncFlush(uint16_t address, const byte* data, uint8_t len,
+                               uint8_t nextPhase) {
+    memcpy(_asyncBuf, data, len);
+    _asyncBufLen = len;
+    _asyncBufPos = 0;
+    _asyncAttempt = 0;
+    _asyncFlushAddr = address;
+    _asyncAfterFlush = nextPhase;
+    _asyncPhase = ASYNC_FLUSH;
+}
+
+/**
+ * @brief Stage a block header with a fresh checksum
+ * @param blockIndex Block to update
+ * @param status New block status
+ * @param offset New write offset
+ * @param nextPhase Step to continue with afterwards
+ */
+void I2CMiniPrefs::_asyncFlushBlockHeader(uint16_t blockIndex, uint8_t status, uint16_t offset,
+                                          uint8_t nextPhase) {
+    BlockHeader header;
+    memset(&header, 0, sizeof(header));
+    header.status = status;
+    header.currentOffset = offset;
+    header.checksum = _blockHeaderCrc(header);
+    _asyncFlush(_getBlockAddress(blockIndex), (const byte*)&header, sizeof(header), nextPhase);
+}
+
+/**
+ * @brief Advance the running request by at most one I2C transfer
+ */
+void I2CMiniPrefs::_asyncStep() {
+    _gcRunning = _asyncGcActive;
+    _asyncRun();
+    _gcRunning = false;
+}
+
+/**
+ * @brief State machine body, see _asyncStep()
+ *
+ * Steps that only stage data fall through to the next step; every other
+ * step returns after a single transfer.
+ */
+void I2CMiniPrefs::_asyncRun() {
+    for (;;) {
+        if (_asyncCount == 0) return;
+        PrefsAsyncRequest& req = _asyncQueue[_asyncHead];
+        uint8_t keyLen = strlen(req.key);
+
+        switch (_asyncPhase) {
+        case ASYNC_START:
+            if (!_isInitialized) {
+                _asyncComplete(false);
+                return;
+            }
+            _asyncStartBus = _busBytes;
+            _asyncGcDone = false;
+            _asyncOldAddr = 0;
+            _asyncBlock = 0;
+            _asyncPhase = ASYNC_FIND_BLOCK;
+            break;
+
+        // Lookup of an existing entry, same order as _findEntry()
+        case ASYNC_FIND_BLOCK: {
+            if (_asyncBlock >= _totalBlocks) {
+                if (req.kind == PREFS_ASYNC_PUT) _asyncPhase = ASYNC_SPACE;
+                else if (!_coldTier) _asyncComplete(false);
+                else if (req.kind == PREFS_ASYNC_GET) {
+                    _asyncComplete(_coldTier->get(req.key, (PrefDataType)req.dataType, req.dest,
+                                                  req.valueLength) == req.valueLength);
+                } else {
+                    _asyncComplete(_coldTier->contains(req.key) && _coldTier->remove(req.key));
+                }
+                break;
+            }
+            BlockHeader header;
+            if (_readBlockHeader(_asyncBlock, header) &&
+                (header.status == BLOCK_STATUS_ACTIVE || header.status == BLOCK_STATUS_VALID)) {
+                _asyncOffset = BLOCK_HEADER_SIZE;
+                _asyncBlockEnd = header.currentOffset;
+                _asyncPhase = ASYNC_FIND_ENTRY;
+            } else {
+                _asyncBlock++;
+            }
+            return;
+        }
+
+        case ASYNC_FIND_ENTRY:
+            if (_asyncOffset >= _asyncBlockEnd) {
+                _asyncBlock++;
+                _asyncPhase = ASYNC_FIND_BLOCK;
+                break;
+            }
+            _asyncAddr = _getBlockAddress(_asyncBlock) + _asyncOffset;
+            _i2c_read_bytes(_asyncAddr, (byte*)&_asyncEntry, sizeof(EntryHeader));
+            if (_asyncEntry.status != 0x00 && _asyncEntry.keyLength == keyLen &&
+                _asyncEntry.keyHash == _hashKey(req.key)) {
+                _asyncPhase = ASYNC_FIND_KEY;
+            } else {
+                _asyncOffset += ENTRY_HEADER_SIZE + _asyncEntry.keyLength + _asyncEntry.valueLength;
+            }
+            return;
+
+        case ASYNC_FIND_KEY: {
+            char readKey[PREFS_ASYNC_KEY_SIZE];
+            _i2c_read_bytes(_asyncAddr + ENTRY_HEADER_SIZE, (byte*)readKey, keyLen);
+            if (memcmp(readKey, req.key, keyLen) != 0) {
+                _asyncOffset += ENTRY_HEADER_SIZE + _asyncEntry.keyLength + _asyncEntry.valueLength;
+                _asyncPhase = ASYNC_FIND_ENTRY;
+            } else if (req.kind == PREFS_ASYNC_GET) {
+                _asyncAddr += ENTRY_HEADER_SIZE + keyLen;
+                uint16_t valueLen = _asyncEntry.valueLength;
+                if (_asyncEntry.dataType & PREFS_TTL_FLAG) {
+                    if (_expired(_asyncEntry.dataType, _asyncAddr, valueLen)) {
+                        _asyncComplete(false);
+                        return;
+                    }
+                    _asyncAddr += PREFS_TTL_STAMP_SIZE;
+                    valueLen -= PREFS_TTL_STAMP_SIZE;
+                }
+                if ((_asyncEntry.dataType & ~PREFS_TTL_FLAG) != req.dataType ||
+                    valueLen != req.valueLength) {
+                    _asyncComplete(false);
+                    return;
+                }
+                _asyncCopyPos = 0;
+                _asyncPhase = ASYNC_GET_VALUE;
+            } else if (req.kind == PREFS_ASYNC_PUT) {
+                // Superseded only once the new entry is committed; begin()
+                // deletes it if a cut comes in between
+                _asyncOldAddr = _asyncAddr;
+                _asyncOldSize = ENTRY_HEADER_SIZE + keyLen + _asyncEntry.valueLength;
+                _asyncPhase = ASYNC_SPACE;
+            } else if (_expired(_asyncEntry.dataType, _asyncAddr + ENTRY_HEADER_SIZE + keyLen,
+                                _asyncEntry.valueLength)) {
+                // Not found, as in remove(); garbage collection drops it
+                _asyncComplete(_coldTier && _coldTier->contains(req.key) &&
+                               _coldTier->remove(req.key));
+            } else {
+                if (_coldTier && _coldTier->contains(req.key)) _coldTier->remove(req.key);
+                _asyncOldAddr = _asyncAddr;
+                _asyncOldSize = ENTRY_HEADER_SIZE + keyLen + _asyncEntry.valueLength;
+                _asyncPhase = ASYNC_SUPERSEDE;
+                break;
+            }
+            return;
+        }
+
+        case ASYNC_GET_VALUE: {
+            if (_asyncCopyPos >= req.valueLength) {
+                _asyncComplete(true);
+                return;
+            }
+            uint8_t len = min((uint16_t)(req.valueLength - _asyncCopyPos), (uint16_t)PREFS_ASYNC_SLICE);
+            _i2c_read_bytes(_asyncAddr + _asyncCopyPos, (byte*)req.dest + _asyncCopyPos, len);
+            _asyncCopyPos += len;
+            if (_asyncCopyPos >= req.valueLength) _asyncComplete(true);
+            return;
+        }
+
+        // Append the new entry to the active block
+        case ASYNC_SPACE: {
+            BlockHeader header;
+            if (!_readBlockHeader(_activeBlockIndex, header) ||
+                header.status != BLOCK_STATUS_ACTIVE) {
+                _asyncComplete(false);
+                return;
+            }
+            uint16_t entryTotalSize = ENTRY_HEADER_SIZE + keyLen + req.valueLength;
+            if ((header.currentOffset + entryTotalSize) <= _blockSizeBytes) {
+                _asyncAddr = _getBlockAddress(_activeBlockIndex) + header.currentOffset;
+                _asyncBlockEnd = header.currentOffset + entryTotalSize;
+                _asyncOffset = 0;
+                _asyncPhase = ASYNC_ENTRY;
+            } else if (!_asyncGcDone) {
+                _asyncGcDone = true;
+                _asyncGcActive = true;
+                _gcRunning = true;
+                _asyncGcTarget = 0xFFFF;
+                _asyncPhase = ASYNC_GC_PLAN;
+                break;
+            } else {
+                _asyncComplete(false);
+            }
+            return;
+        }
+
+        case ASYNC_ENTRY: {
+            EntryHeader header;
+            memset(&header, 0, sizeof(header));
+            header.status = 0x01;
+            header.dataType = req.dataType;
+            header.keyHash = _hashKey(req.key);
+            header.keyLength = keyLen;
+            header.valueLength = req.valueLength;
+
+            // Next slice of header | key | value
+            uint16_t entryTotalSize = ENTRY_HEADER_SIZE + keyLen + req.valueLength;
+            byte slice[PREFS_ASYNC_SLICE];
+            uint8_t len = 0;
+            for (; len < PREFS_ASYNC_SLICE && _asyncOffset + len < entryTotalSize; len++) {
+                uint16_t pos = _asyncOffset + len;
+                if (pos < ENTRY_HEADER_SIZE) {
+                    slice[len] = ((const byte*)&header)[pos];
+                } else if (pos < ENTRY_HEADER_SIZE + keyLen) {
+                    slice[len] = req.key[pos - ENTRY_HEADER_SIZE];
+                } else {
+                    slice[len] = ((const byte*)req.value)[pos - ENTRY_HEADER_SIZE - keyLen];
+                }
+            }
+            uint16_t sliceAddr = _asyncAddr + _asyncOffset;
+            _asyncOffset += len;
+            _asyncFlush(sliceAddr, slice, len,
+                        _asyncOffset >= entryTotalSize ? ASYNC_COMMIT : ASYNC_ENTRY);
+            break;
+        }
+
+        case ASYNC_COMMIT:
+            _liveBytes += ENTRY_HEADER_SIZE + keyLen + req.valueLength;
+            _liveEntries++;
+            _asyncFlushBlockHeader(_activeBlockIndex, BLOCK_STATUS_ACTIVE, _asyncBlockEnd,
+                                   _asyncOldAddr ? ASYNC_SUPERSEDE : ASYNC_DONE);
+            break;
+
+        case ASYNC_SUPERSEDE: {
+            _liveBytes -= min((uint32_t)_asyncOldSize, _liveBytes);
+            _deadBytes += _asyncOldSize;
+            if (_liveEntries > 0) _liveEntries--;
+            const byte deleted = 0x00;
+            _asyncFlush(_asyncOldAddr, &deleted, 1, ASYNC_DONE);
+            break;
+        }
+
+        // One burst per step, split at EEPROM page boundaries. Retries
+        // and the read-back are steps of their own, so poll() lets the
+        // write cycle pass instead of waiting inside _i2c_flush().
+        case ASYNC_FLUSH:
+        case ASYNC_VERIFY: {
+            uint16_t addr = _asyncFlushAddr + _asyncBufPos;
+            uint8_t len = _asyncBufLen - _asyncBufPos;
+            if (_memoryType == MEM_TYPE_EEPROM) {
+                len = min((uint16_t)len, (uint16_t)(_pageSize - (addr % _pageSize)));
+            }
+            const byte* data = _asyncBuf + _asyncBufPos;
+            bool done;
+            if (_asyncPhase == ASYNC_VERIFY) {
+                done = _i2c_verify_burst(addr, data, len);
+            } else if (_asyncAttempt == 0 && _i2c_unchanged(addr, data, len)) {
+                _skippedWrites++;
+                done = true;
+            } else {
+                if (_asyncAttempt > 0) _errorStats.retries++;
+                done = _i2c_send_burst(addr, data, len);
+                if (done && _verifyAfterWrite) {
+                    _asyncPhase = ASYNC_VERIFY;
+                    return;
+                }
+            }
+            if (!done) {
+                _asyncPhase = ASYNC_FLUSH;
+                if (++_asyncAttempt > PREFS_WRITE_RETRIES) {
+                    _errorStats.failedWrites++;
+                    _asyncComplete(false);
+                }
+                return;
+            }
+            _asyncBufPos += len;
+            _asyncAttempt = 0;
+            _asyncPhase = ASYNC_FLUSH;
+            if (_asyncBufPos >= _asyncBufLen) {
+                _asyncPhase = _asyncAfterFlush;
+                if (_asyncPhase == ASYNC_DONE) _asyncComplete(true);
+            }
+            return;
+        }
+
+        // Incremental garbage collection. Unlike _compactInto() it leaves
+        // the sources untouched until the global header points at the
+        // target, which readers ignore as a COMPACT block until then: a
+        // get() between two steps, a failed step and a power cut all find
+        // the previous contents. After the commit the target is activated
+        // before the sources are released, so readers see every entry
+        // twice for a few steps; begin() releases what a cut leaves.
+        // A full store fails before anything is touched. GC drops expired
+        // entries; the rescan for them reads every header, but only when
+        // nearly full. With a cold tier, entries due for it are committed
+        // there first, in this one blocking step, as by
+        // _runGarbageCollection(). The replaced entry is carried over
+        // unless the new one only fits without it; then it is dropped
+        // first, as by the blocking put.
+        case ASYNC_GC_PLAN: {
+            uint32_t neededBytes = BLOCK_HEADER_SIZE + ENTRY_HEADER_SIZE + keyLen + req.valueLength;
+            uint32_t keptBytes = _liveBytes;
+            if (_coldTier) {
+                uint16_t maxMoved = _coldMoveLimit();
+                uint16_t* moved = new uint16_t[maxMoved];
+                uint16_t movedCount = 0;
+                keptBytes = _liveEntryBytes(maxMoved, moved, &movedCount);
+                // The entry being replaced stays on the chip
+                for (uint16_t i = 0; i < movedCount; i++) {
+                    if (moved[i] != _asyncOldAddr) continue;
+                    moved[i] = moved[--movedCount];
+                    keptBytes += _asyncOldSize;
+                    break;
+                }
+                _coldMoved = moved;
+                _coldMovedCount = 0;
+                if (movedCount > 0 && !_moveToColdTier(moved, movedCount)) {
+                    keptBytes = _liveEntryBytes(0);
+                }
+            } else if (neededBytes + keptBytes > _blockSizeBytes) {
+                keptBytes = _liveEntryBytes();
+            }
+            _asyncGcCarry = neededBytes + keptBytes <= _blockSizeBytes;
+            if (!_asyncGcCarry && (!_asyncOldAddr ||
+                neededBytes + keptBytes - _asyncOldSize > _blockSizeBytes)) {
+                _asyncComplete(false);
+                return;
+            }
+            _asyncBlock = 0;
+            _asyncPhase = ASYNC_GC_FIND;
+            return;
+        }
+
+        case ASYNC_GC_FIND: {
+            if (_asyncBlock >= _totalBlocks) {
+                _asyncComplete(false);
+                return;
+            }
+            BlockHeader header;
+            if (!_readBlockHeader(_asyncBlock, header) || header.status == BLOCK_STATUS_EMPTY ||
+                header.status == BLOCK_STATUS_STAGED || header.status == BLOCK_STATUS_UPGRADE ||
+                header.status == BLOCK_STATUS_COMPACT) {
+                _asyncGcTarget = _asyncBlock;
+                _asyncPhase = ASYNC_GC_OPEN;
+            } else {
+                _asyncBlock++;
+            }
+            return;
+        }
+
+        case ASYNC_GC_OPEN:
+            _asyncGcOffset = BLOCK_HEADER_SIZE;
+            _asyncGcEntries = 0;
+            _asyncGcOldAddr = 0;
+            _asyncBlock = 0;
+            _asyncPhase = ASYNC_GC_SRC_BLOCK;
+            break;
+
+        case ASYNC_GC_SRC_BLOCK: {
+            if (_asyncBlock >= _totalBlocks) {
+                _asyncPhase = ASYNC_GC_FINISH;
+                break;
+            }
+            if (_asyncBlock == _asyncGcTarget) {
+                _asyncBlock++;
+                break;
+            }
+            BlockHeader header;
+            if (_readBlockHeader(_asyncBlock, header) &&
+                (header.status == BLOCK_STATUS_ACTIVE || header.status == BLOCK_STATUS_VALID)) {
+                _asyncOffset = BLOCK_HEADER_SIZE;
+                _asyncBlockEnd = header.currentOffset;
+                _asyncPhase = ASYNC_GC_SRC_ENTRY;
+            } else {
+                _asyncBlock++;
+            }
+            return;
+        }
+
+        case ASYNC_GC_SRC_ENTRY: {
+            if (_asyncOffset >= _asyncBlockEnd) {
+                _asyncBlock++;
+                _asyncPhase = ASYNC_GC_SRC_BLOCK;
+                break;
+            }
+            uint16_t entryAddr = _getBlockAddress(_asyncBlock) + _asyncOffset;
+            _i2c_read_bytes(entryAddr, (byte*)&_asyncEntry, sizeof(EntryHeader));
+            uint16_t entryTotalSize = ENTRY_HEADER_SIZE + _asyncEntry.keyLength + _asyncEntry.valueLength;
+            if (_asyncEntry.status == 0x01 &&
+                (_asyncGcCarry || entryAddr != _asyncOldAddr) &&
+                !_isColdMoved(entryAddr, nullptr) &&
+                _asyncEntry.keyLength <= _maxKeyLength &&
+                _asyncEntry.valueLength <= _maxValueLength &&
+                !_expired(_asyncEntry.dataType, entryAddr + ENTRY_HEADER_SIZE + _asyncEntry.keyLength,
+                          _asyncEntry.valueLength)) {
+                if ((_asyncGcOffset + entryTotalSize) > _blockSizeBytes) {
+                    _asyncComplete(false);
+                    return;
+                }
+                _asyncCopyPos = 0;
+                _asyncPhase = ASYNC_GC_COPY;
+            } else {
+                _asyncOffset += entryTotalSize;
+            }
+            return;
+        }
+
+        case ASYNC_GC_COPY: {
+            uint16_t entryTotalSize = ENTRY_HEADER_SIZE + _asyncEntry.keyLength + _asyncEntry.valueLength;
+            uint8_t len = min((uint16_t)(entryTotalSize - _asyncCopyPos), (uint16_t)PREFS_ASYNC_SLICE);
+            byte slice[PREFS_ASYNC_SLICE];
+            _i2c_read_bytes(_getBlockAddress(_asyncBlock) + _asyncOffset + _asyncCopyPos, slice, len);
+            // Same aging as _compactInto(), on the slice holding the header
+            uint16_t agePos = offsetof(EntryHeader, age);
+            if (agePos >= _asyncCopyPos && agePos < _asyncCopyPos + len &&
+                slice[agePos - _asyncCopyPos] < 0xFF) {
+                slice[agePos - _asyncCopyPos]++;
+            }
+            _asyncFlush(_getBlockAddress(_asyncGcTarget) + _asyncGcOffset + _asyncCopyPos,
+                        slice, len, ASYNC_GC_COPIED);
+            _asyncCopyPos += len;
+            return;
+        }
+
+        case ASYNC_GC_COPIED: {
+            uint16_t entryTotalSize = ENTRY_HEADER_SIZE + _asyncEntry.keyLength + _asyncEntry.valueLength;
+            if (_asyncCopyPos < entryTotalSize) {
+                _asyncPhase = ASYNC_GC_COPY;
+                break;
+            }
+            // The running put supersedes the copy of its entry instead
+            if (_getBlockAddress(_asyncBlock) + _asyncOffset == _asyncOldAddr) {
+                _asyncGcOldAddr = _getBlockAddress(_asyncGcTarget) + _asyncGcOffset;
+            }
+            _asyncGcOffset += entryTotalSize;
+            _asyncGcEntries++;
+            _asyncOffset += entryTotalSize;
+            _asyncPhase = ASYNC_GC_SRC_ENTRY;
+            break;
+        }
+
+        case ASYNC_GC_FINISH:
+            _asyncFlushBlockHeader(_asyncGcTarget, BLOCK_STATUS_COMPACT, _asyncGcOffset,
+                                   ASYNC_GC_GLOBAL);
+            break;
+
+        case ASYNC_GC_GLOBAL: {
+            GlobalHeader header;
+            memset(&header, 0, sizeof(header));
+            header.magic = PREFS_MAGIC;
+            header.version = PREFS_VERSION;
+            header.totalBlocks = _totalBlocks;
+            header.activeBlockIndex = _asyncGcTarget;
+            header.checksum = _calculateCrc8((byte*)&header, offsetof(GlobalHeader, checksum));
+            _asyncFlush(0, (const byte*)&header, sizeof(header), ASYNC_GC_ACTIVATE);
+            break;
+        }
+
+        case ASYNC_GC_ACTIVATE:
+            _activeBlockIndex = _asyncGcTarget;
+            _liveBytes = _asyncGcOffset - BLOCK_HEADER_SIZE;
+            _deadBytes = 0;
+            _liveEntries = _asyncGcEntries;
+            _compactEpoch++;
+            _asyncBlock = 0;
+            _asyncFlushBlockHeader(_asyncGcTarget, BLOCK_STATUS_ACTIVE, _asyncGcOffset,
+                                   ASYNC_GC_RELEASE);
+            break;
+
+        case ASYNC_GC_RELEASE: {
+            if (_asyncBlock >= _totalBlocks) {
+                _asyncPhase = ASYNC_GC_DONE;
+                break;
+            }
+            uint16_t blockIdx = _asyncBlock++;
+            BlockHeader header;
+            if (blockIdx != _asyncGcTarget && _readBlockHeader(blockIdx, header) &&
+                (header.status == BLOCK_STATUS_ACTIVE || header.status == BLOCK_STATUS_VALID)) {
+                _asyncFlushBlockHeader(blockIdx, BLOCK_STATUS_EMPTY, BLOCK_HEADER_SIZE,
+                                       ASYNC_GC_RELEASE);
+            }
+            return;
+        }
+
+        case ASYNC_GC_DONE:
+            delete[] _coldMoved;
+            _coldMoved = nullptr;
+            _coldMovedCount = 0;
+            _asyncOldAddr = _asyncGcOldAddr;
+            _asyncGcActive = false;
+            _gcRunning = false;
+            _asyncPhase = ASYNC_SPACE;
+            break;
+
+        default:
+            _asyncComplete(false);
+            return;
+        }
+    }
 }
 
 // Explicit Template Instantiation --------------------------------------------
 template bool I2CMiniPrefs::_putValue<bool>(const char*, PrefDataType, bool);
 template bool I2CMiniPrefs::_getValue<bool>(const char*, bool, PrefDataType);
-// ... (all other supported types)
\ No newline at end of file
+template bool I2CMiniPrefs::_putValue<char>(const char*, PrefDataType, char);
+template char I2CMiniPrefs::_getValue<char>(const char*, char, PrefDataType);
+template bool I2CMiniPrefs::_putValue<unsigned char>(const char*, PrefDataType, unsigned char);
+template unsigned char I2CMiniPrefs::_getValue<unsigned char>(const char*, unsigned char, PrefDataType);
+template bool I2CMiniPrefs::_putValue<short>(const char*, PrefDataType, short);
+template short I2CMiniPrefs::_getValue<short>(const char*, short, PrefDataType);
+template bool I2CMiniPrefs::_putValue<unsigned short>(const char*, PrefDataType, unsigned short);
+template unsigned short I2CMiniPrefs::_getValue<unsigned short>(const char*, unsigned short, PrefDataType);
+template bool I2CMiniPrefs::_putValue<int>(const char*, PrefDataType, int);
+template int I2CMiniPrefs::_getValue<int>(const char*, int, PrefDataType);
+template bool I2CMiniPrefs::_putValue<unsigned int>(const char*, PrefDataType, unsigned int);
+template unsigned int I2CMiniPrefs::_getValue<unsigned int>(const char*, unsigned int, PrefDataType);
+template bool I2CMiniPrefs::_putValue<long>(const char*, PrefDataType, long);
+template long I2CMiniPrefs::_getValue<long>(const char*, long, PrefDataType);
+template bool I2CMiniPrefs::_putValue<unsigned long>(const char*, PrefDataType, unsigned long);
+template unsigned long I2CMiniPrefs::_getValue<unsigned long>(const char*, unsigned long, PrefDataType);
+template bool I2CMiniPrefs::_putValue<long long>(const char*, PrefDataType, long long);
+template long long I2CMiniPrefs::_getValue<long long>(const char*, long long, PrefDataType);
+template bool I2CMiniPrefs::_putValue<unsigned long long>(const char*, PrefDataType, unsigned long long);
+template unsigned long long I2CMiniPrefs::_getValue<unsigned long long>(const char*, unsigned long long, PrefDataType);
+template bool I2CMiniPrefs::_putValue<float>(const char*, PrefDataType, float);
+template float I2CMiniPrefs::_getValue<float>(const char*, float, PrefDataType);
+template bool I2CMiniPrefs::_putValue<double>(const char*, PrefDataType, double);
+template double I2CMiniPrefs::_getValue<double>(const char*, double, PrefDataType);
\ No newline at end of file
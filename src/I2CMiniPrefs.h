@@ -11,6 +11,27 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+/**
+ * @def PREFS_THREAD_SAFE
+ * @brief Enable built-in FreeRTOS locking (default on ESP32)
+ *
+ * Define as 0 to drop the semaphores when the store is only used from
+ * one task. On other targets the lock calls compile to no-ops but lock
+ * statistics are still collected.
+ */
+#ifndef PREFS_THREAD_SAFE
+#if defined(ESP32)
+#define PREFS_THREAD_SAFE 1
+#else
+#define PREFS_THREAD_SAFE 0
+#endif
+#endif
+
+#if PREFS_THREAD_SAFE
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#endif
+
 /**
  * @def PREFS_MAGIC
  * @brief Magic number identifying valid storage header
@@ -20,14 +41,20 @@
 /**
  * @def PREFS_VERSION
  * @brief Version of the storage format
+ *
+ * Version 2 added EntryHeader::age. begin() migrates a version 1 store.
  */
-#define PREFS_VERSION       0x01
+#define PREFS_VERSION       0x02
 
 /// Block status definitions
 #define BLOCK_STATUS_EMPTY      0x00 ///< Block is empty and available
 #define BLOCK_STATUS_ACTIVE     0x01 ///< Currently active write block
 #define BLOCK_STATUS_VALID      0x02 ///< Block contains valid data
 #define BLOCK_STATUS_INVALID    0x03 ///< Block contains invalid data
+#define BLOCK_STATUS_SNAPSHOT   0x04 ///< Frozen copy pinned by snapshot()
+#define BLOCK_STATUS_STAGED     0x05 ///< Import awaiting its commit, free otherwise
+#define BLOCK_STATUS_UPGRADE    0x06 ///< Migrated store awaiting its commit, free otherwise
+#define BLOCK_STATUS_COMPACT    0x07 ///< Asynchronous GC target awaiting its commit, free otherwise
 
 /**
  * @enum PrefDataType
@@ -94,10 +121,299 @@ struct EntryHeader {
     uint8_t  dataType;       ///< PrefDataType value
     uint16_t keyHash;        ///< DJB2 hash of key
     uint8_t  keyLength;      ///< Key string length
+    uint8_t  age;            ///< Garbage collections survived unchanged (saturates at 255)
     uint16_t valueLength;    ///< Value data length in bytes
 };
 #define ENTRY_HEADER_SIZE sizeof(EntryHeader)
 
+/**
+ * @enum PrefsTraceOp
+ * @brief Operation codes recorded by the trace recorder
+ */
+enum PrefsTraceOp : uint8_t {
+    PREFS_TRACE_PUT = 1,     ///< put*() call
+    PREFS_TRACE_GET,         ///< get*() call
+    PREFS_TRACE_REMOVE,      ///< remove() call
+    PREFS_TRACE_IS_KEY,      ///< isKey() call
+    PREFS_TRACE_CLEAR,       ///< clear() call
+    PREFS_TRACE_GC           ///< Garbage collection triggered by a put
+};
+
+/**
+ * @struct PrefsTraceRecord
+ * @brief One traced operation (16 bytes, little-endian on the wire)
+ */
+struct PrefsTraceRecord {
+    uint32_t timestampUs;    ///< micros() at operation start
+    uint32_t latencyUs;      ///< Operation duration in microseconds
+    uint16_t keyHash;        ///< DJB2 hash of key (0 for clear/GC)
+    uint16_t valueSize;      ///< Value length written or found
+    uint16_t busBytes;       ///< I2C bytes transferred, saturating
+    uint8_t  op;             ///< PrefsTraceOp value
+    uint8_t  result;         ///< 1=success/found, 0=failure/not found
+};
+
+/**
+ * @def PREFS_TRACE_MAGIC
+ * @brief Magic bytes starting a trace dump ("I2CT")
+ */
+#define PREFS_TRACE_MAGIC   "I2CT"
+#define PREFS_TRACE_VERSION 0x01
+
+/**
+ * @enum PrefsBusAccess
+ * @brief Kind of transfer announced to a user-supplied bus lock
+ */
+enum PrefsBusAccess : uint8_t {
+    PREFS_BUS_READ,          ///< Read for a lookup or get
+    PREFS_BUS_WRITE,         ///< Write for a put, remove or commit
+    PREFS_BUS_BACKGROUND     ///< Transfer issued by garbage collection
+};
+
+/// User bus lock, called before every I2C transfer of the engine
+typedef void (*PrefsBusLockFn)(void* ctx, PrefsBusAccess access);
+/// User bus unlock, called after every I2C transfer of the engine
+typedef void (*PrefsBusUnlockFn)(void* ctx);
+
+/**
+ * @struct PrefsLockTiming
+ * @brief Acquisition and hold-time counters for one lock
+ */
+struct PrefsLockTiming {
+    uint32_t acquisitions;   ///< Number of times the lock was taken
+    uint32_t totalHoldUs;    ///< Sum of hold times in microseconds
+    uint32_t maxHoldUs;      ///< Longest single hold in microseconds
+    uint32_t maxWaitUs;      ///< Longest wait for the lock in microseconds
+};
+
+/**
+ * @struct PrefsLockStats
+ * @brief Lock instrumentation returned by I2CMiniPrefs::getLockStats()
+ */
+struct PrefsLockStats {
+    PrefsLockTiming read;    ///< Shared lock taken by get*(), isKey(), exportTo()
+    PrefsLockTiming write;   ///< Exclusive lock taken by put*(), remove(), clear(), ...
+    PrefsLockTiming bus;     ///< Bus lock taken per I2C transfer
+};
+
+/**
+ * @enum PrefsError
+ * @brief Kind of I2C failure, see I2CMiniPrefs::lastError()
+ */
+enum PrefsError : uint8_t {
+    PREFS_ERR_NONE = 0,      ///< No failure recorded
+    PREFS_ERR_ADDRESS_NACK,  ///< Chip did not acknowledge its address
+    PREFS_ERR_DATA_NACK,     ///< Chip rejected a data byte
+    PREFS_ERR_BUS,           ///< Other Wire error (arbitration, timeout, ...)
+    PREFS_ERR_VERIFY,        ///< Read-back differed from the written bytes
+    PREFS_ERR_READ           ///< Chip returned fewer bytes than requested
+};
+
+/**
+ * @struct PrefsErrorStats
+ * @brief I2C failure counters returned by I2CMiniPrefs::getErrorStats()
+ */
+struct PrefsErrorStats {
+    uint32_t addressNacks;   ///< PREFS_ERR_ADDRESS_NACK occurrences
+    uint32_t dataNacks;      ///< PREFS_ERR_DATA_NACK occurrences
+    uint32_t busErrors;      ///< PREFS_ERR_BUS occurrences
+    uint32_t verifyErrors;   ///< PREFS_ERR_VERIFY occurrences
+    uint32_t readErrors;     ///< PREFS_ERR_READ occurrences
+    uint32_t retries;        ///< Write bursts sent again after a failure
+    uint32_t failedWrites;   ///< Write bursts given up after all retries
+    uint32_t busRecoveries;  ///< Nine-clock bus recoveries performed
+};
+
+/**
+ * @def PREFS_COLD_GENERATIONS
+ * @brief Default number of garbage collections an entry survives unchanged
+ *        before it moves to an attached cold tier
+ */
+#ifndef PREFS_COLD_GENERATIONS
+#define PREFS_COLD_GENERATIONS 4
+#endif
+
+/**
+ * @def PREFS_TTL_FLAG
+ * @brief Type byte flag of entries stored with putWithTTL()
+ *
+ * Their value starts with a uint32_t expiry time on the clock set with
+ * setClock(), followed by the value itself.
+ */
+#define PREFS_TTL_FLAG  0x80
+#define PREFS_TTL_STAMP_SIZE sizeof(uint32_t)
+
+/// User clock for entry expiry, in seconds (RTC epoch or uptime)
+typedef uint32_t (*PrefsClockFn)();
+
+/// Handle of an on-chip snapshot, see I2CMiniPrefs::snapshot() (0 = none)
+typedef uint16_t PrefsSnapshot;
+
+/// Entry version for compareAndPut(), see I2CMiniPrefs::getVersion() (0 = missing key)
+typedef uint64_t PrefsVersion;
+
+class PrefsColdTier;
+
+/**
+ * @def PREFS_WIRE_TIMEOUT_MS
+ * @brief Default upper bound for a single Wire transfer
+ */
+#ifndef PREFS_WIRE_TIMEOUT_MS
+#define PREFS_WIRE_TIMEOUT_MS 10
+#endif
+
+/**
+ * @def PREFS_WRITE_RETRIES
+ * @brief Extra attempts for a write burst that was NACKed or misverified
+ */
+#ifndef PREFS_WRITE_RETRIES
+#define PREFS_WRITE_RETRIES 3
+#endif
+
+/**
+ * @def PREFS_ASYNC_QUEUE_SIZE
+ * @brief Number of asynchronous requests that can be queued or tracked
+ */
+#ifndef PREFS_ASYNC_QUEUE_SIZE
+#define PREFS_ASYNC_QUEUE_SIZE 4
+#endif
+
+/**
+ * @def PREFS_ASYNC_KEY_SIZE
+ * @brief Longest key accepted by putAsync()/removeAsync() (copied into the request)
+ */
+#ifndef PREFS_ASYNC_KEY_SIZE
+#define PREFS_ASYNC_KEY_SIZE 16
+#endif
+
+#define PREFS_ASYNC_INLINE_SIZE 8   ///< Values up to this size are copied into the request
+#define PREFS_ASYNC_SLICE       8   ///< Bytes moved per read step of the state machine
+#define PREFS_EEPROM_WRITE_CYCLE_US 5000 ///< EEPROM internal write cycle
+
+/**
+ * @enum PrefsAsyncStatus
+ * @brief State of an asynchronous request
+ */
+enum PrefsAsyncStatus : uint8_t {
+    PREFS_ASYNC_UNKNOWN = 0, ///< Invalid handle or slot already reused
+    PREFS_ASYNC_PENDING,     ///< Queued or in progress
+    PREFS_ASYNC_DONE,        ///< Completed successfully
+    PREFS_ASYNC_FAILED       ///< Completed with error (or key not found for remove)
+};
+
+/**
+ * @enum PrefsAsyncKind
+ * @brief Operation carried by an asynchronous request
+ */
+enum PrefsAsyncKind : uint8_t {
+    PREFS_ASYNC_PUT,         ///< putAsync()
+    PREFS_ASYNC_REMOVE,      ///< removeAsync()
+    PREFS_ASYNC_GET          ///< getAsync()
+};
+
+/// Request handle returned by putAsync()/removeAsync()/getAsync(); 0 means rejected
+typedef uint16_t PrefsAsyncHandle;
+
+/// Completion callback, invoked from poll() outside the store lock
+typedef void (*PrefsAsyncCallback)(PrefsAsyncHandle handle, bool success, void* ctx);
+
+/**
+ * @struct PrefsAsyncRequest
+ * @brief One queued asynchronous operation
+ */
+struct PrefsAsyncRequest {
+    PrefsAsyncHandle handle; ///< Handle given to the caller
+    uint8_t status;          ///< PrefsAsyncStatus value
+    uint8_t kind;            ///< PrefsAsyncKind value
+    bool notify;             ///< Callback still to be invoked
+    uint8_t dataType;        ///< PrefDataType value
+    char key[PREFS_ASYNC_KEY_SIZE + 1]; ///< Copied key
+    uint16_t valueLength;    ///< Value length in bytes
+    const void* value;       ///< Put source (inlineValue or caller buffer)
+    void* dest;              ///< Get destination (caller buffer)
+    byte inlineValue[PREFS_ASYNC_INLINE_SIZE]; ///< Copy of small values
+    PrefsAsyncCallback callback; ///< Completion callback (may be nullptr)
+    void* ctx;               ///< Callback context
+    uint32_t startUs;        ///< micros() at enqueue, for tracing
+};
+
+class I2CMiniPrefs;
+
+/**
+ * @struct PrefsAsyncRef
+ * @brief Handle of a queued request together with its store
+ *
+ * Returned by the typed putAsync(); converts to PrefsAsyncHandle and is
+ * awaitable with I2CMiniPrefsAwait.h (C++20).
+ */
+struct PrefsAsyncRef {
+    I2CMiniPrefs* prefs;     ///< Store the request was queued on
+    PrefsAsyncHandle handle; ///< Request handle, 0 if rejected
+    operator PrefsAsyncHandle() const { return handle; }
+};
+
+/**
+ * @struct PrefsGetRequest
+ * @brief Deferred typed read, started when awaited (see I2CMiniPrefsAwait.h)
+ */
+template<typename T>
+struct PrefsGetRequest {
+    I2CMiniPrefs* prefs;     ///< Store to read from
+    const char* key;         ///< Key, must stay valid until the read completes
+    T defaultValue;          ///< Result if the key is missing or has another type
+};
+
+/**
+ * @struct PrefTypeTraits
+ * @brief Maps a C++ type to its stored PrefDataType
+ */
+template<typename T> struct PrefTypeTraits;
+template<> struct PrefTypeTraits<bool>               { static const PrefDataType type = TYPE_BOOL; };
+template<> struct PrefTypeTraits<char>               { static const PrefDataType type = TYPE_CHAR; };
+template<> struct PrefTypeTraits<unsigned char>      { static const PrefDataType type = TYPE_UCHAR; };
+template<> struct PrefTypeTraits<short>              { static const PrefDataType type = TYPE_SHORT; };
+template<> struct PrefTypeTraits<unsigned short>     { static const PrefDataType type = TYPE_USHORT; };
+template<> struct PrefTypeTraits<int>                { static const PrefDataType type = TYPE_INT; };
+template<> struct PrefTypeTraits<unsigned int>       { static const PrefDataType type = TYPE_UINT; };
+template<> struct PrefTypeTraits<long>               { static const PrefDataType type = TYPE_LONG; };
+template<> struct PrefTypeTraits<unsigned long>      { static const PrefDataType type = TYPE_ULONG; };
+template<> struct PrefTypeTraits<long long>          { static const PrefDataType type = TYPE_LONG64; };
+template<> struct PrefTypeTraits<unsigned long long> { static const PrefDataType type = TYPE_ULONG64; };
+template<> struct PrefTypeTraits<float>              { static const PrefDataType type = TYPE_FLOAT; };
+template<> struct PrefTypeTraits<double>             { static const PrefDataType type = TYPE_DOUBLE; };
+
+/**
+ * @def PREFS_EXPORT_MAGIC
+ * @brief Magic bytes starting an export snapshot ("I2CX")
+ */
+#define PREFS_EXPORT_MAGIC   "I2CX"
+#define PREFS_EXPORT_VERSION 0x01
+
+/**
+ * @def PREFS_I2C_BUFFER_SIZE
+ * @brief Largest read burst handed to the Wire library
+ */
+#ifndef PREFS_I2C_BUFFER_SIZE
+#if defined(I2C_BUFFER_LENGTH)
+#define PREFS_I2C_BUFFER_SIZE I2C_BUFFER_LENGTH
+#elif defined(BUFFER_LENGTH)
+#define PREFS_I2C_BUFFER_SIZE BUFFER_LENGTH
+#else
+#define PREFS_I2C_BUFFER_SIZE 32
+#endif
+#endif
+
+/**
+ * @def PREFS_EEPROM_PAGE_SIZE
+ * @brief Default EEPROM page size; write bursts never cross a page
+ *
+ * 32 bytes is safe for all two-byte-address EEPROMs (24C32 and up).
+ * Larger parts can raise it with setPageSize().
+ */
+#ifndef PREFS_EEPROM_PAGE_SIZE
+#define PREFS_EEPROM_PAGE_SIZE 32
+#endif
+
 /**
  * @class I2CMiniPrefs
  * @brief Key-value storage with wear-leveling for I2C memories
@@ -107,6 +423,7 @@ struct EntryHeader {
  * - Garbage collection
  * - CRC data validation
  * - Configurable memory layout
+ * - Reader/writer locking for use from several FreeRTOS tasks
  */
 class I2CMiniPrefs {
 public:
@@ -126,6 +443,7 @@ public:
                  uint16_t blockSize = 256,
                  uint8_t maxKeyLen = 16, uint16_t maxValueLen = 240,
                  int8_t sdaPin = -1, int8_t sclPin = -1);
+    ~I2CMiniPrefs();
 
     /// @name Core Management
     ///@{
@@ -137,9 +455,93 @@ public:
     
     /**
      * @brief Release I2C resources
-     * @note Optional, only needed if I2C bus needs to be reconfigured
+     * @note Waits for the last EEPROM write cycle; call it before the bus
+     *       is reconfigured or power is removed
      */
     void end();
+
+    /**
+     * @brief Whether begin() succeeded and the store is usable
+     */
+    bool isOpen() const { return _isInitialized; }
+
+    /**
+     * @brief Set the EEPROM page size used to split write bursts
+     * @param bytes Page size of the chip (power of two; ignored for FRAM)
+     * @note Too large a value corrupts data: the chip wraps inside its page
+     */
+    void setPageSize(uint16_t bytes) { if (bytes) _pageSize = bytes; }
+
+    /**
+     * @brief Compare each EEPROM page burst with the chip before programming
+     * @param enable true to skip bursts whose bytes are already stored
+     *
+     * Costs one read per burst and saves a write cycle (and wear) whenever
+     * garbage collection or a put rewrites identical data.
+     */
+    void setVerifyBeforeWrite(bool enable) { _verifyWrites = enable; }
+
+    /**
+     * @brief Page bursts skipped by setVerifyBeforeWrite() since construction
+     */
+    uint32_t skippedWrites() const { return _skippedWrites; }
+
+    /**
+     * @brief Read every written burst back and compare it
+     * @param enable true to treat a mismatch like a NACK (retry, then fail)
+     *
+     * Costs one read per burst after its write cycle. Without it only
+     * NACKs reported by Wire are detected.
+     */
+    void setVerifyAfterWrite(bool enable) { _verifyAfterWrite = enable; }
+
+    /**
+     * @brief Set the Wire timeout applied by begin()
+     * @param ms Upper bound for a single transfer (AVR cores with
+     *           WIRE_HAS_TIMEOUT and ESP32; ignored elsewhere)
+     */
+    void setBusTimeout(uint16_t ms) { _busTimeoutMs = ms; }
+
+    /**
+     * @brief Use another I2C controller than Wire
+     * @param wire Bus the chip is attached to, e.g. Wire1 (call before begin())
+     *
+     * Pass the controller's SDA/SCL pins to the constructor as well;
+     * without them no bus recovery is attempted on it.
+     */
+    void setWire(TwoWire& wire) { _wire = &wire; }
+
+    /**
+     * @brief Move entries that stopped changing off the chip
+     * @param tier Cold tier, begun already (nullptr to detach)
+     * @param generations Garbage collections an entry must survive unchanged
+     *
+     * Blocking garbage collection hands such entries to the tier instead
+     * of copying them again; reads fall back to the tier. The tier needs
+     * its own begin() before this instance's.
+     */
+    void setColdTier(PrefsColdTier* tier, uint8_t generations = PREFS_COLD_GENERATIONS) {
+        _coldTier = tier;
+        _coldGenerations = generations;
+    }
+
+    /**
+     * @brief Set the clock that putWithTTL() entries expire against
+     * @param clock Seconds since any fixed origin; nullptr disables expiry
+     * @note Without a clock putWithTTL() fails and stored TTL entries
+     *       never expire
+     */
+    void setClock(PrefsClockFn clock) { _clock = clock; }
+
+    /**
+     * @brief Longest key accepted by put*()
+     */
+    uint8_t maxKeyLength() const { return _maxKeyLength; }
+
+    /**
+     * @brief Longest value accepted by put*()
+     */
+    uint16_t maxValueLength() const { return _maxValueLength; }
     ///@}
     
     /// @name Data Write Operations
@@ -160,6 +562,39 @@ public:
     bool putString(const char* key, const char* value);
     bool putString(const char* key, const String& value);
     bool putBytes(const char* key, const void* buf, size_t len);
+
+    /**
+     * @brief Store raw value bytes under an explicit type tag
+     * @param key Null-terminated key string
+     * @param type Type tag stored with the entry
+     * @param buf Value bytes in target representation
+     * @param len Value length
+     * @return true on success, false on error
+     * @note For tools that build or migrate stores for another
+     *       architecture, where sizeof(int) etc. differ from the host
+     */
+    bool putTyped(const char* key, PrefDataType type, const void* buf, size_t len);
+
+    /**
+     * @brief Store a value that disappears after a time
+     * @param key Null-terminated key string
+     * @param type Type tag stored with the entry
+     * @param buf Value bytes
+     * @param len Value length (at most maxValueLen - 4)
+     * @param seconds Lifetime on the setClock() clock
+     * @return true on success, false on error or without a clock
+     *
+     * Reads treat an expired entry as missing; garbage collection drops
+     * it instead of copying it, so no remove() is needed.
+     */
+    bool putWithTTL(const char* key, PrefDataType type, const void* buf, size_t len,
+                    uint32_t seconds);
+    bool putWithTTL(const char* key, const char* value, uint32_t seconds);
+
+    template<typename T>
+    bool putWithTTL(const char* key, const T& value, uint32_t seconds) {
+        return putWithTTL(key, PrefTypeTraits<T>::type, &value, sizeof(T), seconds);
+    }
     ///@}
     
     /// @name Data Read Operations
@@ -179,6 +614,78 @@ public:
     double getDouble(const char* key, double defaultValue = 0.0);
     String getString(const char* key, const char* defaultValue = "");
     size_t getBytes(const char* key, void* buf, size_t maxLen);
+
+    /**
+     * @brief Read raw value bytes stored under a given type tag
+     * @param key Null-terminated key string
+     * @param type Expected type tag
+     * @param buf Destination buffer
+     * @param maxLen Buffer size
+     * @return Bytes read, 0 if the key is missing or has another type
+     * @see putTyped()
+     */
+    size_t getTyped(const char* key, PrefDataType type, void* buf, size_t maxLen);
+
+    /**
+     * @brief Read raw value bytes together with their version
+     * @param[out] version Token for compareAndPut(), 0 if the key is missing
+     * @see getTyped(), compareAndPut()
+     */
+    size_t getTyped(const char* key, PrefDataType type, void* buf, size_t maxLen,
+                    PrefsVersion& version);
+
+    /**
+     * @brief Read a value together with its version
+     * @param key Null-terminated key string
+     * @param defaultValue Result if the key is missing or of another type
+     * @param[out] version Token for compareAndPut(), 0 if the key is missing
+     */
+    template<typename T>
+    T getVersioned(const char* key, T defaultValue, PrefsVersion& version) {
+        T value;
+        return getTyped(key, PrefTypeTraits<T>::type, &value, sizeof(T), version) == sizeof(T)
+            ? value : defaultValue;
+    }
+    ///@}
+
+    /// @name Versioned Writes
+    /// Optimistic concurrency for read-modify-write from several tasks:
+    /// @code
+    /// PrefsVersion version;
+    /// do {
+    ///     int n = prefs.getVersioned("count", 0, version);
+    ///     ... // compute
+    /// } while (!prefs.compareAndPut("count", version, n + 1));
+    /// @endcode
+    /// Versions change with every put of the key and with every garbage
+    /// collection (a compareAndPut() across one fails and is retried).
+    /// They live in RAM only and are not valid across reboots. A version
+    /// repeats only after 2^32 garbage collections.
+    ///@{
+    /**
+     * @brief Current version of key without reading its value
+     * @return Version token, 0 if the key is missing
+     */
+    PrefsVersion getVersion(const char* key);
+
+    /**
+     * @brief Store a value only if key still has the expected version
+     * @param key Null-terminated key string
+     * @param expectedVersion Version read before; 0 stores only if the key is missing
+     * @param type Type tag stored with the entry
+     * @param buf Value bytes
+     * @param len Value length
+     * @return true if the version matched and the value was stored
+     * @note Check and write run under the write lock with a single lookup
+     */
+    bool compareAndPut(const char* key, PrefsVersion expectedVersion, PrefDataType type,
+                       const void* buf, size_t len);
+    bool compareAndPut(const char* key, PrefsVersion expectedVersion, const char* value);
+
+    template<typename T>
+    bool compareAndPut(const char* key, PrefsVersion expectedVersion, const T& value) {
+        return compareAndPut(key, expectedVersion, PrefTypeTraits<T>::type, &value, sizeof(T));
+    }
     ///@}
     
     /// @name Utility Operations
@@ -189,20 +696,353 @@ public:
      * @return true if key exists, false otherwise
      */
     bool isKey(const char* key);
+
+    /**
+     * @brief Stored value length, read from the entry header only
+     * @param key Null-terminated key string
+     * @return Value bytes (strings include the terminator), 0 if missing
+     */
+    size_t getValueLength(const char* key);
+
+    /**
+     * @brief Stored type tag, read from the entry header only
+     * @param key Null-terminated key string
+     * @return Type of the value, TYPE_NONE if missing
+     */
+    PrefDataType getType(const char* key);
     
     /**
      * @brief Mark key-value pair as deleted
      * @param key Null-terminated key string
-     * @return true if key was found and marked, false otherwise
+     * @return true if key was found and marked, false otherwise (also for
+     *         an expired TTL entry)
      */
     bool remove(const char* key);
     
     /**
      * @brief Clear all stored preferences
      * @return true if successful, false on error
-     * @note Performs full garbage collection and reformats storage
+     * @note Formats a fresh active block and releases all others; the
+     *       store stays open
      */
     bool clear();
+
+    /**
+     * @brief Delete every key that starts with prefix
+     * @param prefix Null-terminated key prefix, e.g. "wifi/"
+     * @return true if no write failed (also when nothing matched)
+     */
+    bool removePrefix(const char* prefix);
+
+    ///@}
+
+    /// @name Usage Statistics
+    /// Kept as counters by every put, delete and garbage collection and
+    /// seeded by begin(), so none of these touches the bus.
+    ///@{
+    /**
+     * @brief Bytes still available for entries (headers included)
+     * @note Counts deleted and superseded entries as free, since the next
+     *       garbage collection reclaims them
+     */
+    size_t freeBytes() const {
+        uint32_t used = BLOCK_HEADER_SIZE + _liveBytes;
+        return _isInitialized && used < _blockSizeBytes ? _blockSizeBytes - used : 0;
+    }
+
+    /**
+     * @brief Bytes occupied by live and dead entries (headers included)
+     */
+    size_t usedBytes() const { return _liveBytes + _deadBytes; }
+
+    /**
+     * @brief Number of live entries on the chip
+     */
+    uint16_t liveEntries() const { return _liveEntries; }
+
+    /**
+     * @brief Bytes of deleted and superseded entries awaiting garbage collection
+     */
+    size_t deadBytes() const { return _deadBytes; }
+
+    /**
+     * @brief Share of dead bytes in usedBytes()
+     * @return 0 .. 100 percent
+     */
+    uint8_t fragmentation() const {
+        uint32_t used = _liveBytes + _deadBytes;
+        return used ? (uint8_t)((uint64_t)_deadBytes * 100 / used) : 0;
+    }
+    ///@}
+
+    /// @name Operation Tracing
+    ///@{
+    /**
+     * @brief Start recording public operations into a RAM ring
+     * @param buffer Caller-owned record storage
+     * @param capacity Number of records in buffer
+     * @note Oldest records are overwritten when the ring is full
+     */
+    void enableTrace(PrefsTraceRecord* buffer, uint16_t capacity);
+
+    /**
+     * @brief Stop recording; the buffer is no longer referenced
+     */
+    void disableTrace();
+
+    /**
+     * @brief Number of records currently held in the ring
+     */
+    uint16_t traceCount() const { return _traceCount; }
+
+    /**
+     * @brief Write the ring as a binary trace dump
+     * @param out Destination stream (Serial, file, ...)
+     * @param clear Empty the ring after dumping
+     * @return Number of bytes written
+     *
+     * Dump layout: "I2CT", version, record size, uint16 record count,
+     * uint32 overwritten-record count, then records oldest first.
+     * If the ring was full, operations traced while the dump is streamed
+     * can overwrite records that have not been streamed yet.
+     */
+    size_t dumpTrace(Stream& out, bool clear = true);
+    ///@}
+
+    /// @name Backup and Restore
+    ///@{
+    /**
+     * @brief Write all live entries as a binary snapshot
+     * @param out Destination stream (Serial, file, network client, ...)
+     * @return Number of bytes written, 0 on error
+     *
+     * Snapshot layout: "I2CX", version, then per entry: type, key length,
+     * uint16 value length, key, value. Terminated by a 0x00 type byte,
+     * uint16 entry count and a CRC8 over all entry and count bytes.
+     */
+    size_t exportTo(Stream& out);
+
+    /**
+     * @brief Replace the store contents with a snapshot
+     * @param in Source stream positioned at the snapshot magic
+     * @return true if the snapshot was valid and committed
+     * @note Entries are staged in an empty block and only committed after
+     *       the trailing CRC matched; on error the store is left unchanged.
+     *       The commit is one global header write, which begin() completes
+     *       after a power cut. The snapshot must fit in one block.
+     */
+    bool importFrom(Stream& in);
+    ///@}
+
+    /// @name Snapshots
+    /// On-chip copies of the store for rolling back a failed migration.
+    ///@{
+    /**
+     * @brief Freeze the current live entries in a pinned block
+     * @return Snapshot handle, 0 if no empty block is left or a cold tier
+     *         is attached
+     * @note Copies the live entries once, like a garbage collection. The
+     *       pinned block survives restarts and is left alone by lookups
+     *       and garbage collection until rollback() or release(), so each
+     *       snapshot takes one block away from the store.
+     */
+    PrefsSnapshot snapshot();
+
+    /**
+     * @brief Replace the store contents with a snapshot
+     * @param snap Handle from snapshot() or snapshots()
+     * @return true if the snapshot is the store contents now
+     * @note Rewrites headers only. The snapshot block becomes the active
+     *       block, so the snapshot is used up. The global header is the
+     *       commit point: begin() completes a rollback cut short after it.
+     */
+    bool rollback(PrefsSnapshot snap);
+
+    /**
+     * @brief Discard a snapshot and return its block to the store
+     * @param snap Handle from snapshot() or snapshots()
+     * @return true if the block was released
+     */
+    bool release(PrefsSnapshot snap);
+
+    /**
+     * @brief Find the snapshots held on the chip, e.g. after a restart
+     * @param out Receives up to max handles in block order
+     * @param max Size of out
+     * @return Number of snapshots on the chip (may exceed max)
+     */
+    uint16_t snapshots(PrefsSnapshot* out, uint16_t max);
+    ///@}
+
+    /// @name Non-blocking Operations
+    ///@{
+    /**
+     * @brief Queue a write that is carried out by poll()
+     * @param key Null-terminated key (copied, at most PREFS_ASYNC_KEY_SIZE chars)
+     * @param type Type tag stored with the entry
+     * @param buf Value bytes
+     * @param len Value length
+     * @param callback Completion callback (optional)
+     * @param ctx Passed to the callback
+     * @return Request handle, 0 if the queue is full or arguments are invalid
+     * @note Values up to PREFS_ASYNC_INLINE_SIZE bytes are copied. Larger
+     *       buffers are referenced and must stay valid until completion.
+     */
+    PrefsAsyncHandle putAsync(const char* key, PrefDataType type, const void* buf, size_t len,
+                              PrefsAsyncCallback callback = nullptr, void* ctx = nullptr);
+
+    /**
+     * @brief Queue a removal that is carried out by poll()
+     * @param key Null-terminated key (copied)
+     * @param callback Completion callback (optional); success is false if the key did not exist
+     * @param ctx Passed to the callback
+     * @return Request reference (handle 0 if the queue is full or the key is invalid)
+     */
+    PrefsAsyncRef removeAsync(const char* key, PrefsAsyncCallback callback = nullptr,
+                                 void* ctx = nullptr);
+
+    /**
+     * @brief Queue a read that is carried out by poll()
+     * @param key Null-terminated key (copied)
+     * @param type Expected data type
+     * @param buf Destination, must stay valid until completion
+     * @param len Expected value length; the stored length must match
+     * @param callback Completion callback (optional); success is false if
+     *        the key is missing or type/length differ
+     * @param ctx Passed to the callback
+     * @return Request handle, 0 if the queue is full or arguments are invalid
+     * @note Requests run in order, so a read queued after a put sees its value
+     */
+    PrefsAsyncHandle getAsync(const char* key, PrefDataType type, void* buf, size_t len,
+                              PrefsAsyncCallback callback = nullptr, void* ctx = nullptr);
+
+    /**
+     * @brief Queue a typed write
+     * @param key Null-terminated key (copied)
+     * @param value Value (copied)
+     * @param callback Completion callback (optional)
+     * @param ctx Passed to the callback
+     * @return Request reference; co_await it with I2CMiniPrefsAwait.h
+     */
+    template<typename T>
+    PrefsAsyncRef putAsync(const char* key, const T& value,
+                           PrefsAsyncCallback callback = nullptr, void* ctx = nullptr) {
+        static_assert(sizeof(T) <= PREFS_ASYNC_INLINE_SIZE, "value too large to be copied");
+        PrefsAsyncRef ref = {this, putAsync(key, PrefTypeTraits<T>::type, &value, sizeof(T),
+                                            callback, ctx)};
+        return ref;
+    }
+
+    /**
+     * @brief Describe a typed read for co_await (see I2CMiniPrefsAwait.h)
+     * @param key Null-terminated key, must stay valid until the read completes
+     * @param defaultValue Result if the key is missing
+     */
+    template<typename T>
+    PrefsGetRequest<T> getAsync(const char* key, T defaultValue = T()) {
+        PrefsGetRequest<T> req = {this, key, defaultValue};
+        return req;
+    }
+
+    /**
+     * @brief Replace the completion callback of a pending request
+     * @param handle Request handle
+     * @param callback New callback
+     * @param ctx Passed to the callback
+     * @return PREFS_ASYNC_PENDING if installed, otherwise the final state
+     *         (the callback will not be invoked)
+     */
+    PrefsAsyncStatus setAsyncCallback(PrefsAsyncHandle handle, PrefsAsyncCallback callback,
+                                      void* ctx);
+
+    /**
+     * @brief Advance queued requests by one step
+     * @return true while requests are pending
+     *
+     * A step is at most one I2C transfer (a write or read of up to
+     * PREFS_ASYNC_SLICE bytes). While an EEPROM write cycle is in
+     * progress poll() returns immediately; this includes the cycle before
+     * a retried burst or a setVerifyAfterWrite() read-back. Garbage
+     * collection needed by a queued put runs step by step as well.
+     */
+    bool poll();
+
+    /**
+     * @brief Query a request
+     * @param handle Value returned by putAsync()/removeAsync()/getAsync()
+     * @return Request state; PREFS_ASYNC_UNKNOWN once the slot was reused
+     */
+    PrefsAsyncStatus asyncStatus(PrefsAsyncHandle handle) const;
+
+    /**
+     * @brief Number of queued or running requests
+     */
+    uint8_t asyncPending() const { return _asyncCount; }
+
+    /**
+     * @brief Whether poll() would perform a transfer right now
+     * @return true if requests are pending and the chip is not in a write cycle
+     */
+    bool asyncReady() { return _asyncCount > 0 && !_writeCycleBusy(); }
+
+    /**
+     * @brief Whether the EEPROM is still in the write cycle of the last write
+     * @note Always false for FRAM
+     */
+    bool writeCycleActive() { return _writeCycleBusy(); }
+
+    /**
+     * @brief Whether the running request is inside garbage collection
+     */
+    bool asyncBackground() const { return _asyncGcActive; }
+    ///@}
+
+    /// @name Shared Bus
+    ///@{
+    /**
+     * @brief Arbitrate the I2C bus with other drivers
+     * @param lockFn Called before each transfer (nullptr to remove)
+     * @param unlockFn Called after each transfer
+     * @param ctx Passed through to both callbacks
+     * @note The lock is held per transfer (at most PREFS_I2C_BUFFER_SIZE
+     *       data bytes), never across an operation or an EEPROM write
+     *       cycle, so other devices can be served in between.
+     */
+    void setBusLock(PrefsBusLockFn lockFn, PrefsBusUnlockFn unlockFn, void* ctx = nullptr);
+    ///@}
+
+    /// @name Lock Instrumentation
+    ///@{
+    /**
+     * @brief Copy the lock counters
+     * @param[out] stats Acquisitions, hold and wait times per lock
+     * @note Read hold times are per reader; concurrent readers overlap
+     */
+    void getLockStats(PrefsLockStats& stats) const { stats = _lockStats; }
+
+    /**
+     * @brief Zero all lock counters
+     */
+    void resetLockStats();
+    ///@}
+
+    /// @name Error Counters
+    ///@{
+    /**
+     * @brief Copy the I2C failure counters
+     * @param[out] stats Failures per kind, retries and abandoned writes
+     */
+    void getErrorStats(PrefsErrorStats& stats) const { stats = _errorStats; }
+
+    /**
+     * @brief Most recent I2C failure (PREFS_ERR_NONE if none since reset)
+     */
+    PrefsError lastError() const { return _lastError; }
+
+    /**
+     * @brief Zero the failure counters and lastError()
+     */
+    void resetErrorStats();
     ///@}
 
 private:
@@ -216,19 +1056,133 @@ private:
     uint16_t _maxValueLength; ///< Maximum value length
     int8_t _sdaPin;          ///< Custom SDA pin
     int8_t _sclPin;          ///< Custom SCL pin
+    TwoWire* _wire;          ///< I2C bus the chip is attached to
     
     // Runtime state
     uint16_t _totalBlocks;   ///< Calculated total blocks
     uint16_t _activeBlockIndex; ///< Current active block index
 
+    // Trace state
+    PrefsTraceRecord* _traceBuf; ///< Trace ring (nullptr = disabled)
+    uint16_t _traceCapacity; ///< Ring capacity in records
+    uint16_t _traceHead;     ///< Next record slot
+    uint16_t _traceCount;    ///< Valid records in ring
+    uint32_t _traceDropped;  ///< Records overwritten since last dump
+    uint32_t _busBytes;      ///< Running count of I2C bytes transferred
+
+    // Locking state
+#if PREFS_THREAD_SAFE
+    SemaphoreHandle_t _writeSem;    ///< Held by one writer or by the group of readers
+    SemaphoreHandle_t _readerMutex; ///< Guards _readers, read statistics and error counters
+    SemaphoreHandle_t _busMutex;    ///< Held for the duration of one I2C transfer
+    portMUX_TYPE _traceMux;         ///< Guards the trace ring against concurrent readers
+#endif
+    PrefsBusLockFn _busLockFn;     ///< User bus lock (nullptr = none)
+    PrefsBusUnlockFn _busUnlockFn; ///< User bus unlock
+    void* _busLockCtx;       ///< User bus lock context
+    bool _gcRunning;         ///< Garbage collection in progress
+    uint8_t _readers;        ///< Readers currently inside the store
+    PrefsLockStats _lockStats; ///< Lock instrumentation
+
+    // Write cycle state
+    bool _writeCyclePending; ///< EEPROM busy with an internal write cycle
+    uint32_t _writeCycleStartUs; ///< micros() when the last write cycle started
+
+    // Write combining state
+    uint16_t _pageSize;      ///< EEPROM page size
+    byte _burstBuf[PREFS_I2C_BUFFER_SIZE - 2]; ///< Pending write burst
+    uint16_t _burstAddr;     ///< Target address of _burstBuf
+    uint8_t _burstLen;       ///< Valid bytes in _burstBuf (0 = none)
+    bool _verifyWrites;      ///< Compare EEPROM bursts before programming
+    uint32_t _skippedWrites; ///< Bursts skipped because nothing changed
+    bool _verifyAfterWrite;  ///< Read bursts back after programming
+    PrefsErrorStats _errorStats; ///< I2C failure counters
+    PrefsError _lastError;   ///< Most recent I2C failure
+    uint16_t _busTimeoutMs;  ///< Wire timeout applied by _beginWire()
+    PrefsColdTier* _coldTier; ///< Store for unchanging entries (optional)
+    uint8_t _coldGenerations; ///< Entry age that moves it to _coldTier
+    const uint16_t* _coldMoved; ///< Entries being moved by the running GC
+    uint16_t _coldMovedCount; ///< Number of _coldMoved
+    uint32_t _liveBytes;     ///< Bytes of live entries incl. headers
+    uint32_t _deadBytes;     ///< Bytes of deleted entries not yet collected
+    uint16_t _liveEntries;   ///< Number of live entries
+    uint32_t _compactEpoch;  ///< Compactions since begin(), part of entry versions
+    PrefsClockFn _clock;     ///< Time base of TTL entries (optional)
+
+    // Asynchronous state machine
+    PrefsAsyncRequest _asyncQueue[PREFS_ASYNC_QUEUE_SIZE]; ///< Request ring
+    uint8_t _asyncHead;      ///< Oldest pending request
+    uint8_t _asyncCount;     ///< Pending requests
+    PrefsAsyncHandle _asyncNextHandle; ///< Next handle to hand out
+    uint8_t _asyncPhase;     ///< Current step of the running request
+    uint8_t _asyncAfterFlush; ///< Step to continue with after a flush
+    bool _asyncGcDone;       ///< Running put already collected once
+    bool _asyncGcActive;     ///< Running put is inside garbage collection
+    bool _asyncGcCarry;      ///< GC copies the entry the running put replaces
+    uint16_t _asyncBlock;    ///< Block cursor
+    uint16_t _asyncBlockEnd; ///< End offset of the scanned block
+    uint16_t _asyncOffset;   ///< Entry cursor or bytes written
+    uint16_t _asyncAddr;     ///< Found entry or entry being written
+    uint16_t _asyncCopyPos;  ///< Bytes of the current entry copied by GC
+    uint16_t _asyncGcTarget; ///< Block receiving live entries during GC
+    uint16_t _asyncGcOffset; ///< Write offset in the GC target block
+    uint16_t _asyncGcEntries; ///< Entries copied into the GC target block
+    uint16_t _asyncGcOldAddr; ///< Copy of _asyncOldAddr in the GC target (0 = none)
+    uint16_t _asyncOldAddr;  ///< Entry superseded by the running put (0 = none)
+    uint16_t _asyncOldSize;  ///< Size of that entry incl. header
+    uint32_t _asyncStartBus; ///< _busBytes when the running request started
+    EntryHeader _asyncEntry; ///< Entry header under the cursor
+    byte _asyncBuf[PREFS_ASYNC_SLICE]; ///< Bytes to program
+    uint8_t _asyncBufLen;    ///< Valid bytes in _asyncBuf
+    uint8_t _asyncBufPos;    ///< Bytes of _asyncBuf already programmed
+    uint8_t _asyncAttempt;   ///< Failed attempts at the current burst
+    uint16_t _asyncFlushAddr; ///< Target address of _asyncBuf
+
+    /**
+     * @brief Scoped read or write lock for the public entry points
+     */
+    class LockGuard {
+    public:
+        LockGuard(I2CMiniPrefs& prefs, bool exclusive)
+            : _prefs(prefs), _exclusive(exclusive),
+              _acquiredUs(exclusive ? prefs._lockWrite() : prefs._lockRead()) {}
+        ~LockGuard() { _exclusive ? _prefs._unlockWrite(_acquiredUs) : _prefs._unlockRead(_acquiredUs); }
+    private:
+        I2CMiniPrefs& _prefs;
+        bool _exclusive;
+        uint32_t _acquiredUs;
+    };
+
+    // Locking
+    uint32_t _lockRead();
+    void _unlockRead(uint32_t acquiredUs);
+    uint32_t _lockWrite();
+    void _unlockWrite(uint32_t acquiredUs);
+    uint32_t _lockBus(PrefsBusAccess access);
+    void _unlockBus(uint32_t acquiredUs);
+    static void _recordHold(PrefsLockTiming& timing, uint32_t acquiredUs);
+
     // I2C Hardware Abstraction
-    void _i2c_write_byte(uint16_t address, byte data);
+    bool _i2c_write_byte(uint16_t address, byte data);
+    void _waitWriteCycle();
+    bool _writeCycleBusy();
     byte _i2c_read_byte(uint16_t address);
-    void _i2c_write_bytes(uint16_t address, const byte* data, size_t len);
-    void _i2c_read_bytes(uint16_t address, byte* buffer, size_t len);
+    bool _i2c_write_bytes(uint16_t address, const byte* data, size_t len);
+    bool _i2c_queue_bytes(uint16_t address, const byte* data, size_t len);
+    bool _i2c_flush();
+    bool _i2c_unchanged(uint16_t address, const byte* data, uint8_t len);
+    bool _i2c_send_burst(uint16_t address, const byte* data, uint8_t len);
+    bool _i2c_verify_burst(uint16_t address, const byte* data, uint8_t len);
+    bool _i2c_read_bytes(uint16_t address, byte* buffer, size_t len);
+    static PrefsError _errorFromWire(uint8_t result);
+    void _beginWire();
+    bool _devicePresent();
+    bool _recoverBus();
+    void _recordError(PrefsError error);
 
     // Core Algorithms
-    uint8_t _calculateCrc8(const byte* data, size_t len);
+    uint8_t _calculateCrc8(const byte* data, size_t len, uint8_t crc = 0x00);
+    uint8_t _blockHeaderCrc(const BlockHeader& header);
     uint16_t _hashKey(const char* key);
     uint16_t _getBlockAddress(uint16_t blockIndex);
     bool _readGlobalHeader(GlobalHeader& header);
@@ -237,10 +1191,52 @@ private:
     bool _writeBlockHeader(uint16_t blockIndex, const BlockHeader& header);
     uint16_t _findEntry(const char* key, uint16_t& entryValueAddress, 
                         uint16_t& entryValueLength, PrefDataType& entryDataType);
+    uint16_t _findEntryInBlock(uint16_t blockIndex, uint16_t endOffset,
+                               const char* key, EntryHeader& entryHeader);
     bool _writeEntry(const char* key, PrefDataType type, 
                     const void* valueBuf, size_t valueLen);
+    bool _writeEntryData(uint16_t entryStartAddr, const char* key, uint8_t keyLen,
+                         PrefDataType type, const void* valueBuf, size_t valueLen);
     bool _markEntryAsDeleted(uint16_t entryAddress);
+    uint16_t _findEmptyBlock();
+    uint16_t _findBlock(uint8_t status);
+    uint32_t _liveEntryBytes(uint16_t maxMoved = 0, uint16_t* moved = nullptr,
+                             uint16_t* movedCount = nullptr);
+    uint16_t _coldMoveLimit();
+    bool _moveToColdTier(const uint16_t* moved, uint16_t count);
+    static bool _coldKeep(const char* key, void* ctx);
+    static bool _keepUnprefixed(const char* key, void* ctx);
+    bool _isColdMoved(uint16_t entryAddr, const char* key);
+    bool _statEntry(const char* key, PrefDataType& type, uint16_t& valueLen);
+    void _scanUsage();
+    bool _dropSuperseded();
+    bool _replaceEntry(const char* key, PrefDataType type, const void* valueBuf,
+                       size_t valueLen, uint16_t oldEntryHeaderAddr, uint16_t oldValueLen);
+    PrefsVersion _entryVersion(const char* key, uint16_t entryAddr);
+    uint16_t _findLiveEntry(const char* key, uint16_t& valueAddr, uint16_t& valueLen,
+                            PrefDataType& type);
+    bool _expired(uint8_t dataType, uint16_t valueAddr, uint16_t valueLen);
+    bool _readSnapshotHeader(PrefsSnapshot snap, BlockHeader& header);
+    bool _finishSwitch(uint16_t blockIndex, BlockHeader& header);
+    bool _migrateV1();
+    bool _commitUpgrade(uint16_t targetBlockIndex, BlockHeader& targetHeader);
+    bool _releaseBlocksExcept(uint16_t keepBlockIndex);
     bool _runGarbageCollection();
+    bool _compactInto(uint16_t nextEmptyBlockIndex, bool keepEntries = true);
+    void _traceRecord(PrefsTraceOp op, uint16_t keyHash, size_t valueSize,
+                      bool result, uint32_t startUs, uint32_t startBusBytes);
+
+    // Asynchronous State Machine
+    PrefsAsyncHandle _asyncEnqueue(const char* key, PrefsAsyncKind kind, PrefDataType type,
+                                   const void* buf, void* dest, size_t len,
+                                   PrefsAsyncCallback callback, void* ctx);
+    void _asyncStep();
+    void _asyncRun();
+    void _asyncDrain();
+    void _asyncComplete(bool success);
+    void _asyncFlush(uint16_t address, const byte* data, uint8_t len, uint8_t nextPhase);
+    void _asyncFlushBlockHeader(uint16_t blockIndex, uint8_t status, uint16_t offset,
+                                uint8_t nextPhase);
 
     // Template Helpers
     template<typename T>
@@ -252,5 +1248,5 @@ private:
     bool _putComplexValue(const char* key, PrefDataType type, 
                          const void* valueBuf, size_t len);
     size_t _getComplexValue(const char* key, void* buf, size_t maxLen, 
-                           PrefDataType expectedType);
+                           PrefDataType expectedType, PrefsVersion* version = nullptr);
 };
\ No newline at end of file
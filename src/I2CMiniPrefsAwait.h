@@ -0,0 +1,127 @@
+/**
+ * @file I2CMiniPrefsAwait.h
+ * @brief C++20 coroutine awaitables for the I2CMiniPrefs request queue
+ *
+ * Include this header in C++20 code to co_await queued operations:
+ * @code
+ * PrefsTask storeTask(I2CMiniPrefs& prefs) {
+ *     int boots = co_await prefs.getAsync<int>("boots", 0);
+ *     bool ok = co_await prefs.putAsync("boots", boots + 1);
+ * }
+ * @endcode
+ *
+ * A coroutine suspends while its request waits for EEPROM write cycles or
+ * bus transfers and is resumed from the completion callback, i.e. from
+ * whichever task or loop() calls I2CMiniPrefs::poll(). Without C++20 the
+ * header compiles to nothing.
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#pragma once
+#include "I2CMiniPrefs.h"
+
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+
+/**
+ * @class PrefsTask
+ * @brief Minimal fire-and-forget coroutine type
+ *
+ * Starts running immediately and frees itself when it finishes. Use any
+ * other coroutine framework instead if the firmware already has one.
+ */
+class PrefsTask {
+public:
+    struct promise_type {
+        PrefsTask get_return_object() { return PrefsTask(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+/**
+ * @class PrefsPutAwaiter
+ * @brief Awaits a queued put or remove; resumes with its success flag
+ */
+class PrefsPutAwaiter {
+public:
+    explicit PrefsPutAwaiter(PrefsAsyncRef ref) : _ref(ref), _success(false) {}
+
+    bool await_ready() const { return _ref.handle == 0; }
+
+    bool await_suspend(std::coroutine_handle<> waiting) {
+        _waiting = waiting;
+        PrefsAsyncStatus status = _ref.prefs->setAsyncCallback(_ref.handle, _onDone, this);
+        if (status == PREFS_ASYNC_PENDING) return true;
+        _success = status == PREFS_ASYNC_DONE;
+        return false;
+    }
+
+    bool await_resume() const { return _success; }
+
+private:
+    static void _onDone(PrefsAsyncHandle, bool success, void* ctx) {
+        PrefsPutAwaiter* self = static_cast<PrefsPutAwaiter*>(ctx);
+        self->_success = success;
+        self->_waiting.resume();
+    }
+
+    PrefsAsyncRef _ref;
+    bool _success;
+    std::coroutine_handle<> _waiting;
+};
+
+/**
+ * @class PrefsGetAwaiter
+ * @brief Queues a typed read when awaited; resumes with the value
+ *
+ * The value is read into the awaiter, which lives in the coroutine frame
+ * until the request has completed.
+ */
+template<typename T>
+class PrefsGetAwaiter {
+public:
+    explicit PrefsGetAwaiter(const PrefsGetRequest<T>& req)
+        : _req(req), _value(req.defaultValue) {}
+
+    bool await_ready() const { return false; }
+
+    bool await_suspend(std::coroutine_handle<> waiting) {
+        _waiting = waiting;
+        // Nothing may touch *this once the request is queued: poll() in
+        // another task can resume the coroutine before we return
+        PrefsAsyncHandle handle = _req.prefs->getAsync(_req.key, PrefTypeTraits<T>::type,
+                                                       &_value, sizeof(T), _onDone, this);
+        return handle != 0;
+    }
+
+    T await_resume() const { return _value; }
+
+private:
+    static void _onDone(PrefsAsyncHandle, bool success, void* ctx) {
+        PrefsGetAwaiter* self = static_cast<PrefsGetAwaiter*>(ctx);
+        if (!success) self->_value = self->_req.defaultValue;
+        self->_waiting.resume();
+    }
+
+    PrefsGetRequest<T> _req;
+    T _value;
+    std::coroutine_handle<> _waiting;
+};
+
+inline PrefsPutAwaiter operator co_await(PrefsAsyncRef ref) {
+    return PrefsPutAwaiter(ref);
+}
+
+template<typename T>
+PrefsGetAwaiter<T> operator co_await(const PrefsGetRequest<T>& req) {
+    return PrefsGetAwaiter<T>(req);
+}
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * @file I2CMiniPrefsBus.cpp
+ * @brief Implementation of the multi-store bus scheduler
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#include "I2CMiniPrefsBus.h"
+
+I2CMiniPrefsBus::I2CMiniPrefsBus()
+    : _slots(),
+      _next(0),
+      _steps(0),
+      _idlePasses(0),
+      _foregroundWaiting(0)
+{
+#if PREFS_THREAD_SAFE
+    _busMutex = xSemaphoreCreateMutex();
+#endif
+}
+
+I2CMiniPrefsBus::~I2CMiniPrefsBus() {
+    for (uint8_t i = 0; i < PREFS_BUS_MAX_INSTANCES; i++) {
+        if (_slots[i].prefs) _slots[i].prefs->setBusLock(nullptr, nullptr);
+    }
+#if PREFS_THREAD_SAFE
+    vSemaphoreDelete(_busMutex);
+#endif
+}
+
+// Registration ---------------------------------------------------------------
+
+bool I2CMiniPrefsBus::attach(I2CMiniPrefs& prefs, uint8_t priority) {
+    int8_t freeSlot = -1;
+    for (uint8_t i = 0; i < PREFS_BUS_MAX_INSTANCES; i++) {
+        if (_slots[i].prefs == &prefs) freeSlot = i;
+        else if (!_slots[i].prefs && freeSlot < 0) freeSlot = i;
+    }
+    if (freeSlot < 0) return false;
+    _slots[freeSlot].prefs = &prefs;
+    _slots[freeSlot].priority = priority;
+    prefs.setBusLock(_lockCallback, _unlockCallback, this);
+    return true;
+}
+
+void I2CMiniPrefsBus::detach(I2CMiniPrefs& prefs) {
+    for (uint8_t i = 0; i < PREFS_BUS_MAX_INSTANCES; i++) {
+        if (_slots[i].prefs != &prefs) continue;
+        prefs.setBusLock(nullptr, nullptr);
+        _slots[i].prefs = nullptr;
+    }
+}
+
+// Scheduling -----------------------------------------------------------------
+
+/**
+ * @brief Choose the store whose next step should run
+ * @return Slot index or -1 if no store can make progress now
+ *
+ * Ready stores with foreground work win over stores collecting garbage;
+ * within a class the lower priority value wins, ties go round-robin.
+ */
+int8_t I2CMiniPrefsBus::_pickNext() {
+    int8_t best = -1;
+    uint8_t bestRank = 0xFF;
+    for (uint8_t n = 0; n < PREFS_BUS_MAX_INSTANCES; n++) {
+        uint8_t i = (_next + n) % PREFS_BUS_MAX_INSTANCES;
+        I2CMiniPrefs* prefs = _slots[i].prefs;
+        if (!prefs || !prefs->asyncReady()) continue;
+        uint8_t rank = min(_slots[i].priority, (uint8_t)0x7F);
+        if (prefs->asyncBackground()) rank |= 0x80;
+        if (rank < bestRank) {
+            best = i;
+            bestRank = rank;
+        }
+    }
+    return best;
+}
+
+bool I2CMiniPrefsBus::poll(uint32_t budgetUs) {
+    uint32_t startUs = micros();
+    do {
+        int8_t slot = _pickNext();
+        if (slot < 0) {
+            _idlePasses++;
+            break;
+        }
+        _slots[slot].prefs->poll();
+        _next = (slot + 1) % PREFS_BUS_MAX_INSTANCES;
+        _steps++;
+    } while ((uint32_t)(micros() - startUs) < budgetUs);
+
+    for (uint8_t i = 0; i < PREFS_BUS_MAX_INSTANCES; i++) {
+        if (_slots[i].prefs && _slots[i].prefs->asyncPending() > 0) return true;
+    }
+    return false;
+}
+
+// Bus Lock -------------------------------------------------------------------
+
+void I2CMiniPrefsBus::lock(PrefsBusAccess access) {
+#if PREFS_THREAD_SAFE
+    if (access == PREFS_BUS_BACKGROUND) {
+        // Let waiting foreground users go first
+        while (_foregroundWaiting > 0) vTaskDelay(1);
+        xSemaphoreTake(_busMutex, portMAX_DELAY);
+    } else {
+        __atomic_fetch_add(&_foregroundWaiting, 1, __ATOMIC_SEQ_CST);
+        xSemaphoreTake(_busMutex, portMAX_DELAY);
+        __atomic_fetch_sub(&_foregroundWaiting, 1, __ATOMIC_SEQ_CST);
+    }
+#else
+    (void)access;
+#endif
+}
+
+void I2CMiniPrefsBus::unlock() {
+#if PREFS_THREAD_SAFE
+    xSemaphoreGive(_busMutex);
+#endif
+}
+
+void I2CMiniPrefsBus::_lockCallback(void* ctx, PrefsBusAccess access) {
+    static_cast<I2CMiniPrefsBus*>(ctx)->lock(access);
+}
+
+void I2CMiniPrefsBus::_unlockCallback(void* ctx) {
+    static_cast<I2CMiniPrefsBus*>(ctx)->unlock();
+}
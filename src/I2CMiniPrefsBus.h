@@ -0,0 +1,105 @@
+/**
+ * @file I2CMiniPrefsBus.h
+ * @brief Scheduler for several I2CMiniPrefs instances sharing one I2C bus
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#pragma once
+#include "I2CMiniPrefs.h"
+
+#if PREFS_THREAD_SAFE
+#include <freertos/task.h>
+#endif
+
+/**
+ * @def PREFS_BUS_MAX_INSTANCES
+ * @brief Number of stores that can be attached to one scheduler
+ */
+#ifndef PREFS_BUS_MAX_INSTANCES
+#define PREFS_BUS_MAX_INSTANCES 4
+#endif
+
+/**
+ * @class I2CMiniPrefsBus
+ * @brief Orders the queued requests of several stores on one bus
+ *
+ * - poll() runs queued steps of all attached stores within a time budget
+ * - a store whose EEPROM is in its write cycle is skipped, so the cycle
+ *   overlaps with transfers to the other chips
+ * - foreground requests (put/get/remove) go before garbage collection,
+ *   then by store priority, round-robin among equals
+ * - the bus lock installed on every store makes background transfers
+ *   wait while foreground transfers or other drivers are waiting
+ */
+class I2CMiniPrefsBus {
+public:
+    I2CMiniPrefsBus();
+    ~I2CMiniPrefsBus();
+
+    /**
+     * @brief Register a store and install the shared bus lock on it
+     * @param prefs Store (must outlive the scheduler or be detached)
+     * @param priority 0 = most latency-sensitive
+     * @return false if the scheduler is full
+     */
+    bool attach(I2CMiniPrefs& prefs, uint8_t priority = 0);
+
+    /**
+     * @brief Unregister a store and remove its bus lock
+     */
+    void detach(I2CMiniPrefs& prefs);
+
+    /**
+     * @brief Advance queued requests of all stores
+     * @param budgetUs Time budget; at least one step is run if any is ready
+     * @return true while any store has pending requests
+     */
+    bool poll(uint32_t budgetUs = 1000);
+
+    /**
+     * @brief Take the bus for another driver (sensors etc.)
+     * @param access PREFS_BUS_BACKGROUND yields to waiting foreground users
+     */
+    void lock(PrefsBusAccess access = PREFS_BUS_READ);
+
+    /**
+     * @brief Release the bus after lock()
+     */
+    void unlock();
+
+    /**
+     * @brief Steps run by poll() since construction
+     */
+    uint32_t steps() const { return _steps; }
+
+    /**
+     * @brief poll() passes where every pending store was in a write cycle
+     */
+    uint32_t idlePasses() const { return _idlePasses; }
+
+private:
+    /**
+     * @struct Slot
+     * @brief One attached store
+     */
+    struct Slot {
+        I2CMiniPrefs* prefs;     ///< Attached store (nullptr = free)
+        uint8_t priority;        ///< 0 = highest
+    };
+
+    Slot _slots[PREFS_BUS_MAX_INSTANCES]; ///< Attached stores
+    uint8_t _next;               ///< Round-robin start position
+    uint32_t _steps;             ///< Steps run by poll()
+    uint32_t _idlePasses;        ///< Passes without a ready store
+    volatile uint8_t _foregroundWaiting; ///< Foreground users waiting for the bus
+#if PREFS_THREAD_SAFE
+    SemaphoreHandle_t _busMutex; ///< Shared bus mutex
+#endif
+
+    int8_t _pickNext();
+    static void _lockCallback(void* ctx, PrefsBusAccess access);
+    static void _unlockCallback(void* ctx);
+};
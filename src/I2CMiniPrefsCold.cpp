@@ -0,0 +1,459 @@
+/**
+ * @file I2CMiniPrefsCold.cpp
+ * @brief Implementation of the cold tier and its backends
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#include "I2CMiniPrefsCold.h"
+
+#define PREFS_COLD_IMAGE_HEADER 5   ///< Magic and version, as exportTo()
+#define PREFS_COLD_COPY_CHUNK   32  ///< Bytes moved per read/write during a rewrite
+
+/**
+ * @brief CRC8 (polynomial 0x07), the checksum of the export format
+ */
+static uint8_t coldCrc8(const byte* data, size_t len, uint8_t crc) {
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t j = 0; j < 8; j++) {
+            if ((crc & 0x80) != 0) crc = (uint8_t)((crc << 1) ^ 0x07);
+            else crc <<= 1;
+        }
+    }
+    return crc;
+}
+
+PrefsColdTier::PrefsColdTier(PrefsColdBackend& backend)
+    : _backend(backend),
+      _index(),
+      _count(0),
+      _newCount(0),
+      _newCrc(0)
+{
+#if PREFS_THREAD_SAFE
+    _mutex = xSemaphoreCreateMutex();
+#endif
+}
+
+PrefsColdTier::~PrefsColdTier() {
+#if PREFS_THREAD_SAFE
+    vSemaphoreDelete(_mutex);
+#endif
+}
+
+// Locking --------------------------------------------------------------------
+
+// Lookups run under the shared read lock of I2CMiniPrefs, and backends
+// such as PrefsColdFile seek a single handle. Rewrites already hold the
+// exclusive write lock.
+
+void PrefsColdTier::_lock() {
+#if PREFS_THREAD_SAFE
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+#endif
+}
+
+void PrefsColdTier::_unlock() {
+#if PREFS_THREAD_SAFE
+    xSemaphoreGive(_mutex);
+#endif
+}
+
+// Index ----------------------------------------------------------------------
+
+/**
+ * @brief DJB2 hash, the same as the entry headers use
+ */
+uint16_t PrefsColdTier::_hashKey(const char* key, size_t len) {
+    uint16_t hash = 5381;
+    for (size_t i = 0; i < len; i++) hash = ((hash << 5) + hash) + key[i];
+    return hash;
+}
+
+/**
+ * @brief Load the stored image, or the replacement a cut commit left behind
+ */
+bool PrefsColdTier::begin() {
+    _count = 0;
+    if (_backend.size() != 0) return _load();
+    if (!_backend.recover()) return true;
+
+    // Only a complete replacement becomes the image
+    if (_load() && _backend.commit()) return true;
+    _count = 0;
+    _backend.abort();
+    return true;
+}
+
+/**
+ * @brief Parse the current image and rebuild the index
+ *
+ * Every record is read once to check the trailing count and CRC; an
+ * image that fails the check is ignored as a whole.
+ */
+bool PrefsColdTier::_load() {
+    _count = 0;
+    byte header[PREFS_COLD_IMAGE_HEADER];
+    if (_backend.read(0, header, sizeof(header)) != sizeof(header) ||
+        memcmp(header, PREFS_EXPORT_MAGIC, 4) != 0 ||
+        header[4] != PREFS_EXPORT_VERSION) return false;
+
+    uint32_t offset = PREFS_COLD_IMAGE_HEADER;
+    uint8_t crc = 0x00;
+    uint16_t count = 0;
+    byte chunk[PREFS_COLD_COPY_CHUNK];
+    while (true) {
+        byte record[4];
+        if (_backend.read(offset, record, 1) != 1) return false;
+        if (record[0] == 0x00) break;   // Terminator
+        if (!_readRecordHeader(offset, record) || count >= PREFS_COLD_MAX_ENTRIES) {
+            _count = 0;
+            return false;
+        }
+        crc = coldCrc8(record, sizeof(record), crc);
+
+        // Hash the key, CRC key and value
+        uint16_t hash = 5381;
+        size_t recordLen = 4 + record[1] + (record[2] | (record[3] << 8));
+        for (size_t pos = 4; pos < recordLen; ) {
+            size_t len = min(recordLen - pos, (size_t)sizeof(chunk));
+            if (_backend.read(offset + pos, chunk, len) != len) {
+                _count = 0;
+                return false;
+            }
+            for (size_t i = 0; i < len && pos + i < 4u + record[1]; i++) {
+                hash = ((hash << 5) + hash) + (char)chunk[i];
+            }
+            crc = coldCrc8(chunk, len, crc);
+            pos += len;
+        }
+        _index[count].hash = hash;
+        _index[count].offset = offset;
+        count++;
+        offset += recordLen;
+    }
+
+    byte trailer[3];
+    if (_backend.read(offset + 1, trailer, sizeof(trailer)) != sizeof(trailer) ||
+        (uint16_t)(trailer[0] | (trailer[1] << 8)) != count ||
+        coldCrc8(trailer, 2, crc) != trailer[2]) return false;
+    _count = count;
+    return true;
+}
+
+bool PrefsColdTier::_readRecordHeader(uint32_t offset, byte header[4]) {
+    return _backend.read(offset, header, 4) == 4 && header[0] != 0x00 && header[1] != 0;
+}
+
+/**
+ * @brief Index slot of key, -1 if not stored
+ */
+int16_t PrefsColdTier::_find(const char* key) {
+    size_t keyLen = strlen(key);
+    uint16_t hash = _hashKey(key, keyLen);
+    for (uint16_t i = 0; i < _count; i++) {
+        if (_index[i].hash != hash) continue;
+        byte header[4];
+        char readKey[256];   // keyLength is a uint8_t
+        if (!_readRecordHeader(_index[i].offset, header) || header[1] != keyLen) continue;
+        if (_backend.read(_index[i].offset + 4, (byte*)readKey, keyLen) != keyLen) continue;
+        if (memcmp(readKey, key, keyLen) == 0) return i;
+    }
+    return -1;
+}
+
+// Lookup ---------------------------------------------------------------------
+
+size_t PrefsColdTier::get(const char* key, PrefDataType type, void* buf, size_t maxLen) {
+    if (_count == 0) return 0;
+    _lock();
+    size_t valueLen = 0;
+    int16_t slot = _find(key);
+    byte header[4];
+    uint32_t offset = slot >= 0 ? _index[slot].offset : 0;
+    if (slot >= 0 && _readRecordHeader(offset, header) && header[0] == type) {
+        valueLen = header[2] | (header[3] << 8);
+        size_t len = min(valueLen, maxLen);
+        if (buf && _backend.read(offset + 4 + header[1], (byte*)buf, len) != len) valueLen = 0;
+    }
+    _unlock();
+    return valueLen;
+}
+
+bool PrefsColdTier::contains(const char* key) {
+    if (_count == 0) return false;
+    _lock();
+    bool found = _find(key) >= 0;
+    _unlock();
+    return found;
+}
+
+bool PrefsColdTier::stat(const char* key, PrefDataType& type, uint16_t& valueLen) {
+    if (_count == 0) return false;
+    _lock();
+    int16_t slot = _find(key);
+    byte header[4];
+    bool found = slot >= 0 && _readRecordHeader(_index[slot].offset, header);
+    if (found) {
+        type = (PrefDataType)header[0];
+        valueLen = header[2] | (header[3] << 8);
+    }
+    _unlock();
+    return found;
+}
+
+size_t PrefsColdTier::recordAt(uint16_t index, byte* record, size_t maxLen) {
+    if (index >= _count || maxLen < 4) return 0;
+    _lock();
+    uint32_t offset = _index[index].offset;
+    size_t recordLen = 0;
+    if (_readRecordHeader(offset, record)) {
+        recordLen = 4 + record[1] + (record[2] | (record[3] << 8));
+        if (recordLen > maxLen ||
+            _backend.read(offset + 4, record + 4, recordLen - 4) != recordLen - 4) recordLen = 0;
+    }
+    _unlock();
+    return recordLen;
+}
+
+// Updates --------------------------------------------------------------------
+
+static bool keepOthers(const char* key, void* ctx) {
+    return strcmp(key, (const char*)ctx) != 0;
+}
+
+static bool keepNone(const char*, void*) {
+    return false;
+}
+
+bool PrefsColdTier::remove(const char* key) {
+    if (_find(key) < 0) return false;
+    if (!beginRewrite(keepOthers, (void*)key)) return false;
+    return commitRewrite();
+}
+
+bool PrefsColdTier::clear() {
+    if (_count == 0 && _backend.size() == 0) return true;
+    if (!beginRewrite(keepNone, nullptr)) return false;
+    return commitRewrite();
+}
+
+/**
+ * @brief Append to the new image and update its CRC
+ */
+bool PrefsColdTier::_emit(const byte* data, size_t len) {
+    _newCrc = coldCrc8(data, len, _newCrc);
+    return _backend.write(data, len);
+}
+
+bool PrefsColdTier::beginRewrite(KeepFn keep, void* ctx) {
+    if (!_backend.beginWrite()) return false;
+    byte header[PREFS_COLD_IMAGE_HEADER];
+    memcpy(header, PREFS_EXPORT_MAGIC, 4);
+    header[4] = PREFS_EXPORT_VERSION;
+    _newCount = 0;
+    _newCrc = 0x00;
+    bool ok = _backend.write(header, sizeof(header));
+
+    // Copy the surviving records chunk by chunk
+    for (uint16_t i = 0; ok && i < _count; i++) {
+        uint32_t offset = _index[i].offset;
+        byte record[4];
+        char key[256];
+        ok = _readRecordHeader(offset, record) &&
+             _backend.read(offset + 4, (byte*)key, record[1]) == record[1];
+        if (!ok) break;
+        key[record[1]] = '\0';
+        if (keep && !keep(key, ctx)) continue;
+
+        ok = _emit(record, sizeof(record)) && _emit((const byte*)key, record[1]);
+        uint32_t valueOffset = offset + 4 + record[1];
+        uint16_t valueLen = record[2] | (record[3] << 8);
+        byte chunk[PREFS_COLD_COPY_CHUNK];
+        for (uint16_t pos = 0; ok && pos < valueLen; ) {
+            size_t len = min((size_t)(valueLen - pos), sizeof(chunk));
+            ok = _backend.read(valueOffset + pos, chunk, len) == len && _emit(chunk, len);
+            pos += len;
+        }
+        _newCount++;
+    }
+    if (!ok) _backend.abort();
+    return ok;
+}
+
+bool PrefsColdTier::append(PrefDataType type, const char* key, uint8_t keyLen,
+                           const byte* value, uint16_t valueLen) {
+    if (_newCount >= PREFS_COLD_MAX_ENTRIES || keyLen == 0 || type == TYPE_NONE) return false;
+    byte header[4] = {(byte)type, keyLen, (byte)(valueLen & 0xFF), (byte)(valueLen >> 8)};
+    if (!_emit(header, sizeof(header)) || !_emit((const byte*)key, keyLen) ||
+        !_emit(value, valueLen)) return false;
+    _newCount++;
+    return true;
+}
+
+bool PrefsColdTier::commitRewrite() {
+    byte trailer[4] = {0x00, (byte)(_newCount & 0xFF), (byte)(_newCount >> 8), 0};
+    trailer[3] = coldCrc8(trailer + 1, 2, _newCrc);
+    if (!_backend.write(trailer, sizeof(trailer))) {
+        _backend.abort();
+        return false;
+    }
+    return _backend.commit() && begin();
+}
+
+void PrefsColdTier::abortRewrite() {
+    _backend.abort();
+}
+
+// ESP32 NVS Backend ----------------------------------------------------------
+
+#if defined(ESP32)
+
+#define PREFS_COLD_NVS_KEY "image"
+
+PrefsColdNvs::PrefsColdNvs(const char* ns)
+    : _ns(ns),
+      _loaded(false),
+      _image(nullptr),
+      _imageLen(0),
+      _pending(nullptr),
+      _pendingLen(0)
+{
+}
+
+PrefsColdNvs::~PrefsColdNvs() {
+    free(_image);
+    free(_pending);
+}
+
+void PrefsColdNvs::_load() {
+    if (_loaded) return;
+    _loaded = true;
+    Preferences nvs;
+    if (!nvs.begin(_ns, true)) return;   // Namespace not created yet
+    size_t len = nvs.getBytesLength(PREFS_COLD_NVS_KEY);
+    if (len > 0 && (_image = (byte*)malloc(len)) != nullptr) {
+        _imageLen = nvs.getBytes(PREFS_COLD_NVS_KEY, _image, len);
+    }
+    nvs.end();
+}
+
+size_t PrefsColdNvs::size() {
+    _load();
+    return _imageLen;
+}
+
+size_t PrefsColdNvs::read(uint32_t offset, byte* buf, size_t len) {
+    _load();
+    if (offset >= _imageLen) return 0;
+    len = min(len, _imageLen - offset);
+    memcpy(buf, _image + offset, len);
+    return len;
+}
+
+bool PrefsColdNvs::beginWrite() {
+    abort();
+    return true;
+}
+
+bool PrefsColdNvs::write(const byte* data, size_t len) {
+    byte* grown = (byte*)realloc(_pending, _pendingLen + len);
+    if (!grown) return false;
+    _pending = grown;
+    memcpy(_pending + _pendingLen, data, len);
+    _pendingLen += len;
+    return true;
+}
+
+bool PrefsColdNvs::commit() {
+    Preferences nvs;
+    if (!nvs.begin(_ns, false)) return false;
+    bool ok = nvs.putBytes(PREFS_COLD_NVS_KEY, _pending, _pendingLen) == _pendingLen;
+    nvs.end();
+    if (!ok) return false;
+    free(_image);
+    _image = _pending;
+    _imageLen = _pendingLen;
+    _pending = nullptr;
+    _pendingLen = 0;
+    return true;
+}
+
+void PrefsColdNvs::abort() {
+    free(_pending);
+    _pending = nullptr;
+    _pendingLen = 0;
+}
+
+#endif
+
+// File System Backend --------------------------------------------------------
+
+#if defined(ESP32) || defined(ESP8266)
+
+PrefsColdFile::PrefsColdFile(fs::FS& fs, const char* path)
+    : _fs(fs),
+      _path(path),
+      _tmpPath(String(path) + ".tmp"),
+      _recovered(false)
+{
+}
+
+size_t PrefsColdFile::size() {
+    if (!_in) {
+        if (!_fs.exists(_path)) return 0;
+        _in = _fs.open(_path, "r");
+    }
+    return _in ? _in.size() : 0;
+}
+
+size_t PrefsColdFile::read(uint32_t offset, byte* buf, size_t len) {
+    if (!_in && size() == 0) return 0;
+    if (!_in.seek(offset)) return 0;
+    return _in.read(buf, len);
+}
+
+bool PrefsColdFile::recover() {
+    if (_in || _out || _fs.exists(_path) || !_fs.exists(_tmpPath)) return false;
+    _in = _fs.open(_tmpPath, "r");
+    _recovered = (bool)_in;
+    return _recovered;
+}
+
+bool PrefsColdFile::beginWrite() {
+    abort();
+    _out = _fs.open(_tmpPath, "w");
+    return (bool)_out;
+}
+
+bool PrefsColdFile::write(const byte* data, size_t len) {
+    return _out && _out.write(data, len) == len;
+}
+
+bool PrefsColdFile::commit() {
+    _out.close();
+    if (_in) _in.close();
+    _recovered = false;
+    if (_fs.rename(_tmpPath, _path)) return true;
+    // File systems that do not replace on rename; a cut before the
+    // rename leaves only the replacement, which recover() picks up
+    _fs.remove(_path);
+    return _fs.rename(_tmpPath, _path);
+}
+
+void PrefsColdFile::abort() {
+    if (_recovered) {
+        _recovered = false;
+        _in.close();
+    } else if (_out) {
+        _out.close();
+    } else {
+        return;
+    }
+    _fs.remove(_tmpPath);
+}
+
+#endif
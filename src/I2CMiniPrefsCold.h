@@ -0,0 +1,288 @@
+/**
+ * @file I2CMiniPrefsCold.h
+ * @brief Cold tier for entries that garbage collection keeps copying unchanged
+ *
+ * Entries that survived a number of garbage collections without being
+ * written again are moved off the I2C chip into a cold store in the
+ * MCU's own flash (NVS, a file system) and served from there:
+ * @code
+ * PrefsColdNvs coldBackend("prefs-cold");
+ * PrefsColdTier cold(coldBackend);
+ * I2CMiniPrefs prefs(MEM_TYPE_FRAM, 0x50, 32 * 1024, 1024, 16, 64);
+ *
+ * cold.begin();
+ * prefs.setColdTier(&cold, 4);   // migrate after 4 GC generations
+ * prefs.begin();
+ * @endcode
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#pragma once
+#include "I2CMiniPrefs.h"
+
+#if defined(ESP32)
+#include <Preferences.h>
+#endif
+#if defined(ESP32) || defined(ESP8266)
+#include <FS.h>
+#endif
+
+/**
+ * @def PREFS_COLD_MAX_ENTRIES
+ * @brief Entries the RAM index of a cold tier can hold (8 bytes each)
+ */
+#ifndef PREFS_COLD_MAX_ENTRIES
+#define PREFS_COLD_MAX_ENTRIES 64
+#endif
+
+/**
+ * @class PrefsColdBackend
+ * @brief Byte storage for one cold tier image
+ *
+ * The image is only ever replaced as a whole: beginWrite(), write() in
+ * order, then commit() swaps it in atomically. read() keeps returning
+ * the old image until then.
+ */
+class PrefsColdBackend {
+public:
+    virtual ~PrefsColdBackend() {}
+
+    /// Size of the current image (0 if none)
+    virtual size_t size() = 0;
+
+    /// Read from the current image
+    virtual size_t read(uint32_t offset, byte* buf, size_t len) = 0;
+
+    /// Start a replacement image
+    virtual bool beginWrite() = 0;
+
+    /// Append to the replacement image
+    virtual bool write(const byte* data, size_t len) = 0;
+
+    /// Make the replacement image current
+    virtual bool commit() = 0;
+
+    /// Drop the replacement image
+    virtual void abort() = 0;
+
+    /**
+     * @brief Serve a replacement whose commit() was cut short
+     *
+     * Only needed where commit() removes the image before renaming its
+     * replacement. read() then returns the replacement until commit()
+     * or abort() settles it.
+     * @return false if there is no such replacement
+     */
+    virtual bool recover() { return false; }
+};
+
+/**
+ * @class PrefsColdTier
+ * @brief Cold entries in exportTo() format with a RAM index
+ *
+ * The image holds the same records as an exportTo() snapshot. begin()
+ * checks its CRC and indexes every record by key hash, so a lookup costs
+ * one backend read for a hit and none for a miss. Updates rewrite the
+ * image, which is fine for entries that by definition rarely change.
+ */
+class PrefsColdTier {
+public:
+    /**
+     * @brief Bind a backend
+     * @param backend Storage of the image (must outlive the tier)
+     */
+    explicit PrefsColdTier(PrefsColdBackend& backend);
+    ~PrefsColdTier();
+
+    /**
+     * @brief Load the index from the stored image
+     *
+     * Without an image, a complete replacement left by an interrupted
+     * commit becomes the image; an incomplete one is dropped.
+     * @return false if the image is corrupt (the tier is then empty)
+     */
+    bool begin();
+
+    /**
+     * @brief Read a value
+     * @param key Null-terminated key string
+     * @param type Expected type tag
+     * @param buf Destination (nullptr to query the length only)
+     * @param maxLen Buffer size
+     * @return Stored value length (the smaller of it and maxLen is copied),
+     *         0 if missing or of another type
+     */
+    size_t get(const char* key, PrefDataType type, void* buf, size_t maxLen);
+
+    /**
+     * @brief Whether key is stored in the tier
+     */
+    bool contains(const char* key);
+
+    /**
+     * @brief Type and value length of key without reading the value
+     * @return false if key is not stored
+     */
+    bool stat(const char* key, PrefDataType& type, uint16_t& valueLen);
+
+    /**
+     * @brief Delete key by rewriting the image
+     * @return true if the key was present and the image was rewritten
+     */
+    bool remove(const char* key);
+
+    /**
+     * @brief Drop all entries
+     */
+    bool clear();
+
+    /**
+     * @brief Number of indexed entries
+     */
+    uint16_t count() const { return _count; }
+
+    /**
+     * @brief Free index slots
+     */
+    uint16_t freeSlots() const { return PREFS_COLD_MAX_ENTRIES - _count; }
+
+    /**
+     * @brief Copy one record (type, key length, value length LE16, key, value)
+     * @param index 0 .. count() - 1
+     * @param record Destination
+     * @param maxLen Size of record
+     * @return Record length, 0 if it does not fit
+     */
+    size_t recordAt(uint16_t index, byte* record, size_t maxLen);
+
+    /// @name Image Rewrite
+    /// Used by I2CMiniPrefs garbage collection to move entries in.
+    ///@{
+    /// Callback deciding whether an old record survives a rewrite
+    typedef bool (*KeepFn)(const char* key, void* ctx);
+
+    /**
+     * @brief Start a new image and copy the surviving old records into it
+     * @param keep Called per old record; nullptr keeps all
+     * @param ctx Passed to keep
+     */
+    bool beginRewrite(KeepFn keep, void* ctx);
+
+    /**
+     * @brief Add a record to the new image
+     */
+    bool append(PrefDataType type, const char* key, uint8_t keyLen,
+                const byte* value, uint16_t valueLen);
+
+    /**
+     * @brief Finish the new image, swap it in and reindex
+     */
+    bool commitRewrite();
+
+    /**
+     * @brief Drop the new image; the old one stays in use
+     */
+    void abortRewrite();
+    ///@}
+
+private:
+    /**
+     * @struct Slot
+     * @brief Index entry
+     */
+    struct Slot {
+        uint16_t hash;           ///< DJB2 hash of the key
+        uint32_t offset;         ///< Record offset in the image
+    };
+
+    PrefsColdBackend& _backend;  ///< Image storage
+    Slot _index[PREFS_COLD_MAX_ENTRIES]; ///< Records of the current image
+    uint16_t _count;             ///< Used index slots
+    uint16_t _newCount;          ///< Records in the image being written
+    uint8_t _newCrc;             ///< CRC of the image being written
+#if PREFS_THREAD_SAFE
+    SemaphoreHandle_t _mutex;    ///< Serializes backend reads of concurrent readers
+#endif
+
+    static uint16_t _hashKey(const char* key, size_t len);
+    bool _load();
+    int16_t _find(const char* key);
+    bool _readRecordHeader(uint32_t offset, byte header[4]);
+    bool _emit(const byte* data, size_t len);
+    void _lock();
+    void _unlock();
+};
+
+#if defined(ESP32)
+/**
+ * @class PrefsColdNvs
+ * @brief Cold image as one blob in the ESP32 NVS partition
+ *
+ * The blob is cached in RAM, since NVS can only read a blob as a whole.
+ * Suits a few hundred bytes of configuration.
+ */
+class PrefsColdNvs : public PrefsColdBackend {
+public:
+    /**
+     * @param ns NVS namespace (at most 15 characters)
+     */
+    explicit PrefsColdNvs(const char* ns);
+    ~PrefsColdNvs();
+
+    size_t size() override;
+    size_t read(uint32_t offset, byte* buf, size_t len) override;
+    bool beginWrite() override;
+    bool write(const byte* data, size_t len) override;
+    bool commit() override;
+    void abort() override;
+
+private:
+    const char* _ns;             ///< NVS namespace
+    bool _loaded;                ///< _image holds the stored blob
+    byte* _image;                ///< Cached current blob
+    size_t _imageLen;            ///< Bytes in _image
+    byte* _pending;              ///< Replacement blob
+    size_t _pendingLen;          ///< Bytes in _pending
+
+    void _load();
+};
+#endif
+
+#if defined(ESP32) || defined(ESP8266)
+/**
+ * @class PrefsColdFile
+ * @brief Cold image as a file (LittleFS, SD, ...)
+ *
+ * Replacements are written to "<path>.tmp" and renamed over the image,
+ * which LittleFS performs atomically. Where rename does not replace,
+ * the image is removed first; PrefsColdTier::begin() then adopts a
+ * replacement a cut left behind.
+ */
+class PrefsColdFile : public PrefsColdBackend {
+public:
+    /**
+     * @param fs Mounted file system
+     * @param path Image path, e.g. "/prefs-cold.bin"
+     */
+    PrefsColdFile(fs::FS& fs, const char* path);
+
+    size_t size() override;
+    size_t read(uint32_t offset, byte* buf, size_t len) override;
+    bool beginWrite() override;
+    bool write(const byte* data, size_t len) override;
+    bool commit() override;
+    void abort() override;
+    bool recover() override;
+
+private:
+    fs::FS& _fs;                 ///< File system
+    String _path;                ///< Image path
+    String _tmpPath;             ///< Replacement path
+    fs::File _in;                ///< Open image (kept between reads)
+    fs::File _out;               ///< Open replacement
+    bool _recovered;             ///< _in is a replacement left by a cut commit
+};
+#endif
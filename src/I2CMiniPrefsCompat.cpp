@@ -0,0 +1,239 @@
+/**
+ * @file I2CMiniPrefsCompat.cpp
+ * @brief Implementation of the Preferences-compatible facade
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#include "I2CMiniPrefsCompat.h"
+
+I2CPreferences::I2CPreferences(I2CMiniPrefs& store)
+    : _store(store),
+      _prefix(nullptr),
+      _prefixLen(0),
+      _readOnly(false)
+{
+}
+
+// Namespace ------------------------------------------------------------------
+
+bool I2CPreferences::begin(const char* name, bool readOnly, const char* partition_label) {
+    (void)partition_label;
+    if (_prefix || !name) return false;
+    size_t nameLen = strlen(name);
+    // Leave room for the separator and a one-character key
+    if (nameLen == 0 || nameLen + 2 > _store.maxKeyLength()) return false;
+    if (!_store.isOpen() && !_store.begin()) return false;
+
+    _prefix = new char[nameLen + 2];
+    memcpy(_prefix, name, nameLen);
+    _prefix[nameLen] = PREFS_NAMESPACE_SEPARATOR;
+    _prefix[nameLen + 1] = '\0';
+    _prefixLen = nameLen + 1;
+    _readOnly = readOnly;
+    return true;
+}
+
+void I2CPreferences::end() {
+    delete[] _prefix;
+    _prefix = nullptr;
+    _prefixLen = 0;
+}
+
+/**
+ * @brief Build "<namespace>/<key>"
+ * @return false if no namespace is open or the result exceeds maxKeyLen
+ */
+bool I2CPreferences::_fullKey(const char* key, char* out, size_t size) const {
+    if (!_prefix || !key) return false;
+    size_t keyLen = strlen(key);
+    if (keyLen == 0 || _prefixLen + keyLen >= size) return false;
+    memcpy(out, _prefix, _prefixLen);
+    memcpy(out + _prefixLen, key, keyLen + 1);
+    return true;
+}
+
+bool I2CPreferences::clear() {
+    return _writable() && _store.removePrefix(_prefix);
+}
+
+bool I2CPreferences::remove(const char* key) {
+    char fullKey[_store.maxKeyLength() + 1];
+    return _writable() && _fullKey(key, fullKey, sizeof(fullKey)) && _store.remove(fullKey);
+}
+
+// Write Operations -----------------------------------------------------------
+
+template<typename T>
+size_t I2CPreferences::_put(const char* key, T value, bool (I2CMiniPrefs::*put)(const char*, T)) {
+    char fullKey[_store.maxKeyLength() + 1];
+    if (!_writable() || !_fullKey(key, fullKey, sizeof(fullKey))) return 0;
+    return (_store.*put)(fullKey, value) ? sizeof(T) : 0;
+}
+
+size_t I2CPreferences::putChar(const char* key, int8_t value) {
+    return _put<char>(key, value, &I2CMiniPrefs::putChar);
+}
+
+size_t I2CPreferences::putUChar(const char* key, uint8_t value) {
+    return _put<unsigned char>(key, value, &I2CMiniPrefs::putUChar);
+}
+
+size_t I2CPreferences::putShort(const char* key, int16_t value) {
+    return _put<short>(key, value, &I2CMiniPrefs::putShort);
+}
+
+size_t I2CPreferences::putUShort(const char* key, uint16_t value) {
+    return _put<unsigned short>(key, value, &I2CMiniPrefs::putUShort);
+}
+
+size_t I2CPreferences::putInt(const char* key, int32_t value) {
+    return _put<int>(key, value, &I2CMiniPrefs::putInt);
+}
+
+size_t I2CPreferences::putUInt(const char* key, uint32_t value) {
+    return _put<unsigned int>(key, value, &I2CMiniPrefs::putUInt);
+}
+
+size_t I2CPreferences::putLong(const char* key, int32_t value) {
+    return _put<long>(key, value, &I2CMiniPrefs::putLong);
+}
+
+size_t I2CPreferences::putULong(const char* key, uint32_t value) {
+    return _put<unsigned long>(key, value, &I2CMiniPrefs::putULong);
+}
+
+size_t I2CPreferences::putLong64(const char* key, int64_t value) {
+    return _put<long long>(key, value, &I2CMiniPrefs::putLong64);
+}
+
+size_t I2CPreferences::putULong64(const char* key, uint64_t value) {
+    return _put<unsigned long long>(key, value, &I2CMiniPrefs::putULong64);
+}
+
+size_t I2CPreferences::putFloat(const char* key, float value) {
+    return _put<float>(key, value, &I2CMiniPrefs::putFloat);
+}
+
+size_t I2CPreferences::putDouble(const char* key, double value) {
+    return _put<double>(key, value, &I2CMiniPrefs::putDouble);
+}
+
+size_t I2CPreferences::putBool(const char* key, bool value) {
+    return _put<bool>(key, value, &I2CMiniPrefs::putBool);
+}
+
+size_t I2CPreferences::putString(const char* key, const char* value) {
+    char fullKey[_store.maxKeyLength() + 1];
+    if (!value || !_writable() || !_fullKey(key, fullKey, sizeof(fullKey))) return 0;
+    return _store.putString(fullKey, value) ? strlen(value) : 0;
+}
+
+size_t I2CPreferences::putString(const char* key, String value) {
+    return putString(key, value.c_str());
+}
+
+size_t I2CPreferences::putBytes(const char* key, const void* value, size_t len) {
+    char fullKey[_store.maxKeyLength() + 1];
+    if (!value || len == 0 || !_writable() || !_fullKey(key, fullKey, sizeof(fullKey))) return 0;
+    return _store.putBytes(fullKey, value, len) ? len : 0;
+}
+
+// Read Operations ------------------------------------------------------------
+
+template<typename T>
+T I2CPreferences::_get(const char* key, T defaultValue, T (I2CMiniPrefs::*get)(const char*, T)) {
+    char fullKey[_store.maxKeyLength() + 1];
+    if (!_fullKey(key, fullKey, sizeof(fullKey))) return defaultValue;
+    return (_store.*get)(fullKey, defaultValue);
+}
+
+bool I2CPreferences::isKey(const char* key) {
+    char fullKey[_store.maxKeyLength() + 1];
+    return _fullKey(key, fullKey, sizeof(fullKey)) && _store.isKey(fullKey);
+}
+
+int8_t I2CPreferences::getChar(const char* key, int8_t defaultValue) {
+    return _get<char>(key, defaultValue, &I2CMiniPrefs::getChar);
+}
+
+uint8_t I2CPreferences::getUChar(const char* key, uint8_t defaultValue) {
+    return _get<unsigned char>(key, defaultValue, &I2CMiniPrefs::getUChar);
+}
+
+int16_t I2CPreferences::getShort(const char* key, int16_t defaultValue) {
+    return _get<short>(key, defaultValue, &I2CMiniPrefs::getShort);
+}
+
+uint16_t I2CPreferences::getUShort(const char* key, uint16_t defaultValue) {
+    return _get<unsigned short>(key, defaultValue, &I2CMiniPrefs::getUShort);
+}
+
+int32_t I2CPreferences::getInt(const char* key, int32_t defaultValue) {
+    return _get<int>(key, defaultValue, &I2CMiniPrefs::getInt);
+}
+
+uint32_t I2CPreferences::getUInt(const char* key, uint32_t defaultValue) {
+    return _get<unsigned int>(key, defaultValue, &I2CMiniPrefs::getUInt);
+}
+
+int32_t I2CPreferences::getLong(const char* key, int32_t defaultValue) {
+    return _get<long>(key, defaultValue, &I2CMiniPrefs::getLong);
+}
+
+uint32_t I2CPreferences::getULong(const char* key, uint32_t defaultValue) {
+    return _get<unsigned long>(key, defaultValue, &I2CMiniPrefs::getULong);
+}
+
+int64_t I2CPreferences::getLong64(const char* key, int64_t defaultValue) {
+    return _get<long long>(key, defaultValue, &I2CMiniPrefs::getLong64);
+}
+
+uint64_t I2CPreferences::getULong64(const char* key, uint64_t defaultValue) {
+    return _get<unsigned long long>(key, defaultValue, &I2CMiniPrefs::getULong64);
+}
+
+float I2CPreferences::getFloat(const char* key, float defaultValue) {
+    return _get<float>(key, defaultValue, &I2CMiniPrefs::getFloat);
+}
+
+double I2CPreferences::getDouble(const char* key, double defaultValue) {
+    return _get<double>(key, defaultValue, &I2CMiniPrefs::getDouble);
+}
+
+bool I2CPreferences::getBool(const char* key, bool defaultValue) {
+    return _get<bool>(key, defaultValue, &I2CMiniPrefs::getBool);
+}
+
+size_t I2CPreferences::getString(const char* key, char* value, size_t maxLen) {
+    char fullKey[_store.maxKeyLength() + 1];
+    if (!value || maxLen == 0 || !_fullKey(key, fullKey, sizeof(fullKey))) return 0;
+    size_t len = _store.getTyped(fullKey, TYPE_STRING, value, maxLen);
+    // Like NVS, a string that does not fit is not returned at all
+    if (len == 0 || value[len - 1] != '\0') return 0;
+    return len;
+}
+
+String I2CPreferences::getString(const char* key, String defaultValue) {
+    char fullKey[_store.maxKeyLength() + 1];
+    if (!_fullKey(key, fullKey, sizeof(fullKey))) return defaultValue;
+    return _store.getString(fullKey, defaultValue.c_str());
+}
+
+size_t I2CPreferences::getBytesLength(const char* key) {
+    char fullKey[_store.maxKeyLength() + 1];
+    if (!_fullKey(key, fullKey, sizeof(fullKey)) || _store.getType(fullKey) != TYPE_BYTES) return 0;
+    return _store.getValueLength(fullKey);
+}
+
+size_t I2CPreferences::getBytes(const char* key, void* buf, size_t maxLen) {
+    char fullKey[_store.maxKeyLength() + 1];
+    if (!buf || !_fullKey(key, fullKey, sizeof(fullKey))) return 0;
+    return _store.getBytes(fullKey, buf, maxLen);
+}
+
+size_t I2CPreferences::freeEntries() {
+    return _store.freeBytes() / (ENTRY_HEADER_SIZE + _store.maxKeyLength() + 8);
+}
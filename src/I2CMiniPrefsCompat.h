@@ -0,0 +1,148 @@
+/**
+ * @file I2CMiniPrefsCompat.h
+ * @brief Drop-in replacement for the ESP32 Preferences class
+ *
+ * Moves a namespace from NVS to an I2C chip without touching the code
+ * that uses it; NVS writes stall both cores while the flash cache is off,
+ * FRAM writes do not:
+ * @code
+ * I2CMiniPrefs store(MEM_TYPE_FRAM, 0x50, 256 * 1024, 4096, 32, 64);
+ * I2CPreferences prefs(store);      // was: Preferences prefs;
+ *
+ * prefs.begin("counters", false);
+ * prefs.putUInt("boots", prefs.getUInt("boots", 0) + 1);
+ * prefs.end();
+ * @endcode
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#pragma once
+#include "I2CMiniPrefs.h"
+
+/**
+ * @def PREFS_NAMESPACE_SEPARATOR
+ * @brief Character between namespace and key in the stored key
+ */
+#ifndef PREFS_NAMESPACE_SEPARATOR
+#define PREFS_NAMESPACE_SEPARATOR '/'
+#endif
+
+/**
+ * @class I2CPreferences
+ * @brief Preferences API over one namespace of an I2CMiniPrefs store
+ *
+ * Keys are stored as "<namespace>/<key>", so several instances can share
+ * one store and the store's maxKeyLen must cover namespace, separator and
+ * key (NVS allows 15 + 1 + 15). Put methods return the number of bytes
+ * stored (0 on error) and get methods the default value for a missing
+ * key, as Preferences does. Values keep their I2CMiniPrefs type tag:
+ * getInt() does not read a value stored with putLong().
+ */
+class I2CPreferences {
+public:
+    /**
+     * @brief Bind a store
+     * @param store Backing store (shared by any number of instances)
+     */
+    explicit I2CPreferences(I2CMiniPrefs& store);
+
+    /**
+     * @brief Open a namespace
+     * @param name Namespace, at most maxKeyLen - 2 characters
+     * @param readOnly true to reject all writes
+     * @param partition_label Ignored, for source compatibility
+     * @return false if a namespace is already open or the store fails to begin
+     * @note Calls begin() on the store unless it is open already
+     */
+    bool begin(const char* name, bool readOnly = false, const char* partition_label = nullptr);
+
+    /**
+     * @brief Close the namespace (the store stays open)
+     */
+    void end();
+
+    /**
+     * @brief Delete every key of the namespace
+     */
+    bool clear();
+
+    /**
+     * @brief Delete one key
+     */
+    bool remove(const char* key);
+
+    /// @name Data Write Operations
+    ///@{
+    size_t putChar(const char* key, int8_t value);
+    size_t putUChar(const char* key, uint8_t value);
+    size_t putShort(const char* key, int16_t value);
+    size_t putUShort(const char* key, uint16_t value);
+    size_t putInt(const char* key, int32_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putLong(const char* key, int32_t value);
+    size_t putULong(const char* key, uint32_t value);
+    size_t putLong64(const char* key, int64_t value);
+    size_t putULong64(const char* key, uint64_t value);
+    size_t putFloat(const char* key, float value);
+    size_t putDouble(const char* key, double value);
+    size_t putBool(const char* key, bool value);
+    size_t putString(const char* key, const char* value);
+    size_t putString(const char* key, String value);
+    size_t putBytes(const char* key, const void* value, size_t len);
+    ///@}
+
+    /// @name Data Read Operations
+    ///@{
+    bool isKey(const char* key);
+    int8_t getChar(const char* key, int8_t defaultValue = 0);
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0);
+    int16_t getShort(const char* key, int16_t defaultValue = 0);
+    uint16_t getUShort(const char* key, uint16_t defaultValue = 0);
+    int32_t getInt(const char* key, int32_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    int32_t getLong(const char* key, int32_t defaultValue = 0);
+    uint32_t getULong(const char* key, uint32_t defaultValue = 0);
+    int64_t getLong64(const char* key, int64_t defaultValue = 0);
+    uint64_t getULong64(const char* key, uint64_t defaultValue = 0);
+    float getFloat(const char* key, float defaultValue = NAN);
+    double getDouble(const char* key, double defaultValue = NAN);
+    bool getBool(const char* key, bool defaultValue = false);
+
+    /**
+     * @brief Copy a string including its terminator
+     * @return Bytes copied, 0 if missing or longer than maxLen
+     */
+    size_t getString(const char* key, char* value, size_t maxLen);
+    String getString(const char* key, String defaultValue = String());
+
+    /**
+     * @brief Stored length of a putBytes() value, 0 if missing
+     */
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+
+    /**
+     * @brief Entries with an 8-byte value and a key of maxKeyLen that still fit
+     * @note NVS counts 32-byte slots; this is the closest equivalent
+     */
+    size_t freeEntries();
+    ///@}
+
+private:
+    I2CMiniPrefs& _store;        ///< Backing store
+    char* _prefix;               ///< "<namespace>/" (nullptr while closed)
+    size_t _prefixLen;           ///< Length of _prefix
+    bool _readOnly;              ///< Writes are rejected
+
+    bool _fullKey(const char* key, char* out, size_t size) const;
+    bool _writable() const { return _prefix && !_readOnly; }
+
+    template<typename T>
+    size_t _put(const char* key, T value, bool (I2CMiniPrefs::*put)(const char*, T));
+
+    template<typename T>
+    T _get(const char* key, T defaultValue, T (I2CMiniPrefs::*get)(const char*, T));
+};
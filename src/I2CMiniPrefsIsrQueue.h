@@ -0,0 +1,151 @@
+/**
+ * @file I2CMiniPrefsIsrQueue.h
+ * @brief Lock-free ring for recording put requests from interrupt handlers
+ *
+ * An ISR enqueues fixed-size records in constant time; a task or loop()
+ * later writes them to the store in one batch:
+ * @code
+ * PrefsIsrQueue<16> faultQueue;
+ *
+ * void IRAM_ATTR onFault() {
+ *     faultQueue.push("lastFault", (uint16_t)readFaultCode());
+ * }
+ *
+ * void loop() {
+ *     faultQueue.drainInto(myPrefs);
+ * }
+ * @endcode
+ *
+ * Single producer, single consumer: only one interrupt (or otherwise
+ * serialized context) may call push(), and only one task may drain.
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#pragma once
+#include "I2CMiniPrefs.h"
+
+#if defined(ESP32)
+#define PREFS_ISR_ATTR IRAM_ATTR
+#define PREFS_MEMORY_BARRIER() __sync_synchronize()
+#else
+#define PREFS_ISR_ATTR
+#define PREFS_MEMORY_BARRIER() __asm__ __volatile__("" ::: "memory")
+#endif
+
+/**
+ * @struct PrefsIsrRecord
+ * @brief One queued put (key by reference, value by copy)
+ */
+struct PrefsIsrRecord {
+    const char* key;         ///< Key with static storage duration
+    uint8_t dataType;        ///< PrefDataType value
+    uint8_t valueLength;     ///< Valid bytes in value
+    byte value[8];           ///< Value bytes
+};
+
+/**
+ * @class PrefsIsrQueue
+ * @brief SPSC ring of put records
+ * @tparam N Capacity, a power of two up to 128
+ */
+template<uint8_t N>
+class PrefsIsrQueue {
+    static_assert(N > 0 && N <= 128 && (N & (N - 1)) == 0, "N must be a power of two <= 128");
+
+public:
+    PrefsIsrQueue() : _head(0), _tail(0), _overflows(0), _writeErrors(0) {}
+
+    /**
+     * @brief Enqueue a put; constant time, safe in interrupt context
+     * @param key Key with static storage duration (string literal)
+     * @param type Stored data type
+     * @param value Value bytes
+     * @param len Value length (at most 8)
+     * @return false if the ring is full (counted in overflows())
+     */
+    bool PREFS_ISR_ATTR push(const char* key, PrefDataType type, const void* value, uint8_t len) {
+        uint8_t head = _head;
+        if ((uint8_t)(head - _tail) >= N || len > sizeof(((PrefsIsrRecord*)0)->value)) {
+            _overflows = _overflows + 1;
+            return false;
+        }
+        PrefsIsrRecord& rec = _ring[head & (N - 1)];
+        rec.key = key;
+        rec.dataType = type;
+        rec.valueLength = len;
+        for (uint8_t i = 0; i < len; i++) rec.value[i] = ((const byte*)value)[i];
+
+        // Record must be visible before the consumer sees the new head
+        PREFS_MEMORY_BARRIER();
+        _head = head + 1;
+        return true;
+    }
+
+    /**
+     * @brief Enqueue a typed put; constant time, safe in interrupt context
+     */
+    template<typename T>
+    bool PREFS_ISR_ATTR push(const char* key, const T& value) {
+        static_assert(sizeof(T) <= sizeof(((PrefsIsrRecord*)0)->value), "value too large");
+        return push(key, PrefTypeTraits<T>::type, &value, sizeof(T));
+    }
+
+    /**
+     * @brief Write queued records to the store (task context)
+     * @param prefs Destination store
+     * @param maxRecords Upper bound on records consumed in this call
+     * @return Number of records consumed
+     *
+     * Within one batch only the newest record per key is written, so a
+     * burst of updates to the same key costs a single store write.
+     */
+    uint8_t drainInto(I2CMiniPrefs& prefs, uint8_t maxRecords = N) {
+        uint8_t tail = _tail;
+        uint8_t head = _head;
+        PREFS_MEMORY_BARRIER();
+        uint8_t available = head - tail;
+        if (available > maxRecords) available = maxRecords;
+
+        for (uint8_t i = 0; i < available; i++) {
+            const PrefsIsrRecord& rec = _ring[(uint8_t)(tail + i) & (N - 1)];
+            bool superseded = false;
+            for (uint8_t j = i + 1; j < available && !superseded; j++) {
+                superseded = _ring[(uint8_t)(tail + j) & (N - 1)].key == rec.key;
+            }
+            if (!superseded && !prefs.putTyped(rec.key, (PrefDataType)rec.dataType,
+                                               rec.value, rec.valueLength)) {
+                _writeErrors++;
+            }
+        }
+
+        // Release the slots only after the records have been read
+        PREFS_MEMORY_BARRIER();
+        _tail = tail + available;
+        return available;
+    }
+
+    /**
+     * @brief Number of queued records
+     */
+    uint8_t size() const { return (uint8_t)(_head - _tail); }
+
+    /**
+     * @brief Records rejected because the ring was full (since construction)
+     */
+    uint32_t overflows() const { return _overflows; }
+
+    /**
+     * @brief Records the store refused to write (since construction)
+     */
+    uint32_t writeErrors() const { return _writeErrors; }
+
+private:
+    PrefsIsrRecord _ring[N];
+    volatile uint8_t _head;      ///< Written by the producer only
+    volatile uint8_t _tail;      ///< Written by the consumer only
+    volatile uint32_t _overflows; ///< Written by the producer only
+    uint32_t _writeErrors;       ///< Written by the consumer only
+};
@@ -0,0 +1,82 @@
+/**
+ * @file I2CMiniPrefsMergeSink.h
+ * @brief Stream that applies an exportTo() snapshot to another store
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#pragma once
+#include "I2CMiniPrefs.h"
+
+/**
+ * @class PrefsMergeSink
+ * @brief Applies an exportTo() stream to another store, entry by entry
+ *
+ * Parses the export format (magic, version, records, terminator) and
+ * puts each record into the target as soon as it is complete, so no
+ * more than one record is held in RAM.
+ */
+class PrefsMergeSink : public Stream {
+public:
+    PrefsMergeSink(I2CMiniPrefs& target, size_t maxRecord)
+        : _target(target),
+          _record(new byte[maxRecord]),
+          _maxRecord(maxRecord),
+          _pos(0),
+          _skip(5),
+          _done(false),
+          _failed(false) {}
+
+    ~PrefsMergeSink() { delete[] _record; }
+
+    size_t write(uint8_t b) override {
+        if (_done || _failed) return 1;
+        if (_skip > 0) {         // Export header
+            _skip--;
+            return 1;
+        }
+        if (_pos == 0 && b == 0x00) {  // Terminator
+            _done = true;
+            return 1;
+        }
+        if (_pos >= _maxRecord) {
+            _failed = true;
+            return 1;
+        }
+        _record[_pos++] = b;
+
+        // Record: type, key length, value length (LE16), key, value
+        if (_pos >= 4) {
+            uint8_t keyLen = _record[1];
+            uint16_t valueLen = _record[2] | (_record[3] << 8);
+            if (_pos == (size_t)4 + keyLen + valueLen) {
+                char key[256];   // keyLength is a uint8_t
+                memcpy(key, _record + 4, keyLen);
+                key[keyLen] = '\0';
+                if (!_target.putTyped(key, (PrefDataType)_record[0], _record + 4 + keyLen, valueLen)) {
+                    _failed = true;
+                }
+                _pos = 0;
+            }
+        }
+        return 1;
+    }
+
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+    /// Whether every record reached the target
+    bool ok() const { return _done && !_failed; }
+
+private:
+    I2CMiniPrefs& _target;
+    byte* _record;
+    size_t _maxRecord;
+    size_t _pos;
+    uint8_t _skip;
+    bool _done;
+    bool _failed;
+};
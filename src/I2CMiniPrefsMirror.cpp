@@ -0,0 +1,482 @@
+/**
+ * @file I2CMiniPrefsMirror.cpp
+ * @brief Implementation of the two-chip mirror
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#include "I2CMiniPrefsMirror.h"
+#include "I2CMiniPrefsMergeSink.h"
+
+/**
+ * @brief Bus errors of a store so far
+ *
+ * A failed operation that raised this count failed on the chip itself;
+ * one that did not (a full store) would fail on the other chip alike.
+ */
+static uint32_t busErrors(I2CMiniPrefs& prefs) {
+    PrefsErrorStats errors;
+    prefs.getErrorStats(errors);
+    return errors.addressNacks + errors.dataNacks + errors.busErrors +
+           errors.verifyErrors + errors.readErrors;
+}
+
+I2CMiniPrefsMirror::I2CMiniPrefsMirror(I2CMiniPrefs& first, I2CMiniPrefs& second)
+    : _stores{&first, &second},
+      _online{false, false},
+      _nextRead(0),
+      _stats(),
+      _recordSize(first.maxValueLength()),
+      _repairPending(false),
+      _repairTarget(0),
+      _repairType(TYPE_NONE),
+      _repairLen(0),
+      _repairKey(new char[first.maxKeyLength() + 1]),
+      _repairValue(new byte[first.maxValueLength()])
+{
+#if PREFS_THREAD_SAFE
+    _mutex = xSemaphoreCreateMutex();
+#endif
+}
+
+I2CMiniPrefsMirror::~I2CMiniPrefsMirror() {
+    delete[] _repairKey;
+    delete[] _repairValue;
+#if PREFS_THREAD_SAFE
+    vSemaphoreDelete(_mutex);
+#endif
+}
+
+// Locking --------------------------------------------------------------------
+
+void I2CMiniPrefsMirror::_lock() {
+#if PREFS_THREAD_SAFE
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+#endif
+}
+
+void I2CMiniPrefsMirror::_unlock() {
+#if PREFS_THREAD_SAFE
+    xSemaphoreGive(_mutex);
+#endif
+}
+
+// Core Management ------------------------------------------------------------
+
+bool I2CMiniPrefsMirror::begin() {
+    _lock();
+    bool started[2];
+    for (uint8_t i = 0; i < 2; i++) started[i] = _online[i] = _stores[i]->begin();
+
+    // A chip that missed writes stays offline until resync()
+    for (uint8_t i = 0; i < 2; i++) {
+        if (!_online[i]) continue;
+        uint8_t stale = _stores[i]->getUChar(PREFS_MIRROR_STALE_KEY, 0xFF);
+        if (stale < 2 && stale != i) _online[stale] = false;
+    }
+
+    // So does one that failed to start, since its peer now takes the
+    // writes alone; the peer remembers it once
+    for (uint8_t i = 0; i < 2; i++) {
+        if (started[i] || !_online[1 - i]) continue;
+        if (_stores[1 - i]->getUChar(PREFS_MIRROR_STALE_KEY, 0xFF) != i) _takeOffline(i);
+    }
+    bool ok = _online[0] || _online[1];
+    _unlock();
+    return ok;
+}
+
+bool I2CMiniPrefsMirror::poll() {
+    _lock();
+    if (_repairPending && _online[_repairTarget] &&
+        !_stores[_repairTarget]->writeCycleActive()) {
+        I2CMiniPrefs& target = *_stores[_repairTarget];
+        uint32_t errorsBefore = busErrors(target);
+        if (target.putTyped(_repairKey, _repairType, _repairValue, _repairLen)) {
+            _stats.repairs++;
+        } else if (busErrors(target) != errorsBefore) {
+            _takeOffline(_repairTarget);
+        }
+        _repairPending = false;
+    }
+    bool pending = _repairPending;
+    _unlock();
+    return pending;
+}
+
+/**
+ * @brief Rebuild offline chips from the online one
+ *
+ * The chip is cleared and every entry of the good chip is copied over
+ * with one record of RAM, the same way I2CMiniPrefsTiered merges.
+ */
+bool I2CMiniPrefsMirror::resync() {
+    _lock();
+    bool ok = true;
+    for (uint8_t i = 0; i < 2; i++) {
+        if (_online[i]) continue;
+        I2CMiniPrefs& target = *_stores[i];
+        I2CMiniPrefs& good = *_stores[1 - i];
+        if (!_online[1 - i]) {
+            ok = false;
+            continue;
+        }
+        PrefsMergeSink sink(target, 4 + target.maxKeyLength() + target.maxValueLength());
+        if (!target.begin() || !target.clear() || good.exportTo(sink) == 0 || !sink.ok()) {
+            ok = false;
+            continue;
+        }
+        target.remove(PREFS_MIRROR_STALE_KEY);   // Copied along with the data
+        good.remove(PREFS_MIRROR_STALE_KEY);
+        _online[i] = true;
+    }
+    _unlock();
+    return ok;
+}
+
+/**
+ * @brief Stop using a chip after a failed write
+ * @param index Chip whose copy is now out of date
+ */
+void I2CMiniPrefsMirror::_takeOffline(uint8_t index) {
+    _online[index] = false;
+    _stats.offlineEvents++;
+    if (_repairPending && _repairTarget == index) _repairPending = false;
+    if (_online[1 - index]) _stores[1 - index]->putUChar(PREFS_MIRROR_STALE_KEY, index);
+}
+
+// Integrity ------------------------------------------------------------------
+
+/**
+ * @brief CRC8 (polynomial 0x07) over type, key and value
+ *
+ * Including key and type catches entries whose header was corrupted into
+ * another valid-looking entry, not only flipped value bits.
+ */
+uint8_t I2CMiniPrefsMirror::_crc(const char* key, PrefDataType type, const byte* value, size_t len) {
+    uint8_t crc = 0x00;
+    auto feed = [&crc](byte data) {
+        crc ^= data;
+        for (uint8_t j = 0; j < 8; j++) {
+            if ((crc & 0x80) != 0) crc = (uint8_t)((crc << 1) ^ 0x07);
+            else crc <<= 1;
+        }
+    };
+    feed((byte)type);
+    while (*key) feed((byte)*key++);
+    for (size_t i = 0; i < len; i++) feed(value[i]);
+    return crc;
+}
+
+/**
+ * @brief Chip to read first
+ *
+ * A chip in its EEPROM write cycle would NACK until the cycle ends, so the
+ * other chip answers instead. With both idle the chips alternate, which
+ * spreads reads over both buses.
+ */
+uint8_t I2CMiniPrefsMirror::_pickReader() {
+    if (!_online[1]) return 0;
+    if (!_online[0]) return 1;
+    bool busy0 = _stores[0]->writeCycleActive();
+    bool busy1 = _stores[1]->writeCycleActive();
+    if (busy0 != busy1) return busy0 ? 1 : 0;
+    _nextRead ^= 1;
+    return _nextRead;
+}
+
+/**
+ * @brief Queue a rewrite of a bad copy for poll()
+ * @param target Chip holding the missing or corrupt copy
+ * @param record Good copy incl. CRC byte
+ * @param len Length of record
+ *
+ * Only one repair is held; further bad copies are found again by later
+ * reads.
+ */
+void I2CMiniPrefsMirror::_queueRepair(uint8_t target, const char* key, PrefDataType type,
+                                      const byte* record, size_t len) {
+    if (_repairPending || !_online[target]) return;
+    strcpy(_repairKey, key);
+    memcpy(_repairValue, record, len);
+    _repairTarget = target;
+    _repairType = type;
+    _repairLen = len;
+    _repairPending = true;
+}
+
+/**
+ * @brief Drop a queued repair of key; the write in progress supersedes it
+ */
+void I2CMiniPrefsMirror::_cancelRepair(const char* key) {
+    if (_repairPending && strcmp(_repairKey, key) == 0) _repairPending = false;
+}
+
+// Write Operations -----------------------------------------------------------
+
+/**
+ * @brief Store value plus CRC byte on every online chip
+ * @return true if at least one chip holds the new value
+ *
+ * A chip that fails the write (NACK, bus error) is taken offline. So is
+ * one that refuses a value its peer took: repairs and the stale marker
+ * fill the chips unevenly, and its old copy would still pass the CRC.
+ * Only when both refuse does the put just fail.
+ */
+bool I2CMiniPrefsMirror::_put(const char* key, PrefDataType type, const void* buf, size_t len) {
+    if (!key || len + 1 > _recordSize) return false;
+    byte record[len + 1];
+    memcpy(record, buf, len);
+    record[len] = _crc(key, type, record, len);
+
+    _lock();
+    _cancelRepair(key);
+    bool stored = false;
+    bool refused[2] = {false, false};
+    for (uint8_t i = 0; i < 2; i++) {
+        if (!_online[i]) continue;
+        uint32_t errorsBefore = busErrors(*_stores[i]);
+        if (_stores[i]->putTyped(key, type, record, len + 1)) {
+            stored = true;
+        } else if (busErrors(*_stores[i]) != errorsBefore) {
+            _takeOffline(i);
+        } else {
+            refused[i] = true;
+        }
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+        if (refused[i] && stored) _takeOffline(i);
+    }
+    _unlock();
+    return stored;
+}
+
+bool I2CMiniPrefsMirror::putBool(const char* key, bool value) {
+    return _put(key, TYPE_BOOL, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsMirror::putChar(const char* key, char value) {
+    return _put(key, TYPE_CHAR, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsMirror::putUChar(const char* key, unsigned char value) {
+    return _put(key, TYPE_UCHAR, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsMirror::putShort(const char* key, short value) {
+    return _put(key, TYPE_SHORT, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsMirror::putUShort(const char* key, unsigned short value) {
+    return _put(key, TYPE_USHORT, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsMirror::putInt(const char* key, int value) {
+    return _put(key, TYPE_INT, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsMirror::putUInt(const char* key, unsigned int value) {
+    return _put(key, TYPE_UINT, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsMirror::putLong(const char* key, long value) {
+    return _put(key, TYPE_LONG, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsMirror::putULong(const char* key, unsigned long value) {
+    return _put(key, TYPE_ULONG, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsMirror::putLong64(const char* key, long long value) {
+    return _put(key, TYPE_LONG64, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsMirror::putULong64(const char* key, unsigned long long value) {
+    return _put(key, TYPE_ULONG64, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsMirror::putFloat(const char* key, float value) {
+    return _put(key, TYPE_FLOAT, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsMirror::putDouble(const char* key, double value) {
+    return _put(key, TYPE_DOUBLE, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsMirror::putString(const char* key, const char* value) {
+    if (!value) return false;
+    return _put(key, TYPE_STRING, value, strlen(value) + 1);
+}
+
+bool I2CMiniPrefsMirror::putString(const char* key, const String& value) {
+    return putString(key, value.c_str());
+}
+
+bool I2CMiniPrefsMirror::putBytes(const char* key, const void* buf, size_t len) {
+    if (!buf && len > 0) return false;
+    return _put(key, TYPE_BYTES, buf, len);
+}
+
+// Read Operations ------------------------------------------------------------
+
+/**
+ * @brief Read the first copy that passes its CRC
+ * @param buf Receives value plus CRC byte
+ * @param maxLen Size of buf
+ * @return Stored length incl. CRC byte, 0 if no valid copy exists
+ */
+size_t I2CMiniPrefsMirror::_get(const char* key, PrefDataType type, byte* buf, size_t maxLen) {
+    uint8_t first = _pickReader();
+    int8_t missed = -1;
+    for (uint8_t attempt = 0; attempt < 2; attempt++) {
+        uint8_t i = attempt ? 1 - first : first;
+        if (!_online[i]) continue;
+        _stats.reads[i]++;
+        size_t n = _stores[i]->getTyped(key, type, buf, maxLen);
+        if (n > 0 && buf[n - 1] == _crc(key, type, buf, n - 1)) {
+            if (missed >= 0) {
+                _stats.fallbacks++;
+                _queueRepair(missed, key, type, buf, n);
+            }
+            return n;
+        }
+        if (n > 0) _stats.crcErrors++;
+        missed = i;
+    }
+    return 0;
+}
+
+template<typename T>
+T I2CMiniPrefsMirror::_getValue(const char* key, T defaultValue, PrefDataType type) {
+    byte record[sizeof(T) + 1];
+    _lock();
+    size_t n = _get(key, type, record, sizeof(record));
+    _unlock();
+    if (n != sizeof(record)) return defaultValue;
+    T value;
+    memcpy(&value, record, sizeof(T));
+    return value;
+}
+
+bool I2CMiniPrefsMirror::getBool(const char* key, bool defaultValue) {
+    return _getValue(key, defaultValue, TYPE_BOOL);
+}
+
+char I2CMiniPrefsMirror::getChar(const char* key, char defaultValue) {
+    return _getValue(key, defaultValue, TYPE_CHAR);
+}
+
+unsigned char I2CMiniPrefsMirror::getUChar(const char* key, unsigned char defaultValue) {
+    return _getValue(key, defaultValue, TYPE_UCHAR);
+}
+
+short I2CMiniPrefsMirror::getShort(const char* key, short defaultValue) {
+    return _getValue(key, defaultValue, TYPE_SHORT);
+}
+
+unsigned short I2CMiniPrefsMirror::getUShort(const char* key, unsigned short defaultValue) {
+    return _getValue(key, defaultValue, TYPE_USHORT);
+}
+
+int I2CMiniPrefsMirror::getInt(const char* key, int defaultValue) {
+    return _getValue(key, defaultValue, TYPE_INT);
+}
+
+unsigned int I2CMiniPrefsMirror::getUInt(const char* key, unsigned int defaultValue) {
+    return _getValue(key, defaultValue, TYPE_UINT);
+}
+
+long I2CMiniPrefsMirror::getLong(const char* key, long defaultValue) {
+    return _getValue(key, defaultValue, TYPE_LONG);
+}
+
+unsigned long I2CMiniPrefsMirror::getULong(const char* key, unsigned long defaultValue) {
+    return _getValue(key, defaultValue, TYPE_ULONG);
+}
+
+long long I2CMiniPrefsMirror::getLong64(const char* key, long long defaultValue) {
+    return _getValue(key, defaultValue, TYPE_LONG64);
+}
+
+unsigned long long I2CMiniPrefsMirror::getULong64(const char* key, unsigned long long defaultValue) {
+    return _getValue(key, defaultValue, TYPE_ULONG64);
+}
+
+float I2CMiniPrefsMirror::getFloat(const char* key, float defaultValue) {
+    return _getValue(key, defaultValue, TYPE_FLOAT);
+}
+
+double I2CMiniPrefsMirror::getDouble(const char* key, double defaultValue) {
+    return _getValue(key, defaultValue, TYPE_DOUBLE);
+}
+
+String I2CMiniPrefsMirror::getString(const char* key, const char* defaultValue) {
+    byte record[_recordSize];
+    _lock();
+    size_t n = _get(key, TYPE_STRING, record, _recordSize);
+    _unlock();
+    if (n < 2) return String(defaultValue);
+    record[n - 1] = '\0';    // CRC byte
+    return String((const char*)record);
+}
+
+size_t I2CMiniPrefsMirror::getBytes(const char* key, void* buf, size_t maxLen) {
+    if (!buf) return 0;
+    byte record[_recordSize];
+    _lock();
+    size_t n = _get(key, TYPE_BYTES, record, _recordSize);
+    _unlock();
+    if (n == 0) return 0;
+    size_t len = min(n - 1, maxLen);
+    memcpy(buf, record, len);
+    return len;
+}
+
+// Utility Operations ---------------------------------------------------------
+
+bool I2CMiniPrefsMirror::isKey(const char* key) {
+    _lock();
+    uint8_t first = _pickReader();
+    bool found = (_online[first] && _stores[first]->isKey(key)) ||
+                 (_online[1 - first] && _stores[1 - first]->isKey(key));
+    _unlock();
+    return found;
+}
+
+bool I2CMiniPrefsMirror::remove(const char* key) {
+    _lock();
+    _cancelRepair(key);
+    bool found = false;
+    for (uint8_t i = 0; i < 2; i++) {
+        if (!_online[i]) continue;
+        uint32_t errorsBefore = busErrors(*_stores[i]);
+        if (_stores[i]->remove(key)) {
+            found = true;
+        } else if (busErrors(*_stores[i]) != errorsBefore) {
+            _takeOffline(i);
+        }
+    }
+    _unlock();
+    return found;
+}
+
+bool I2CMiniPrefsMirror::clear() {
+    _lock();
+    _repairPending = false;
+    bool ok = true;
+    for (uint8_t i = 0; i < 2; i++) {
+        if (!_online[i]) continue;
+        uint32_t errorsBefore = busErrors(*_stores[i]);
+        if (!_stores[i]->clear()) {
+            ok = false;
+            if (busErrors(*_stores[i]) != errorsBefore) _takeOffline(i);
+        } else if (!_online[1 - i]) {
+            // Keep remembering the out-of-date peer
+            _stores[i]->putUChar(PREFS_MIRROR_STALE_KEY, 1 - i);
+        }
+    }
+    _unlock();
+    return ok;
+}
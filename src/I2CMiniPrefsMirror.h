@@ -0,0 +1,198 @@
+/**
+ * @file I2CMiniPrefsMirror.h
+ * @brief Store mirrored on two chips, optionally on two I2C buses
+ *
+ * Every put goes to both chips; reads are served by whichever chip is not
+ * in an EEPROM write cycle and fall back to the other copy on a CRC error:
+ * @code
+ * I2CMiniPrefs a(MEM_TYPE_EEPROM, 0x50, 256 * 1024, 4096, 16, 64);
+ * I2CMiniPrefs b(MEM_TYPE_EEPROM, 0x50, 256 * 1024, 4096, 16, 64, 25, 26);
+ * I2CMiniPrefsMirror prefs(a, b);
+ *
+ * b.setWire(Wire1);             // second chip on the second controller
+ * prefs.begin();
+ * prefs.putInt("boots", prefs.getInt("boots") + 1);
+ * prefs.poll();                 // in loop(): background repairs
+ * @endcode
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#pragma once
+#include "I2CMiniPrefs.h"
+
+/**
+ * @def PREFS_MIRROR_STALE_KEY
+ * @brief Key a surviving chip uses to remember that its peer is out of date
+ */
+#ifndef PREFS_MIRROR_STALE_KEY
+#define PREFS_MIRROR_STALE_KEY ".mstale"
+#endif
+
+/**
+ * @struct PrefsMirrorStats
+ * @brief Counters of the mirror since construction
+ */
+struct PrefsMirrorStats {
+    uint32_t reads[2];       ///< Reads served by chip 0 / chip 1
+    uint32_t crcErrors;      ///< Copies rejected by their CRC
+    uint32_t fallbacks;      ///< Reads answered by the second choice
+    uint32_t repairs;        ///< Copies rewritten from the good chip
+    uint32_t offlineEvents;  ///< Chips taken offline after a failed write
+};
+
+/**
+ * @class I2CMiniPrefsMirror
+ * @brief Same put/get API as I2CMiniPrefs over two identical stores
+ *
+ * - every value is stored with a CRC8 over key, type and value (one extra
+ *   value byte, so maxValueLen must leave room for it)
+ * - put*() writes chip 0, then chip 1; the deferred EEPROM write cycle of
+ *   the first chip runs while the second one is written
+ * - get*() reads the idle chip (alternating when both are idle); a
+ *   missing or corrupt copy is answered from the other chip and queued
+ *   for repair by poll()
+ * - a chip whose write fails, that refuses a value its peer took, or
+ *   that fails begin() is taken offline; the other chip records this
+ *   under PREFS_MIRROR_STALE_KEY so it stays offline across reboots
+ *   until resync() has copied the good chip over it
+ *
+ * Both stores must use the same key and value limits.
+ */
+class I2CMiniPrefsMirror {
+public:
+    /**
+     * @brief Combine two stores
+     * @param first Chip 0
+     * @param second Chip 1 (same layout; may use another TwoWire)
+     */
+    I2CMiniPrefsMirror(I2CMiniPrefs& first, I2CMiniPrefs& second);
+    ~I2CMiniPrefsMirror();
+
+    /// @name Core Management
+    ///@{
+    /**
+     * @brief Initialize both chips
+     * @return true if at least one up-to-date copy is available
+     */
+    bool begin();
+
+    /**
+     * @brief Carry out a queued repair
+     * @return true while a repair is still queued
+     * @note Call it from loop(); it writes only when the chip is idle
+     */
+    bool poll();
+
+    /**
+     * @brief Copy the good chip over an offline one and bring it back
+     * @return true if both chips are online afterwards
+     */
+    bool resync();
+
+    /**
+     * @brief Whether a chip takes part in reads and writes
+     * @param index 0 or 1
+     */
+    bool online(uint8_t index) const { return index < 2 && _online[index]; }
+
+    /**
+     * @brief Copy the counters
+     */
+    void getStats(PrefsMirrorStats& stats) const { stats = _stats; }
+    ///@}
+
+    /// @name Data Write Operations
+    ///@{
+    bool putBool(const char* key, bool value);
+    bool putChar(const char* key, char value);
+    bool putUChar(const char* key, unsigned char value);
+    bool putShort(const char* key, short value);
+    bool putUShort(const char* key, unsigned short value);
+    bool putInt(const char* key, int value);
+    bool putUInt(const char* key, unsigned int value);
+    bool putLong(const char* key, long value);
+    bool putULong(const char* key, unsigned long value);
+    bool putLong64(const char* key, long long value);
+    bool putULong64(const char* key, unsigned long long value);
+    bool putFloat(const char* key, float value);
+    bool putDouble(const char* key, double value);
+    bool putString(const char* key, const char* value);
+    bool putString(const char* key, const String& value);
+    bool putBytes(const char* key, const void* buf, size_t len);
+    ///@}
+
+    /// @name Data Read Operations
+    ///@{
+    bool getBool(const char* key, bool defaultValue = false);
+    char getChar(const char* key, char defaultValue = 0);
+    unsigned char getUChar(const char* key, unsigned char defaultValue = 0);
+    short getShort(const char* key, short defaultValue = 0);
+    unsigned short getUShort(const char* key, unsigned short defaultValue = 0);
+    int getInt(const char* key, int defaultValue = 0);
+    unsigned int getUInt(const char* key, unsigned int defaultValue = 0);
+    long getLong(const char* key, long defaultValue = 0);
+    unsigned long getULong(const char* key, unsigned long defaultValue = 0);
+    long long getLong64(const char* key, long long defaultValue = 0);
+    unsigned long long getULong64(const char* key, unsigned long long defaultValue = 0);
+    float getFloat(const char* key, float defaultValue = 0.0f);
+    double getDouble(const char* key, double defaultValue = 0.0);
+    String getString(const char* key, const char* defaultValue = "");
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+    ///@}
+
+    /// @name Utility Operations
+    ///@{
+    /**
+     * @brief Check if key exists on an online chip
+     */
+    bool isKey(const char* key);
+
+    /**
+     * @brief Delete key from both chips
+     * @return true if the key was found
+     */
+    bool remove(const char* key);
+
+    /**
+     * @brief Clear both chips
+     * @return true if every online chip was cleared
+     */
+    bool clear();
+    ///@}
+
+private:
+    I2CMiniPrefs* _stores[2];    ///< Chip 0 and chip 1
+    bool _online[2];             ///< Chips taking part in reads and writes
+    uint8_t _nextRead;           ///< Chip preferred when both are idle
+    PrefsMirrorStats _stats;     ///< Counters
+    uint16_t _recordSize;        ///< Largest stored value incl. CRC byte
+
+    // Queued repair
+    bool _repairPending;         ///< A copy waits to be rewritten
+    uint8_t _repairTarget;       ///< Chip holding the bad copy
+    PrefDataType _repairType;    ///< Type tag of the good copy
+    uint16_t _repairLen;         ///< Stored length incl. CRC byte
+    char* _repairKey;            ///< Key of the bad copy
+    byte* _repairValue;          ///< Good copy incl. CRC byte
+#if PREFS_THREAD_SAFE
+    SemaphoreHandle_t _mutex;    ///< Serializes all operations
+#endif
+
+    static uint8_t _crc(const char* key, PrefDataType type, const byte* value, size_t len);
+    uint8_t _pickReader();
+    bool _put(const char* key, PrefDataType type, const void* buf, size_t len);
+    size_t _get(const char* key, PrefDataType type, byte* buf, size_t maxLen);
+    void _queueRepair(uint8_t target, const char* key, PrefDataType type,
+                      const byte* record, size_t len);
+    void _cancelRepair(const char* key);
+    void _takeOffline(uint8_t index);
+
+    template<typename T>
+    T _getValue(const char* key, T defaultValue, PrefDataType type);
+
+    void _lock();
+    void _unlock();
+};
@@ -0,0 +1,290 @@
+/**
+ * @file I2CMiniPrefsTiered.cpp
+ * @brief Implementation of the FRAM/EEPROM tiered store
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#include "I2CMiniPrefsTiered.h"
+#include "I2CMiniPrefsMergeSink.h"
+
+I2CMiniPrefsTiered::I2CMiniPrefsTiered(I2CMiniPrefs& fast, I2CMiniPrefs& slow)
+    : _fast(fast),
+      _slow(slow),
+      _merges(0)
+{
+#if PREFS_THREAD_SAFE
+    _writeMutex = xSemaphoreCreateMutex();
+#endif
+}
+
+I2CMiniPrefsTiered::~I2CMiniPrefsTiered() {
+#if PREFS_THREAD_SAFE
+    vSemaphoreDelete(_writeMutex);
+#endif
+}
+
+// Locking --------------------------------------------------------------------
+
+void I2CMiniPrefsTiered::_lock() {
+#if PREFS_THREAD_SAFE
+    xSemaphoreTake(_writeMutex, portMAX_DELAY);
+#endif
+}
+
+void I2CMiniPrefsTiered::_unlock() {
+#if PREFS_THREAD_SAFE
+    xSemaphoreGive(_writeMutex);
+#endif
+}
+
+// Core Management ------------------------------------------------------------
+
+bool I2CMiniPrefsTiered::begin() {
+    // Entries left on the FRAM tier stay there and keep shadowing the
+    // EEPROM tier until the next merge
+    return _fast.begin() && _slow.begin();
+}
+
+bool I2CMiniPrefsTiered::merge() {
+    _lock();
+    bool ok = _merge();
+    _unlock();
+    return ok;
+}
+
+/**
+ * @brief Copy the FRAM tier into the EEPROM tier, then clear it
+ * @return true on success; on failure the FRAM tier is left intact
+ *
+ * The EEPROM engine appends the entries one after another, so each is
+ * written in one or two page bursts. Re-applying entries after a cut
+ * merge is harmless: the last value of every key wins either way.
+ */
+bool I2CMiniPrefsTiered::_merge() {
+    PrefsMergeSink sink(_slow, 4 + _fast.maxKeyLength() + _fast.maxValueLength());
+    if (_fast.exportTo(sink) == 0 || !sink.ok()) return false;
+    if (!_fast.clear()) return false;
+    _merges++;
+    return true;
+}
+
+// Write Operations -----------------------------------------------------------
+
+/**
+ * @brief Write to the FRAM tier, merging once if it is full
+ */
+bool I2CMiniPrefsTiered::_put(const char* key, PrefDataType type, const void* buf, size_t len) {
+    _lock();
+    bool ok = _fast.putTyped(key, type, buf, len);
+    if (!ok && _merge()) ok = _fast.putTyped(key, type, buf, len);
+    _unlock();
+    return ok;
+}
+
+bool I2CMiniPrefsTiered::putBool(const char* key, bool value) {
+    return _put(key, TYPE_BOOL, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsTiered::putChar(const char* key, char value) {
+    return _put(key, TYPE_CHAR, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsTiered::putUChar(const char* key, unsigned char value) {
+    return _put(key, TYPE_UCHAR, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsTiered::putShort(const char* key, short value) {
+    return _put(key, TYPE_SHORT, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsTiered::putUShort(const char* key, unsigned short value) {
+    return _put(key, TYPE_USHORT, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsTiered::putInt(const char* key, int value) {
+    return _put(key, TYPE_INT, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsTiered::putUInt(const char* key, unsigned int value) {
+    return _put(key, TYPE_UINT, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsTiered::putLong(const char* key, long value) {
+    return _put(key, TYPE_LONG, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsTiered::putULong(const char* key, unsigned long value) {
+    return _put(key, TYPE_ULONG, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsTiered::putLong64(const char* key, long long value) {
+    return _put(key, TYPE_LONG64, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsTiered::putULong64(const char* key, unsigned long long value) {
+    return _put(key, TYPE_ULONG64, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsTiered::putFloat(const char* key, float value) {
+    return _put(key, TYPE_FLOAT, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsTiered::putDouble(const char* key, double value) {
+    return _put(key, TYPE_DOUBLE, &value, sizeof(value));
+}
+
+bool I2CMiniPrefsTiered::putString(const char* key, const char* value) {
+    if (!value) return false;
+    return _put(key, TYPE_STRING, value, strlen(value) + 1);
+}
+
+bool I2CMiniPrefsTiered::putString(const char* key, const String& value) {
+    return putString(key, value.c_str());
+}
+
+bool I2CMiniPrefsTiered::putBytes(const char* key, const void* buf, size_t len) {
+    if (!buf && len > 0) return false;
+    return _put(key, TYPE_BYTES, buf, len);
+}
+
+bool I2CMiniPrefsTiered::putTyped(const char* key, PrefDataType type, const void* buf, size_t len) {
+    if (type == TYPE_NONE || (!buf && len > 0)) return false;
+    return _put(key, type, buf, len);
+}
+
+// Read Operations ------------------------------------------------------------
+// Under the lock: a merge() between _tierOf() and the read would clear
+// the FRAM tier and turn a buffered key into the default value.
+
+bool I2CMiniPrefsTiered::getBool(const char* key, bool defaultValue) {
+    _lock();
+    bool value = _tierOf(key).getBool(key, defaultValue);
+    _unlock();
+    return value;
+}
+
+char I2CMiniPrefsTiered::getChar(const char* key, char defaultValue) {
+    _lock();
+    char value = _tierOf(key).getChar(key, defaultValue);
+    _unlock();
+    return value;
+}
+
+unsigned char I2CMiniPrefsTiered::getUChar(const char* key, unsigned char defaultValue) {
+    _lock();
+    unsigned char value = _tierOf(key).getUChar(key, defaultValue);
+    _unlock();
+    return value;
+}
+
+short I2CMiniPrefsTiered::getShort(const char* key, short defaultValue) {
+    _lock();
+    short value = _tierOf(key).getShort(key, defaultValue);
+    _unlock();
+    return value;
+}
+
+unsigned short I2CMiniPrefsTiered::getUShort(const char* key, unsigned short defaultValue) {
+    _lock();
+    unsigned short value = _tierOf(key).getUShort(key, defaultValue);
+    _unlock();
+    return value;
+}
+
+int I2CMiniPrefsTiered::getInt(const char* key, int defaultValue) {
+    _lock();
+    int value = _tierOf(key).getInt(key, defaultValue);
+    _unlock();
+    return value;
+}
+
+unsigned int I2CMiniPrefsTiered::getUInt(const char* key, unsigned int defaultValue) {
+    _lock();
+    unsigned int value = _tierOf(key).getUInt(key, defaultValue);
+    _unlock();
+    return value;
+}
+
+long I2CMiniPrefsTiered::getLong(const char* key, long defaultValue) {
+    _lock();
+    long value = _tierOf(key).getLong(key, defaultValue);
+    _unlock();
+    return value;
+}
+
+unsigned long I2CMiniPrefsTiered::getULong(const char* key, unsigned long defaultValue) {
+    _lock();
+    unsigned long value = _tierOf(key).getULong(key, defaultValue);
+    _unlock();
+    return value;
+}
+
+long long I2CMiniPrefsTiered::getLong64(const char* key, long long defaultValue) {
+    _lock();
+    long long value = _tierOf(key).getLong64(key, defaultValue);
+    _unlock();
+    return value;
+}
+
+unsigned long long I2CMiniPrefsTiered::getULong64(const char* key, unsigned long long defaultValue) {
+    _lock();
+    unsigned long long value = _tierOf(key).getULong64(key, defaultValue);
+    _unlock();
+    return value;
+}
+
+float I2CMiniPrefsTiered::getFloat(const char* key, float defaultValue) {
+    _lock();
+    float value = _tierOf(key).getFloat(key, defaultValue);
+    _unlock();
+    return value;
+}
+
+double I2CMiniPrefsTiered::getDouble(const char* key, double defaultValue) {
+    _lock();
+    double value = _tierOf(key).getDouble(key, defaultValue);
+    _unlock();
+    return value;
+}
+
+String I2CMiniPrefsTiered::getString(const char* key, const char* defaultValue) {
+    _lock();
+    String value = _tierOf(key).getString(key, defaultValue);
+    _unlock();
+    return value;
+}
+
+size_t I2CMiniPrefsTiered::getBytes(const char* key, void* buf, size_t maxLen) {
+    _lock();
+    size_t value = _tierOf(key).getBytes(key, buf, maxLen);
+    _unlock();
+    return value;
+}
+
+// Utility Operations ---------------------------------------------------------
+
+bool I2CMiniPrefsTiered::isKey(const char* key) {
+    _lock();
+    bool found = _fast.isKey(key) || _slow.isKey(key);
+    _unlock();
+    return found;
+}
+
+bool I2CMiniPrefsTiered::remove(const char* key) {
+    _lock();
+    // EEPROM first: a cut in between leaves the newer FRAM value visible
+    bool removedSlow = _slow.remove(key);
+    bool removedFast = _fast.remove(key);
+    _unlock();
+    return removedSlow || removedFast;
+}
+
+bool I2CMiniPrefsTiered::clear() {
+    _lock();
+    bool ok = _slow.clear() && _fast.clear();
+    _unlock();
+    return ok;
+}
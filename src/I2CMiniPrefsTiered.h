@@ -0,0 +1,150 @@
+/**
+ * @file I2CMiniPrefsTiered.h
+ * @brief Small FRAM store as write buffer in front of a large EEPROM store
+ *
+ * All puts land on the FRAM tier at FRAM speed and endurance. merge()
+ * moves them to the EEPROM tier in one sequential pass; it also runs
+ * automatically when the FRAM tier is full:
+ * @code
+ * I2CMiniPrefs fram(MEM_TYPE_FRAM, 0x50, 64 * 1024, 2048, 16, 64);
+ * I2CMiniPrefs eeprom(MEM_TYPE_EEPROM, 0x51, 512 * 1024, 8192, 16, 64);
+ * I2CMiniPrefsTiered prefs(fram, eeprom);
+ *
+ * prefs.begin();
+ * prefs.putInt("boots", prefs.getInt("boots") + 1);
+ * @endcode
+ *
+ * @author Thomas Walloschke mailto:artkeller@gmx.de
+ * @date 2025-06-21
+ * @version 1.0.0
+ */
+
+#pragma once
+#include "I2CMiniPrefs.h"
+
+/**
+ * @class I2CMiniPrefsTiered
+ * @brief Same put/get API as I2CMiniPrefs over a FRAM and an EEPROM tier
+ *
+ * - put*() writes the FRAM tier only
+ * - get*() reads the FRAM tier first and falls back to the EEPROM tier
+ * - remove() deletes the key from both tiers (costs one EEPROM write
+ *   cycle if the key had been merged)
+ * - merge() copies every FRAM entry to the EEPROM tier, then clears the
+ *   FRAM tier; a merge cut short by power loss is repeated by the next
+ *
+ * Both stores must use the same key and value limits.
+ */
+class I2CMiniPrefsTiered {
+public:
+    /**
+     * @brief Combine two stores
+     * @param fast Write buffer (FRAM)
+     * @param slow Capacity tier (EEPROM)
+     */
+    I2CMiniPrefsTiered(I2CMiniPrefs& fast, I2CMiniPrefs& slow);
+    ~I2CMiniPrefsTiered();
+
+    /// @name Core Management
+    ///@{
+    /**
+     * @brief Initialize both tiers
+     * @return true if both stores are ready
+     */
+    bool begin();
+
+    /**
+     * @brief Move all buffered entries to the EEPROM tier
+     * @return true if the FRAM tier is empty afterwards
+     * @note Call it periodically (idle time, before a planned shutdown)
+     *       to keep the FRAM tier from filling up during a burst of puts
+     */
+    bool merge();
+
+    /**
+     * @brief Number of merges performed since construction
+     */
+    uint32_t merges() const { return _merges; }
+    ///@}
+
+    /// @name Data Write Operations
+    ///@{
+    bool putBool(const char* key, bool value);
+    bool putChar(const char* key, char value);
+    bool putUChar(const char* key, unsigned char value);
+    bool putShort(const char* key, short value);
+    bool putUShort(const char* key, unsigned short value);
+    bool putInt(const char* key, int value);
+    bool putUInt(const char* key, unsigned int value);
+    bool putLong(const char* key, long value);
+    bool putULong(const char* key, unsigned long value);
+    bool putLong64(const char* key, long long value);
+    bool putULong64(const char* key, unsigned long long value);
+    bool putFloat(const char* key, float value);
+    bool putDouble(const char* key, double value);
+    bool putString(const char* key, const char* value);
+    bool putString(const char* key, const String& value);
+    bool putBytes(const char* key, const void* buf, size_t len);
+
+    /**
+     * @brief Store raw value bytes under an explicit type tag
+     * @see I2CMiniPrefs::putTyped()
+     */
+    bool putTyped(const char* key, PrefDataType type, const void* buf, size_t len);
+    ///@}
+
+    /// @name Data Read Operations
+    ///@{
+    bool getBool(const char* key, bool defaultValue = false);
+    char getChar(const char* key, char defaultValue = 0);
+    unsigned char getUChar(const char* key, unsigned char defaultValue = 0);
+    short getShort(const char* key, short defaultValue = 0);
+    unsigned short getUShort(const char* key, unsigned short defaultValue = 0);
+    int getInt(const char* key, int defaultValue = 0);
+    unsigned int getUInt(const char* key, unsigned int defaultValue = 0);
+    long getLong(const char* key, long defaultValue = 0);
+    unsigned long getULong(const char* key, unsigned long defaultValue = 0);
+    long long getLong64(const char* key, long long defaultValue = 0);
+    unsigned long long getULong64(const char* key, unsigned long long defaultValue = 0);
+    float getFloat(const char* key, float defaultValue = 0.0f);
+    double getDouble(const char* key, double defaultValue = 0.0);
+    String getString(const char* key, const char* defaultValue = "");
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+    ///@}
+
+    /// @name Utility Operations
+    ///@{
+    /**
+     * @brief Check if key exists in either tier
+     */
+    bool isKey(const char* key);
+
+    /**
+     * @brief Delete key from both tiers
+     * @return true if the key was found in either tier
+     */
+    bool remove(const char* key);
+
+    /**
+     * @brief Clear both tiers
+     * @return true if successful, false on error
+     */
+    bool clear();
+    ///@}
+
+private:
+    I2CMiniPrefs& _fast;         ///< FRAM tier
+    I2CMiniPrefs& _slow;         ///< EEPROM tier
+    uint32_t _merges;            ///< Completed merges
+#if PREFS_THREAD_SAFE
+    SemaphoreHandle_t _writeMutex; ///< Serializes readers and writers against merge()
+#endif
+
+    /// Tier holding the current value of key (call with the lock held)
+    I2CMiniPrefs& _tierOf(const char* key) { return _fast.isKey(key) ? _fast : _slow; }
+
+    bool _put(const char* key, PrefDataType type, const void* buf, size_t len);
+    bool _merge();
+    void _lock();
+    void _unlock();
+};